@@ -4,31 +4,108 @@
 
 /**
  * @file
- * Implementation of the fixed A matrix generation function.
+ * Implementation of the fixed A matrix generation function, and of the
+ * functions to store it in a file and to map it from one.
  */
 
+#define _POSIX_C_SOURCE 200112L
+
 #include "a_fixed.h"
 #include "a_random.h"
+#include "little_endian.h"
+#include "misc.h"
 
 #include <stdio.h>
 #include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
 #if PARAMS_TAU == 1
-modq_t A_fixed[PARAMS_D * 2 * PARAMS_K];
+
+#define A_FIXED_BYTES (A_FIXED_LEN * sizeof (modq_t))
+
+/** The matrix as created by create_A_fixed(). */
+static modq_t A_fixed_created[A_FIXED_LEN];
+
+modq_t *A_fixed = A_fixed_created;
+
+/** The seed of A_fixed, if known. */
+static unsigned char A_fixed_seed[PARAMS_KAPPA_BYTES];
+static int A_fixed_seeded = 0;
+
+/** The seed of A_fixed_created, restored when a file is unmapped. */
+static unsigned char A_fixed_created_seed[PARAMS_KAPPA_BYTES];
+static int A_fixed_created_seeded = 0;
+
+/** The file mapped by map_A_fixed(), if any. */
+static void *A_fixed_map = NULL;
+static size_t A_fixed_map_len = 0;
+
+// 64-bit FNV-1a over the little-endian 32-bit words of the matrix
+static uint64_t a_fixed_checksum(const unsigned char *data, size_t len) {
+    uint64_t h = 0xcbf29ce484222325U;
+    size_t i;
+
+    for (i = 0; i + 4 <= len; i += 4) {
+        h ^= u32_from_le(data + i);
+        h *= 0x100000001b3U;
+    }
+
+    return h;
+}
+
+static void a_fixed_header(unsigned char header[A_FIXED_HEADER_SIZE], const unsigned char *seed, uint64_t checksum) {
+    memset(header, 0, A_FIXED_HEADER_SIZE);
+    memcpy(header, "R5AFIXED", 8);
+    u32_to_le(header + 8, A_FIXED_FILE_VERSION);
+    u32_to_le(header + 12, A_FIXED_HEADER_SIZE);
+    strncpy((char *) header + 16, CRYPTO_ALGNAME, 31);
+    u32_to_le(header + 48, PARAMS_D);
+    u32_to_le(header + 52, PARAMS_K);
+    u32_to_le(header + 56, PARAMS_Q_BITS);
+    u32_to_le(header + 60, PARAMS_KAPPA_BYTES);
+    memcpy(header + 64, seed, PARAMS_KAPPA_BYTES);
+    u64_to_le(header + 96, A_FIXED_BYTES);
+    u64_to_le(header + 104, checksum);
+}
+
 #endif
 
-int create_A_fixed(const unsigned char *seed) {
+int create_A_fixed_matrix(modq_t *A, const unsigned char *seed) {
 #if PARAMS_TAU == 1
-    /* Create A_fixed randomly */
-    create_A_random(A_fixed, seed);
+    /* Create A randomly */
+    create_A_random(A, seed);
 
     /* Duplicate rows */
     for (int i = PARAMS_K - 1; i >= 0; --i) {
-        memcpy(A_fixed + (2 * i + 1) * PARAMS_D, A_fixed + i*PARAMS_D, PARAMS_D * sizeof (modq_t));
+        memcpy(A + (2 * i + 1) * PARAMS_D, A + i*PARAMS_D, PARAMS_D * sizeof (modq_t));
         if (i != 0) {
-            memcpy(A_fixed + (2 * i) * PARAMS_D, A_fixed + i*PARAMS_D, PARAMS_D * sizeof (modq_t));
+            memcpy(A + (2 * i) * PARAMS_D, A + i*PARAMS_D, PARAMS_D * sizeof (modq_t));
         }
     }
+
+    return 0;
+#else
+    (void) A;
+    (void) seed;
+    DEBUG_ERROR("Can not call create_A_fixed_matrix with PARAMS_TAU=%d\n", PARAMS_TAU);
+    return -1;
+#endif
+}
+
+int create_A_fixed(const unsigned char *seed) {
+#if PARAMS_TAU == 1
+    unmap_A_fixed();
+
+    /* Create A_fixed randomly */
+    create_A_fixed_matrix(A_fixed, seed);
+
+    memcpy(A_fixed_seed, seed, PARAMS_KAPPA_BYTES);
+    A_fixed_seeded = 1;
+    memcpy(A_fixed_created_seed, seed, PARAMS_KAPPA_BYTES);
+    A_fixed_created_seeded = 1;
     return 0;
 #else
     (void) seed;
@@ -36,3 +113,129 @@ int create_A_fixed(const unsigned char *seed) {
     abort();
 #endif
 }
+
+int store_A_fixed(const char *path) {
+#if PARAMS_TAU == 1
+    unsigned char header[A_FIXED_HEADER_SIZE];
+    unsigned char data[2 * 1024];
+    size_t i, j, n;
+    uint64_t h = 0xcbf29ce484222325U;
+    FILE *f;
+
+    if (!A_fixed_seeded) {
+        DEBUG_ERROR("store_A_fixed: no A_fixed created\n");
+        return -1;
+    }
+    if ((f = fopen(path, "wb")) == NULL) {
+        DEBUG_ERROR("store_A_fixed: can not open %s\n", path);
+        return -1;
+    }
+
+    // the header is written last, with the checksum
+    if (fseek(f, A_FIXED_HEADER_SIZE, SEEK_SET) != 0) {
+        fclose(f);
+        return -1;
+    }
+    for (i = 0; i < A_FIXED_LEN; i += n) {
+        n = A_FIXED_LEN - i < sizeof (data) / 2 ? A_FIXED_LEN - i : sizeof (data) / 2;
+        for (j = 0; j < n; j++) {
+            u16_to_le(data + 2 * j, A_fixed[i + j]);
+        }
+        for (j = 0; j + 4 <= 2 * n; j += 4) {
+            h ^= u32_from_le(data + j);
+            h *= 0x100000001b3U;
+        }
+        if (fwrite(data, 2, n, f) != n) {
+            fclose(f);
+            return -1;
+        }
+    }
+
+    a_fixed_header(header, A_fixed_seed, h);
+    if (fseek(f, 0, SEEK_SET) != 0 || fwrite(header, 1, A_FIXED_HEADER_SIZE, f) != A_FIXED_HEADER_SIZE) {
+        fclose(f);
+        return -1;
+    }
+
+    return fclose(f) == 0 ? 0 : -1;
+#else
+    (void) path;
+    DEBUG_ERROR("Can not call store_A_fixed with PARAMS_TAU=%d\n", PARAMS_TAU);
+    return -1;
+#endif
+}
+
+int map_A_fixed(const char *path, int verify) {
+#if PARAMS_TAU == 1
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+    // the matrix is used as it is stored, which needs a little-endian machine
+    (void) path;
+    (void) verify;
+    DEBUG_ERROR("map_A_fixed: not supported on big-endian machines\n");
+    return -1;
+#else
+    unsigned char expected[A_FIXED_HEADER_SIZE];
+    const unsigned char *header;
+    struct stat st;
+    size_t len = A_FIXED_HEADER_SIZE + A_FIXED_BYTES;
+    void *map;
+    int fd;
+
+    if ((fd = open(path, O_RDONLY)) == -1) {
+        DEBUG_ERROR("map_A_fixed: can not open %s\n", path);
+        return -1;
+    }
+    if (fstat(fd, &st) != 0 || (size_t) st.st_size != len) {
+        DEBUG_ERROR("map_A_fixed: %s does not have the size of an A_fixed file for %s\n", path, CRYPTO_ALGNAME);
+        close(fd);
+        return -1;
+    }
+    map = mmap(NULL, len, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        DEBUG_ERROR("map_A_fixed: can not map %s\n", path);
+        return -1;
+    }
+
+    // all of the header but the seed and the checksum is known
+    header = map;
+    a_fixed_header(expected, header + 64, u64_from_le(header + 104));
+    if (memcmp(header, expected, A_FIXED_HEADER_SIZE) != 0) {
+        DEBUG_ERROR("map_A_fixed: %s is not an A_fixed file (version %d) for %s\n", path, A_FIXED_FILE_VERSION, CRYPTO_ALGNAME);
+        munmap(map, len);
+        return -1;
+    }
+    if (verify && a_fixed_checksum(header + A_FIXED_HEADER_SIZE, A_FIXED_BYTES) != u64_from_le(header + 104)) {
+        DEBUG_ERROR("map_A_fixed: checksum of %s does not match\n", path);
+        munmap(map, len);
+        return -1;
+    }
+
+    unmap_A_fixed();
+    A_fixed_map = map;
+    A_fixed_map_len = len;
+    A_fixed = (modq_t *) ((unsigned char *) map + A_FIXED_HEADER_SIZE);
+    memcpy(A_fixed_seed, header + 64, PARAMS_KAPPA_BYTES);
+    A_fixed_seeded = 1;
+
+    return 0;
+#endif
+#else
+    (void) path;
+    (void) verify;
+    DEBUG_ERROR("Can not call map_A_fixed with PARAMS_TAU=%d\n", PARAMS_TAU);
+    return -1;
+#endif
+}
+
+void unmap_A_fixed(void) {
+#if PARAMS_TAU == 1
+    if (A_fixed_map != NULL) {
+        munmap(A_fixed_map, A_fixed_map_len);
+        A_fixed_map = NULL;
+        A_fixed = A_fixed_created;
+        memcpy(A_fixed_seed, A_fixed_created_seed, PARAMS_KAPPA_BYTES);
+        A_fixed_seeded = A_fixed_created_seeded;
+    }
+#endif
+}
@@ -13,13 +13,41 @@
 #include "r5_parameter_sets.h"
 
 #if PARAMS_TAU == 1
+/** The number of elements of an A_fixed matrix (rows duplicated). */
+#define A_FIXED_LEN (PARAMS_D * 2 * PARAMS_K)
+
 /**
- * The fixed A matrix for use inside with the non-ring algorithm when τ=1.
- * This matrix is generated by `create_A_fixed()`.
+ * The fixed A matrix for use inside with the non-ring algorithm when τ=1
+ * (`PARAMS_D * 2 * PARAMS_K` elements). It is generated by
+ * `create_A_fixed()` or mapped from a file by `map_A_fixed()`.
  */
-extern modq_t A_fixed[PARAMS_D * 2 * PARAMS_K];
+extern modq_t *A_fixed;
 #endif
 
+/**
+ * The version of the A_fixed file format. A file starts with a header of
+ * `A_FIXED_HEADER_SIZE` bytes, all numbers little-endian:
+ *
+ *   offset  size
+ *        0     8  magic "R5AFIXED"
+ *        8     4  version
+ *       12     4  header size
+ *       16    32  parameter set name (CRYPTO_ALGNAME), zero padded
+ *       48     4  d
+ *       52     4  k
+ *       56     4  q_bits
+ *       60     4  kappa_bytes
+ *       64    32  seed, zero padded
+ *       96     8  size of the matrix in bytes
+ *      104     8  checksum of the matrix (64-bit FNV-1a over 32-bit words)
+ *      112    16  zero
+ *
+ * followed by A_fixed as it is used (rows duplicated), as little-endian
+ * 16-bit elements.
+ */
+#define A_FIXED_FILE_VERSION 1
+#define A_FIXED_HEADER_SIZE 128
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -32,6 +60,46 @@ extern "C" {
      */
     int create_A_fixed(const unsigned char *seed);
 
+    /**
+     * Generates a fixed A matrix from the given seed into the given memory,
+     * without touching the global A_fixed (see r5_ctx_set_A_fixed()).
+     *
+     * @param[out] A    the matrix (`A_FIXED_LEN` elements)
+     * @param[in]  seed the seed to use to generate the fixed A matrix (KAPPA_BYTES bytes)
+     * @return __0__ in case of success
+     */
+    int create_A_fixed_matrix(modq_t *A, const unsigned char *seed);
+
+    /**
+     * Writes the A_fixed matrix created by `create_A_fixed()` to a file,
+     * with the seed it was created from.
+     *
+     * @param[in] path the file to write
+     * @return __0__ in case of success, __-1__ otherwise
+     */
+    int store_A_fixed(const char *path);
+
+    /**
+     * Maps an A_fixed file read-only and shared, and uses it as A_fixed.
+     * Processes that map the same file share a single copy of the matrix.
+     * The header must match the parameter set. Checking the checksum reads
+     * the whole matrix, so it is optional.
+     *
+     * @param[in] path   the file written by `store_A_fixed()`
+     * @param[in] verify whether to check the checksum of the matrix
+     * @return __0__ in case of success, __-1__ otherwise (A_fixed is then
+     *         unchanged)
+     */
+    int map_A_fixed(const char *path, int verify);
+
+    /**
+     * Unmaps the file mapped by `map_A_fixed()`. A_fixed then points to the
+     * matrix of `create_A_fixed()` again, which `store_A_fixed()` can still
+     * write with its seed. Public keys prepared with the
+     * mapped matrix (see crypto_kem_prepare_pk()) must be prepared again.
+     */
+    void unmap_A_fixed(void);
+
 #ifdef __cplusplus
 }
 #endif
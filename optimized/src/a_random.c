@@ -12,164 +12,171 @@
 #include "misc.h"
 #include "little_endian.h"
 #include "drbg.h"
+#include "r5_parallel.h"
 
 #if (defined(AVX2) && defined(STANDALONE) )
 #define AVX2SHAKE_A_GEN
 #endif
 
-void create_A_random(modq_t *A_random, const unsigned char *seed) {
-    
-    uint8_t c0, c1, c2, c3;
-    c0 = 0 ; c1= 1; c2=2; c3=3;
-    const uint8_t domain[4] = "AGEN";
-    
-    if (PARAMS_TAU == 2) {
-        
-#ifndef AVX2SHAKE_A_GEN
-        AGeneration(&A_random[c0 * ((PARAMS_TAU2_LEN+NBLOCKS-1)/NBLOCKS) ], (PARAMS_TAU2_LEN+NBLOCKS-1)/NBLOCKS, domain, seed, &c0);
-        AGeneration(&A_random[c1 * ((PARAMS_TAU2_LEN+NBLOCKS-1)/NBLOCKS) ], (PARAMS_TAU2_LEN+NBLOCKS-1)/NBLOCKS, domain, seed, &c1);
-        AGeneration(&A_random[c2 * ((PARAMS_TAU2_LEN+NBLOCKS-1)/NBLOCKS) ], (PARAMS_TAU2_LEN+NBLOCKS-1)/NBLOCKS, domain, seed, &c2);
-        AGeneration(&A_random[c3 * ((PARAMS_TAU2_LEN+NBLOCKS-1)/NBLOCKS) ], (PARAMS_TAU2_LEN+NBLOCKS-1)/NBLOCKS, domain, seed, &c3);
-            
-#if (NBLOCKS > 4)
-        c0 = 4 ; c1= 5; c2=6; c3=7;
-        
-        AGeneration(&A_random[c0 * ((PARAMS_TAU2_LEN+NBLOCKS-1)/NBLOCKS) ], (PARAMS_TAU2_LEN+NBLOCKS-1)/NBLOCKS, domain, seed, &c0);
-        AGeneration(&A_random[c1 * ((PARAMS_TAU2_LEN+NBLOCKS-1)/NBLOCKS) ], (PARAMS_TAU2_LEN+NBLOCKS-1)/NBLOCKS, domain, seed, &c1);
-        AGeneration(&A_random[c2 * ((PARAMS_TAU2_LEN+NBLOCKS-1)/NBLOCKS) ], (PARAMS_TAU2_LEN+NBLOCKS-1)/NBLOCKS, domain, seed, &c2);
-        AGeneration(&A_random[c3 * ((PARAMS_TAU2_LEN+NBLOCKS-1)/NBLOCKS) ], (PARAMS_TAU2_LEN+NBLOCKS-1)/NBLOCKS, domain, seed, &c3);
+// the length of each of the NBLOCKS blocks
+#if PARAMS_TAU == 2
+#define A_BLOCK_LEN ((PARAMS_TAU2_LEN+NBLOCKS-1)/NBLOCKS)
+#elif PARAMS_K == 1
+#define A_BLOCK_LEN ((PARAMS_D+NBLOCKS-1)/NBLOCKS)
+#else
+#define A_BLOCK_LEN (((PARAMS_K+NBLOCKS-1)/NBLOCKS) * PARAMS_D)
 #endif
-        
+
+// The blocks are spread over threads for the non-ring A of τ=0 and τ=1 only:
+// the A of a ring variant, and the vector of τ=2, is generated in less time
+// than it takes to hand it to the threads.
+#if defined(THREADS) && THREADS > 1 && PARAMS_K != 1 && PARAMS_TAU != 2
+
+// the blocks of a task: four with AVX2, to fill the lanes (so A is generated
+// on at most NBLOCKS / 4 threads; four blocks on one thread take less time
+// than one block each on four)
+#ifdef AVX2SHAKE_A_GEN
+#define A_TASK_BLOCKS 4
 #else
-      
-        AGeneration4x(  &A_random[c0 * ((PARAMS_TAU2_LEN+NBLOCKS-1)/NBLOCKS) ],
-                        &A_random[c1 * ((PARAMS_TAU2_LEN+NBLOCKS-1)/NBLOCKS) ],
-                        &A_random[c2 * ((PARAMS_TAU2_LEN+NBLOCKS-1)/NBLOCKS) ],
-                        &A_random[c3 * ((PARAMS_TAU2_LEN+NBLOCKS-1)/NBLOCKS) ],
-                        ((PARAMS_TAU2_LEN+NBLOCKS-1)/NBLOCKS),
-                        domain,
-                        seed,
-                        &c0,
-                        &c1,
-                        &c2,
-                        &c3);
-        
-#if NBLOCKS > 4
-        
-        c0 = 4 ; c1= 5; c2=6; c3=7;
-        AGeneration4x(   &A_random[c0 * ((PARAMS_TAU2_LEN+NBLOCKS-1)/NBLOCKS) ],
-                        &A_random[c1 * ((PARAMS_TAU2_LEN+NBLOCKS-1)/NBLOCKS) ],
-                        &A_random[c2 * ((PARAMS_TAU2_LEN+NBLOCKS-1)/NBLOCKS) ],
-                        &A_random[c3 * ((PARAMS_TAU2_LEN+NBLOCKS-1)/NBLOCKS) ],
-                        ((PARAMS_TAU2_LEN+NBLOCKS-1)/NBLOCKS),
-                        domain,
-                        seed,
-                        &c0,
-                        &c1,
-                        &c2,
-                        &c3);
+#define A_TASK_BLOCKS 1
 #endif
-        
+
+typedef struct {
+    modq_t *A_random;
+    const unsigned char *seed;
+#ifdef AGenerationJob
+    const tupleHash_Snapshot *prefix;
 #endif
-        
-        
-    } else {
-        
-#ifndef AVX2SHAKE_A_GEN
-        
-        if (PARAMS_K == 1){ // RING
-            AGeneration(&A_random[c0 * ((PARAMS_D+NBLOCKS-1)/NBLOCKS) ], (PARAMS_D+NBLOCKS-1)/NBLOCKS, domain, seed, &c0);
-            AGeneration(&A_random[c1 * ((PARAMS_D+NBLOCKS-1)/NBLOCKS) ], (PARAMS_D+NBLOCKS-1)/NBLOCKS, domain, seed, &c1);
-            AGeneration(&A_random[c2 * ((PARAMS_D+NBLOCKS-1)/NBLOCKS) ], (PARAMS_D+NBLOCKS-1)/NBLOCKS, domain, seed, &c2);
-            AGeneration(&A_random[c3 * ((PARAMS_D+NBLOCKS-1)/NBLOCKS) ], (PARAMS_D+NBLOCKS-1)/NBLOCKS, domain, seed, &c3);
-
-#if (NBLOCKS > 4)
-            c0 = 4 ; c1= 5; c2=6; c3=7;
-            
-            AGeneration(&A_random[c0 * ((PARAMS_D+NBLOCKS-1)/NBLOCKS) ], (PARAMS_D+NBLOCKS-1)/NBLOCKS, domain, seed, &c0);
-            AGeneration(&A_random[c1 * ((PARAMS_D+NBLOCKS-1)/NBLOCKS) ], (PARAMS_D+NBLOCKS-1)/NBLOCKS, domain, seed, &c1);
-            AGeneration(&A_random[c2 * ((PARAMS_D+NBLOCKS-1)/NBLOCKS) ], (PARAMS_D+NBLOCKS-1)/NBLOCKS, domain, seed, &c2);
-            AGeneration(&A_random[c3 * ((PARAMS_D+NBLOCKS-1)/NBLOCKS) ], (PARAMS_D+NBLOCKS-1)/NBLOCKS, domain, seed, &c3);
+} a_random_job;
 
+// generates blocks A_TASK_BLOCKS * i .. A_TASK_BLOCKS * (i + 1) - 1
+static void create_A_random_task(void *arg, size_t i) {
+    const a_random_job *job = arg;
+    const uint8_t domain[4] = "AGEN";
+    uint8_t c[A_TASK_BLOCKS];
+    size_t b;
+#ifdef AGenerationJob
+    tupleHash16_Job jobs[A_TASK_BLOCKS];
+
+    for (b = 0; b < A_TASK_BLOCKS; b++) {
+        c[b] = (uint8_t) (A_TASK_BLOCKS * i + b);
+        jobs[b] = AGenerationJob(&job->A_random[c[b] * A_BLOCK_LEN], A_BLOCK_LEN, domain, job->seed, &c[b], job->prefix);
+    }
+    AGenerationJobs(jobs, A_TASK_BLOCKS);
+#else
+    for (b = 0; b < A_TASK_BLOCKS; b++) {
+        c[b] = (uint8_t) (A_TASK_BLOCKS * i + b);
+        AGeneration(&job->A_random[c[b] * A_BLOCK_LEN], A_BLOCK_LEN, domain, job->seed, &c[b]);
+    }
 #endif
-        } else { // NON_RING
-            AGeneration(&A_random[c0 * ((PARAMS_K+NBLOCKS-1)/NBLOCKS) * PARAMS_D ], ((PARAMS_K+NBLOCKS-1)/NBLOCKS) * PARAMS_D, domain, seed, &c0);
-            AGeneration(&A_random[c1 * ((PARAMS_K+NBLOCKS-1)/NBLOCKS) * PARAMS_D ], ((PARAMS_K+NBLOCKS-1)/NBLOCKS) * PARAMS_D, domain, seed, &c1);
-            AGeneration(&A_random[c2 * ((PARAMS_K+NBLOCKS-1)/NBLOCKS) * PARAMS_D ], ((PARAMS_K+NBLOCKS-1)/NBLOCKS) * PARAMS_D, domain, seed, &c2);
-            AGeneration(&A_random[c3 * ((PARAMS_K+NBLOCKS-1)/NBLOCKS) * PARAMS_D ], ((PARAMS_K+NBLOCKS-1)/NBLOCKS) * PARAMS_D, domain, seed, &c3);
-
-#if (NBLOCKS > 4)
-            c0 = 4 ; c1= 5; c2=6; c3=7;
-            AGeneration(&A_random[c0 * ((PARAMS_K+NBLOCKS-1)/NBLOCKS) * PARAMS_D ], ((PARAMS_K+NBLOCKS-1)/NBLOCKS) * PARAMS_D, domain, seed, &c0);
-            AGeneration(&A_random[c1 * ((PARAMS_K+NBLOCKS-1)/NBLOCKS) * PARAMS_D ], ((PARAMS_K+NBLOCKS-1)/NBLOCKS) * PARAMS_D, domain, seed, &c1);
-            AGeneration(&A_random[c2 * ((PARAMS_K+NBLOCKS-1)/NBLOCKS) * PARAMS_D ], ((PARAMS_K+NBLOCKS-1)/NBLOCKS) * PARAMS_D, domain, seed, &c2);
-            AGeneration(&A_random[c3 * ((PARAMS_K+NBLOCKS-1)/NBLOCKS) * PARAMS_D ], ((PARAMS_K+NBLOCKS-1)/NBLOCKS) * PARAMS_D, domain, seed, &c3);
+}
 
+// the blocks are independent streams, so they can be generated in any order
+void create_A_random(modq_t *A_random, const unsigned char *seed) {
+    a_random_job job;
+#ifdef AGenerationJob
+    const uint8_t domain[4] = "AGEN";
+    tupleHash_Snapshot prefix;
+
+    AGenerationPrefix(&prefix, domain, seed);
+    job.prefix = &prefix;
 #endif
-        }
+
+    job.A_random = A_random;
+    job.seed = seed;
+    r5_parallel_for(NBLOCKS / A_TASK_BLOCKS, create_A_random_task, &job);
+}
+
 #else
 
-        if (PARAMS_K == 1){ // RING
-            AGeneration4x(   &A_random[c0 * ((PARAMS_D+NBLOCKS-1)/NBLOCKS) ],
-                               &A_random[c1 * ((PARAMS_D+NBLOCKS-1)/NBLOCKS) ],
-                               &A_random[c2 * ((PARAMS_D+NBLOCKS-1)/NBLOCKS) ],
-                               &A_random[c3 * ((PARAMS_D+NBLOCKS-1)/NBLOCKS) ],
-                               ((PARAMS_D+NBLOCKS-1)/NBLOCKS),
-                               domain,
-                               seed,
-                               &c0,
-                               &c1,
-                               &c2,
-                               &c3);
-
-#if NBLOCKS > 4
-            
-            c0 = 4 ; c1= 5; c2=6; c3=7;
-            AGeneration4x(   &A_random[c0 * ((PARAMS_D+NBLOCKS-1)/NBLOCKS) ],
-                               &A_random[c1 * ((PARAMS_D+NBLOCKS-1)/NBLOCKS) ],
-                               &A_random[c2 * ((PARAMS_D+NBLOCKS-1)/NBLOCKS) ],
-                               &A_random[c3 * ((PARAMS_D+NBLOCKS-1)/NBLOCKS) ],
-                               ((PARAMS_D+NBLOCKS-1)/NBLOCKS),
-                               domain,
-                               seed,
-                               &c0,
-                               &c1,
-                               &c2,
-                               &c3);
+// the blocks are independent streams, run four at a time with AVX2; the
+// domain and the seed they share are absorbed once
+void create_A_random(modq_t *A_random, const unsigned char *seed) {
+    const uint8_t domain[4] = "AGEN";
+    uint8_t c[NBLOCKS];
+    size_t i;
 
+#ifdef AGenerationJob
+    tupleHash16_Job jobs[NBLOCKS];
+    tupleHash_Snapshot prefix;
+
+    AGenerationPrefix(&prefix, domain, seed);
+    for (i = 0; i < NBLOCKS; i++) {
+        c[i] = (uint8_t) i;
+        jobs[i] = AGenerationJob(&A_random[i * A_BLOCK_LEN], A_BLOCK_LEN, domain, seed, &c[i], &prefix);
+    }
+    AGenerationJobs(jobs, NBLOCKS);
+#else
+    for (i = 0; i < NBLOCKS; i++) {
+        c[i] = (uint8_t) i;
+        AGeneration(&A_random[i * A_BLOCK_LEN], A_BLOCK_LEN, domain, seed, &c[i]);
+    }
 #endif
-            
-        } else { // NON_RING
-            AGeneration4x(     &A_random[c0 * ((PARAMS_K+NBLOCKS-1)/NBLOCKS) * PARAMS_D],
-                               &A_random[c1 * ((PARAMS_K+NBLOCKS-1)/NBLOCKS) * PARAMS_D],
-                               &A_random[c2 * ((PARAMS_K+NBLOCKS-1)/NBLOCKS) * PARAMS_D],
-                               &A_random[c3 * ((PARAMS_K+NBLOCKS-1)/NBLOCKS) * PARAMS_D],
-                               ((PARAMS_K+NBLOCKS-1)/NBLOCKS) * PARAMS_D,
-                               domain,
-                               seed,
-                               &c0,
-                               &c1,
-                               &c2,
-                               &c3);
-
-#if NBLOCKS > 4
-            c0 = 4 ; c1= 5; c2=6; c3=7;
-            AGeneration4x(     &A_random[c0 * ((PARAMS_K+NBLOCKS-1)/NBLOCKS) * PARAMS_D],
-                               &A_random[c1 * ((PARAMS_K+NBLOCKS-1)/NBLOCKS) * PARAMS_D],
-                               &A_random[c2 * ((PARAMS_K+NBLOCKS-1)/NBLOCKS) * PARAMS_D],
-                               &A_random[c3 * ((PARAMS_K+NBLOCKS-1)/NBLOCKS) * PARAMS_D],
-                               ((PARAMS_K+NBLOCKS-1)/NBLOCKS) * PARAMS_D,
-                               domain,
-                               seed,
-                               &c0,
-                               &c1,
-                               &c2,
-                               &c3);
-            
+}
+
 #endif
-        
 
+#ifdef A_RANDOM_STREAM
+
+#define A_ROWS_PER_BLOCK ((PARAMS_K+NBLOCKS-1)/NBLOCKS)
+
+void a_random_stream_init(a_random_stream *stream, const unsigned char *seed) {
+    stream->seed = seed;
+    stream->block = 0;
+    stream->row = 0;
+    stream->nrows = 0;
+    stream->lane = A_STREAM_LANES;
+}
+
+size_t a_random_stream_next(a_random_stream *stream, const modq_t (**rows)[PARAMS_D], size_t *row0) {
+
+    const uint8_t domain[4] = "AGEN";
+    size_t lane, n;
+
+    for (;;) {
+        // hand out the rows squeezed, leaving out those past d in the last block
+        while (stream->lane < A_STREAM_LANES) {
+            lane = stream->lane++;
+            *row0 = (stream->block + lane) * A_ROWS_PER_BLOCK + stream->row - stream->nrows;
+            if (*row0 < PARAMS_D) {
+                n = PARAMS_D - *row0 < stream->nrows ? PARAMS_D - *row0 : stream->nrows;
+                *rows = (const modq_t (*)[PARAMS_D]) stream->rows[lane];
+                return n;
+            }
         }
+
+        if (stream->row == A_ROWS_PER_BLOCK) {
+            stream->block += A_STREAM_LANES;
+            stream->row = 0;
+        }
+        if (stream->block >= NBLOCKS) {
+            return 0;
+        }
+
+        // the streams are those of AGeneration(), with the output length of
+        // a whole block
+        if (stream->row == 0) {
+#if A_STREAM_LANES == 4
+            uint8_t c0 = (uint8_t) stream->block, c1 = (uint8_t) (c0 + 1), c2 = (uint8_t) (c0 + 2), c3 = (uint8_t) (c0 + 3);
+            r5_tuple_hash_input_4x(&stream->thcontext, domain, domain, domain, domain, 4,
+                                   stream->seed, stream->seed, stream->seed, stream->seed, PARAMS_KAPPA_BYTES,
+                                   &c0, &c1, &c2, &c3, 1, 3, 2 * A_ROWS_PER_BLOCK * PARAMS_D Params);
+#else
+            uint8_t c = (uint8_t) stream->block;
+            r5_tuple_hash_input(&stream->thcontext, domain, 4, stream->seed, PARAMS_KAPPA_BYTES, &c, 1, 3, 2 * A_ROWS_PER_BLOCK * PARAMS_D Params);
 #endif
+        }
+
+        stream->nrows = A_ROWS_PER_BLOCK - stream->row < A_STREAM_ROWS ? A_ROWS_PER_BLOCK - stream->row : A_STREAM_ROWS;
+#if A_STREAM_LANES == 4
+        r5_tuple_hash_xof_squeeze16_4x(&stream->rows[0][0][0], &stream->rows[1][0][0], &stream->rows[2][0][0], &stream->rows[3][0][0],
+                                       (uint32_t) (stream->nrows * PARAMS_D), &stream->thcontext Params);
+#else
+        r5_tuple_hash_xof_squeeze16(&stream->rows[0][0][0], (uint32_t) (stream->nrows * PARAMS_D), &stream->thcontext Params);
+#endif
+        stream->row += stream->nrows;
+        stream->lane = 0;
     }
 }
+
+#endif
@@ -12,6 +12,45 @@
 
 #include "r5_parameter_sets.h"
 
+/*
+ * With A_STREAM, the d x d matrix A of the non-ring tau 0 variants is not
+ * created as a whole: its rows are squeezed from the NBLOCKS generation
+ * streams a few at a time (A_STREAM_ROWS), and used before the next ones
+ * are. The rows are the same as those of create_A_random(). Squeezing part
+ * of a TupleHash output needs the STANDALONE hash; with AES the matrix is
+ * created as a whole.
+ */
+#if defined(A_STREAM) && PARAMS_K != 1 && PARAMS_TAU == 0 && defined(STANDALONE) && !defined(USE_AES_DRBG)
+#define A_RANDOM_STREAM
+#endif
+
+#ifdef A_RANDOM_STREAM
+
+#include "f202sp800185.h"
+
+#ifndef A_STREAM_ROWS
+#define A_STREAM_ROWS 4
+#endif
+
+// streams squeezed side by side
+#ifdef AVX2
+#define A_STREAM_LANES 4
+#else
+#define A_STREAM_LANES 1
+#endif
+
+typedef struct {
+    ttupleHash_Instance thcontext;  // the streams of the current blocks
+    modq_t rows[A_STREAM_LANES][A_STREAM_ROWS][PARAMS_D];
+    const unsigned char *seed;
+    size_t block;                   // first block of the current streams
+    size_t row;                     // rows of the blocks squeezed so far
+    size_t nrows;                   // rows in each lane of rows
+    size_t lane;                    // next lane of rows to hand out
+} a_random_stream;
+
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -24,6 +63,28 @@ extern "C" {
      */
     void create_A_random(modq_t *A_random, const unsigned char *seed);
 
+#ifdef A_RANDOM_STREAM
+    /**
+     * Starts streaming the rows of A random for the given seed.
+     *
+     * @param[out] stream       the stream
+     * @param[in]  seed         the seed (PARAMS_KAPPA_BYTES bytes), kept
+     *                          until the last rows are taken
+     */
+    void a_random_stream_init(a_random_stream *stream, const unsigned char *seed);
+
+    /**
+     * Takes the next rows of A random. All d rows are handed out once, not
+     * in order.
+     *
+     * @param[in]  stream       the stream
+     * @param[out] rows         the rows, valid until the next call
+     * @param[out] row0         the index in A of the first row
+     * @return the number of rows, __0__ when all have been taken
+     */
+    size_t a_random_stream_next(a_random_stream *stream, const modq_t (**rows)[PARAMS_D], size_t *row0);
+#endif
+
 #ifdef __cplusplus
 }
 #endif
@@ -5,8 +5,9 @@
 /**
  * @file
  * Application to generate an A_fixed matrix using the parameters as set.
- * The output of the application can be used to set up the fixed A matrix in
- * the file `a_fixed.h`.
+ * Without arguments, it outputs the matrix as a C initializer. With a file
+ * name, it stores the matrix in that file, which map_A_fixed() can map
+ * (see `a_fixed.h`).
  */
 
 #include "r5_parameter_sets.h"
@@ -21,11 +22,14 @@
 #include <stddef.h>
 
 /**
- * Outputs the definition of a fixed A matrix based on the API parameter as set.
+ * Outputs the definition of a fixed A matrix based on the API parameter as set,
+ * or stores it in the file given as argument.
  *
+ * @param[in] argc the number of arguments
+ * @param[in] argv the arguments, optionally the file to store A_fixed in
  * @return __0__ in case of success
  */
-int main(void) {
+int main(int argc, char **argv) {
     /* Initialize random bytes RNG */
     unsigned char entropy_input[48];
     int i;
@@ -38,6 +42,14 @@ int main(void) {
     randombytes(seed, PARAMS_KAPPA_BYTES);
     create_A_fixed(seed);
 
+    if (argc > 1) {
+        if (store_A_fixed(argv[1]) != 0) {
+            fprintf(stderr, "Could not store A_fixed in %s\n", argv[1]);
+            return 1;
+        }
+        return 0;
+    }
+
     printf("/* A_fixed for %s */\n\n", CRYPTO_ALGNAME);
     printf("/* Seed used for the generation of A_fixed: ");
     print_hex(NULL, seed, PARAMS_KAPPA_BYTES, 1);
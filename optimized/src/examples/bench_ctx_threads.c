@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2020, Koninklijke Philips N.V.
+ */
+
+/**
+ * @file
+ * Scaling benchmark of the `_ctx` functions of the KEM: 1, 2, 4, ... up to
+ * the given number of threads (the number of online CPUs by default) each
+ * run key generation, encapsulation and de-capsulation with a context of
+ * their own. It prints the throughput (key exchanges per second), the
+ * speedup over one thread, which is linear up to the number of cores when
+ * the threads share no state, and the CPU time of an exchange. The CPU
+ * time stays the same as threads are added when they do not contend, also
+ * with more threads than cores (where the speedup cannot grow).
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "kem.h"
+#include "r5_ctx.h"
+#include "r5_memory.h"
+#if PARAMS_TAU == 1
+#include "a_fixed.h"
+#endif
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(TIMING) && (TIMING > 1)
+#define NUMRUNS TIMING
+#else
+#define NUMRUNS 200
+#endif
+
+/** The work of a thread. */
+typedef struct {
+    pthread_t thread;
+    int index;
+    const uint16_t *A_fixed;
+    int failures;
+    double cpu_time;
+} worker;
+
+static double thread_cpu_time(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &t);
+    return (double) t.tv_sec + (double) t.tv_nsec * 1e-9;
+}
+
+static void *worker_run(void *arg) {
+    worker *w = arg;
+    unsigned char entropy_input[48];
+    unsigned char pk[CRYPTO_PUBLICKEYBYTES], sk[CRYPTO_SECRETKEYBYTES];
+    unsigned char ct[CRYPTO_CIPHERTEXTBYTES], k_enc[CRYPTO_BYTES], k_dec[CRYPTO_BYTES];
+    r5_ctx ctx;
+    int i;
+
+    for (i = 0; i < 48; i++) {
+        entropy_input[i] = (unsigned char) (i + w->index);
+    }
+    r5_ctx_init(&ctx, entropy_input, NULL);
+    r5_ctx_set_A_fixed(&ctx, w->A_fixed);
+
+    w->cpu_time = thread_cpu_time();
+    for (i = 0; i < NUMRUNS; i++) {
+        if (crypto_kem_keypair_ctx(&ctx, pk, sk) != 0
+                || crypto_kem_enc_ctx(&ctx, ct, k_enc, pk) != 0
+                || crypto_kem_dec_ctx(&ctx, k_dec, ct, sk) != 0
+                || memcmp(k_enc, k_dec, CRYPTO_BYTES) != 0) {
+            w->failures++;
+        }
+    }
+    w->cpu_time = thread_cpu_time() - w->cpu_time;
+
+    r5_ctx_clear(&ctx);
+
+    return NULL;
+}
+
+static double now(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double) t.tv_sec + (double) t.tv_nsec * 1e-9;
+}
+
+/**
+ * Main program, runs the benchmark.
+ *
+ * @param[in] argc the number of arguments
+ * @param[in] argv optionally the maximum number of threads
+ * @return __0__ in case of success
+ */
+int main(int argc, char **argv) {
+    const long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    long max_threads = argc > 1 ? atol(argv[1]) : cpus;
+    const uint16_t *A = NULL;
+    double elapsed, cpu_time, rate, rate_1 = 0;
+    worker *workers;
+    int failures = 0;
+    long n, i;
+
+    if (max_threads < 1) {
+        max_threads = 1;
+    }
+
+#if PARAMS_TAU == 1
+    /* One A_fixed, only read by the threads */
+    unsigned char seed[PARAMS_KAPPA_BYTES] = {0};
+    modq_t *A_fixed_matrix = checked_malloc(A_FIXED_LEN * sizeof (modq_t));
+    create_A_fixed_matrix(A_fixed_matrix, seed);
+    A = A_fixed_matrix;
+#endif
+
+    workers = checked_malloc((size_t) max_threads * sizeof (worker));
+
+    printf("%s, %d key exchanges per thread, %ld CPUs online\n", CRYPTO_ALGNAME, NUMRUNS, cpus);
+    printf("%8s %14s %9s %17s\n", "threads", "exchanges/s", "speedup", "CPU us/exchange");
+    for (n = 1; ; n = n * 2 < max_threads ? n * 2 : max_threads) {
+        elapsed = now();
+        for (i = 0; i < n; i++) {
+            workers[i].index = (int) i;
+            workers[i].A_fixed = A;
+            workers[i].failures = 0;
+            workers[i].cpu_time = 0;
+            if (pthread_create(&workers[i].thread, NULL, worker_run, &workers[i]) != 0) {
+                fprintf(stderr, "Could not create thread %ld\n", i);
+                abort();
+            }
+        }
+        cpu_time = 0;
+        for (i = 0; i < n; i++) {
+            pthread_join(workers[i].thread, NULL);
+            failures += workers[i].failures;
+            cpu_time += workers[i].cpu_time;
+        }
+        elapsed = now() - elapsed;
+
+        rate = (double) (n * NUMRUNS) / elapsed;
+        if (n == 1) {
+            rate_1 = rate;
+        }
+        printf("%8ld %14.1f %9.2f %17.1f%s\n", n, rate, rate / rate_1,
+                1e6 * cpu_time / (double) (n * NUMRUNS), n > cpus ? "  (more threads than CPUs)" : "");
+
+        if (n == max_threads) {
+            break;
+        }
+    }
+    printf("%s\n", failures ? "NOT OK" : "OK");
+
+    free(workers);
+#if PARAMS_TAU == 1
+    free(A_fixed_matrix);
+#endif
+
+    return failures != 0;
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2020, Koninklijke Philips N.V.
+ */
+
+/**
+ * @file
+ * Microbenchmark of the C++ interface (kem.hpp) against the C functions of
+ * the NIST api it wraps: key generation, encapsulation and de-capsulation,
+ * directly in C, through the span functions of round5::Kem and through the
+ * ones that return their outputs by value. It prints the minimum number of
+ * CPU cycles over the runs of each. With NIST_KAT_GENERATION, the RNG is
+ * seeded the same for the three, which must then give the same keys,
+ * ciphertexts and shared secrets.
+ */
+
+#include "kem.hpp"
+#include "rng.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#if defined(TIMING) && (TIMING > 1)
+#define NUMRUNS TIMING
+#else
+#define NUMRUNS 1000
+#endif
+
+#if defined(__x86_64__)
+#define CPU_CYCLE_COUNT(v) __asm__ __volatile__("rdtsc; shlq $32,%%rdx;orq %%rdx,%%rax" : "=a" (v) : : "memory", "%rdx")
+#else
+#warning Can not run speed tests on non x86_64 platform
+#define CPU_CYCLE_COUNT(v)  v = 0
+#endif
+
+#define MEASURE(cycles, code) do { \
+    uint64_t start_, end_; \
+    CPU_CYCLE_COUNT(start_); \
+    code; \
+    CPU_CYCLE_COUNT(end_); \
+    cycles = end_ - start_ < cycles ? end_ - start_ : cycles; \
+} while (0)
+
+using Kem = round5::Kem<round5::NistApi>;
+
+// the same random bytes for each of the ways of calling
+static void seed_rng(int run) {
+    unsigned char entropy_input[48];
+    for (int i = 0; i < 48; i++) {
+        entropy_input[i] = (unsigned char) (i + run);
+    }
+    randombytes_init(entropy_input, NULL, 256);
+}
+
+int main() {
+    static_assert(Kem::public_key_size == CRYPTO_PUBLICKEYBYTES && Kem::ciphertext_size == CRYPTO_CIPHERTEXTBYTES);
+
+    uint64_t cycles[3][3];
+    int failures = 0;
+
+    for (auto &c : cycles) {
+        for (auto &v : c) {
+            v = UINT64_MAX;
+        }
+    }
+
+    for (int run = 0; run < NUMRUNS; run++) {
+        /* C */
+        unsigned char pk[CRYPTO_PUBLICKEYBYTES], sk[CRYPTO_SECRETKEYBYTES];
+        unsigned char ct[CRYPTO_CIPHERTEXTBYTES], k_enc[CRYPTO_BYTES], k_dec[CRYPTO_BYTES];
+        seed_rng(run);
+        MEASURE(cycles[0][0], crypto_kem_keypair(pk, sk));
+        MEASURE(cycles[0][1], crypto_kem_enc(ct, k_enc, pk));
+        MEASURE(cycles[0][2], crypto_kem_dec(k_dec, ct, sk));
+        failures += memcmp(k_enc, k_dec, CRYPTO_BYTES) != 0;
+
+        /* C++, spans */
+        Kem::PublicKey span_pk;
+        Kem::SecretKey span_sk;
+        Kem::Ciphertext span_ct;
+        Kem::SharedSecret span_k_enc, span_k_dec;
+        seed_rng(run);
+        MEASURE(cycles[1][0], Kem::keypair(span_pk, span_sk));
+        MEASURE(cycles[1][1], Kem::encapsulate(span_ct, span_k_enc, span_pk));
+        MEASURE(cycles[1][2], Kem::decapsulate(span_k_dec, span_ct, span_sk));
+        failures += span_k_enc != span_k_dec;
+
+        /* C++, by value */
+        Kem::KeyPair kp;
+        Kem::Encapsulation e;
+        Kem::SharedSecret value_k_dec;
+        seed_rng(run);
+        MEASURE(cycles[2][0], kp = Kem::keypair());
+        MEASURE(cycles[2][1], e = Kem::encapsulate(kp.public_key));
+        MEASURE(cycles[2][2], value_k_dec = Kem::decapsulate(e.ciphertext, kp.secret_key));
+        failures += e.shared_secret != value_k_dec;
+
+#ifdef NIST_KAT_GENERATION
+        failures += memcmp(pk, span_pk.data(), sizeof (pk)) != 0 || memcmp(ct, span_ct.data(), sizeof (ct)) != 0 || memcmp(k_dec, span_k_dec.data(), sizeof (k_dec)) != 0;
+        failures += span_pk != kp.public_key || span_ct != e.ciphertext || span_k_dec != value_k_dec;
+#endif
+    }
+
+    printf("%s, %d runs, CPU cycles (minimum)\n", Kem::name, NUMRUNS);
+    printf("             %12s %12s %12s\n", "keypair", "enc", "dec");
+    printf("C            %12llu %12llu %12llu\n", (unsigned long long) cycles[0][0], (unsigned long long) cycles[0][1], (unsigned long long) cycles[0][2]);
+    printf("C++ span     %12llu %12llu %12llu\n", (unsigned long long) cycles[1][0], (unsigned long long) cycles[1][1], (unsigned long long) cycles[1][2]);
+    printf("C++ value    %12llu %12llu %12llu\n", (unsigned long long) cycles[2][0], (unsigned long long) cycles[2][1], (unsigned long long) cycles[2][2]);
+    printf("%s\n", failures ? "NOT OK" : "OK");
+
+    return failures != 0;
+}
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2020, Koninklijke Philips N.V.
+ */
+
+/**
+ * @file
+ * Microbenchmark of B = A * S (matmul_as_q) in the AVX2 builds of the
+ * non-ring parameter sets: the register-blocked kernel against the inner
+ * product per row (matmul_as_q_inner). Both must give the same B.
+ */
+
+#include "r5_parameter_sets.h"
+#include "matmul.h"
+#include "r5_memory.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#if PARAMS_K != 1 && defined(AVX2)
+
+#if defined(TIMING) && (TIMING > 1)
+#define NUMRUNS TIMING
+#else
+#define NUMRUNS 200
+#endif
+
+#if defined(__x86_64__)
+#define CPU_CYCLE_COUNT(v) __asm__ __volatile__("rdtsc; shlq $32,%%rdx;orq %%rdx,%%rax" : "=a" (v) : : "memory", "%rdx")
+#else
+#warning Can not run speed tests on non x86_64 platform
+#define CPU_CYCLE_COUNT(v)  v = 0
+#endif
+
+#if PARAMS_TAU == 0
+#define A_LEN (PARAMS_D * PARAMS_D)
+#define A_ARG (modq_t (*)[PARAMS_D]) a
+#elif PARAMS_TAU == 1
+#define A_LEN (2 * PARAMS_D * PARAMS_D)
+#define A_ARG a, a_permutation
+#else
+#define A_LEN (PARAMS_TAU2_LEN + PARAMS_D)
+#define A_ARG a, a_permutation
+#endif
+
+// the inputs do not need to be of cryptographic quality
+static uint32_t xorshift(void) {
+    static uint32_t x = 2463534242u;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+int main(void) {
+    modq_t *a = checked_malloc(A_LEN * sizeof (modq_t));
+    tern_secret *s = checked_malloc(sizeof (tern_secret_s));
+    modq_t (*b)[PARAMS_N_BAR] = checked_malloc(PARAMS_D * sizeof (*b));
+    modq_t (*b_inner)[PARAMS_N_BAR] = checked_malloc(PARAMS_D * sizeof (*b_inner));
+    uint64_t start, end, cycles = 0, cycles_inner = 0;
+    size_t i, j;
+    int run;
+#if PARAMS_TAU == 1
+    uint32_t a_permutation[PARAMS_D];
+#elif PARAMS_TAU == 2
+    uint16_t a_permutation[PARAMS_D];
+#endif
+
+    for (i = 0; i < A_LEN; i++) {
+        a[i] = (modq_t) xorshift();
+    }
+    memset(s, 0, sizeof (tern_secret_s));
+    for (i = 0; i < PARAMS_N_BAR; i++) {
+        for (j = 0; j < PARAMS_D; j++) {
+            s[i][j] = (tern_coef_type) ((int) (xorshift() % 3) - 1);
+        }
+    }
+#if PARAMS_TAU == 1
+    for (i = 0; i < PARAMS_D; i++) {
+        a_permutation[i] = (uint32_t) (2 * i * PARAMS_D + xorshift() % PARAMS_D);
+    }
+#elif PARAMS_TAU == 2
+    for (i = 0; i < PARAMS_D; i++) {
+        a_permutation[i] = (uint16_t) (xorshift() % PARAMS_TAU2_LEN);
+    }
+#endif
+
+    for (run = 0; run < NUMRUNS; run++) {
+        CPU_CYCLE_COUNT(start);
+        matmul_as_q(b, A_ARG, s);
+        CPU_CYCLE_COUNT(end);
+        cycles += end - start;
+
+        CPU_CYCLE_COUNT(start);
+        matmul_as_q_inner(b_inner, A_ARG, s);
+        CPU_CYCLE_COUNT(end);
+        cycles_inner += end - start;
+    }
+
+    printf("matmul_as_q, d = %u, n_bar = %u, tau = %u, %d runs\n", PARAMS_D, PARAMS_N_BAR, PARAMS_TAU, NUMRUNS);
+    printf("register-blocked: %u K CPU cycles\n", (uint32_t) (cycles / NUMRUNS / 1000));
+    printf("inner product   : %u K CPU cycles\n", (uint32_t) (cycles_inner / NUMRUNS / 1000));
+    printf("results: %s\n", memcmp(b, b_inner, PARAMS_D * sizeof (*b)) ? "DIFFERENT" : "equal");
+
+    run = memcmp(b, b_inner, PARAMS_D * sizeof (*b)) != 0;
+    free(a);
+    free(s);
+    free(b);
+    free(b_inner);
+
+    return run;
+}
+
+#else
+
+int main(void) {
+    printf("matmul_as_q is only benchmarked in the AVX2 builds of the non-ring parameter sets\n");
+    return 0;
+}
+
+#endif
@@ -0,0 +1,92 @@
+/*
+ * Copyright (c) 2020, Koninklijke Philips N.V.
+ */
+
+/**
+ * @file
+ * Microbenchmark of the generation of the secrets S and R, in the constant
+ * time (or cache attack countermeasure) mode of the build. It prints the
+ * minimum number of CPU cycles over the runs and a hash of all the secrets,
+ * so that two builds can be checked to sample the same secrets.
+ */
+
+#include "r5_parameter_sets.h"
+#include "r5_secretkeygen.h"
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+
+#if defined(TIMING) && (TIMING > 1)
+#define NUMRUNS TIMING
+#else
+#define NUMRUNS 1000
+#endif
+
+#if defined(__x86_64__)
+#define CPU_CYCLE_COUNT(v) __asm__ __volatile__("rdtsc; shlq $32,%%rdx;orq %%rdx,%%rax" : "=a" (v) : : "memory", "%rdx")
+#else
+#warning Can not run speed tests on non x86_64 platform
+#define CPU_CYCLE_COUNT(v)  v = 0
+#endif
+
+#if PARAMS_K == 1
+typedef tern_secret bench_secret_s;
+typedef tern_secret bench_secret_r;
+#define CREATE_S(s, seed) create_secret_vector_s(s, seed)
+#define CREATE_R(r, seed) create_secret_vector_r(r, seed)
+#else
+typedef tern_secret_s bench_secret_s;
+typedef tern_secret_r bench_secret_r;
+#define CREATE_S(s, seed) create_secret_matrix_s_t(s, seed)
+#define CREATE_R(r, seed) create_secret_matrix_r_t(r, seed)
+#endif
+
+// 64-bit FNV-1a
+static uint64_t hash(uint64_t h, const void *data, size_t len) {
+    const uint8_t *p = data;
+    size_t i;
+
+    for (i = 0; i < len; i++) {
+        h ^= p[i];
+        h *= 0x100000001b3U;
+    }
+    return h;
+}
+
+int main(void) {
+    static bench_secret_s s;
+    static bench_secret_r r;
+    uint8_t seed[PARAMS_KAPPA_BYTES];
+    uint64_t start, end, cycles_s = UINT64_MAX, cycles_r = UINT64_MAX, h = 0xcbf29ce484222325U;
+    size_t i;
+    int run;
+
+    for (run = 0; run < NUMRUNS; run++) {
+        for (i = 0; i < PARAMS_KAPPA_BYTES; i++) {
+            seed[i] = (uint8_t) (31 * i + (size_t) run);
+        }
+        memset(s, 0, sizeof (s));
+        memset(r, 0, sizeof (r));
+
+        CPU_CYCLE_COUNT(start);
+        CREATE_S(s, seed);
+        CPU_CYCLE_COUNT(end);
+        cycles_s = end - start < cycles_s ? end - start : cycles_s;
+
+        CPU_CYCLE_COUNT(start);
+        CREATE_R(r, seed);
+        CPU_CYCLE_COUNT(end);
+        cycles_r = end - start < cycles_r ? end - start : cycles_r;
+
+        h = hash(h, s, sizeof (s));
+        h = hash(h, r, sizeof (r));
+    }
+
+    printf("%s, %d runs\n", CRYPTO_ALGNAME, NUMRUNS);
+    printf("S: %llu CPU cycles\n", (unsigned long long) cycles_s);
+    printf("R: %llu CPU cycles\n", (unsigned long long) cycles_r);
+    printf("secrets: %016llx\n", (unsigned long long) h);
+
+    return 0;
+}
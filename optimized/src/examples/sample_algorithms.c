@@ -0,0 +1,104 @@
+/*
+ * Copyright (c) 2020, Koninklijke Philips N.V.
+ */
+
+/**
+ * @file
+ * Example application of the parameter set registry: runs the KEM (and for
+ * CCA parameter sets the PKE) of each parameter set of the library, or of
+ * the ones named on the command line.
+ */
+
+#include "r5_algorithms.h"
+#include "rng.h"
+#include "r5_memory.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+ * Runs an example flow of a parameter set.
+ *
+ * @param[in] alg the parameter set
+ * @return __0__ in case of success
+ */
+static int example_run(const r5_algorithm *alg) {
+    static const unsigned char message[] = "The quick brown fox jumps over the lazy dog";
+    unsigned char *pk, *sk, *ct, *ss_i, *ss_r, *m;
+    unsigned long long ct_len, m_len;
+    int ok;
+
+    printf("%-20s pk=%-6zu sk=%-6zu ct=%-6zu ss=%-3zu", alg->name, alg->kem_pk_bytes, alg->kem_sk_bytes, alg->kem_ct_bytes, alg->kem_ss_bytes);
+
+    pk = checked_malloc(alg->kem_pk_bytes);
+    sk = checked_malloc(alg->kem_sk_bytes);
+    ct = checked_malloc(alg->kem_ct_bytes + alg->pke_overhead_bytes + sizeof (message));
+    ss_i = checked_malloc(alg->kem_ss_bytes);
+    ss_r = checked_malloc(alg->kem_ss_bytes);
+    m = checked_malloc(sizeof (message));
+
+    ok = alg->kem_keypair(pk, sk) == 0
+            && alg->kem_enc(ct, ss_r, pk) == 0
+            && alg->kem_dec(ss_i, ct, sk) == 0
+            && memcmp(ss_i, ss_r, alg->kem_ss_bytes) == 0;
+    printf(" KEM %s", ok ? "OK" : "NOT OK");
+
+    if (ok && alg->encrypt_keypair != NULL) {
+        ok = alg->encrypt_keypair(pk, sk) == 0
+                && alg->encrypt(ct, &ct_len, message, sizeof (message), pk) == 0
+                && ct_len == alg->pke_overhead_bytes + sizeof (message)
+                && alg->encrypt_open(m, &m_len, ct, ct_len, sk) == 0
+                && m_len == sizeof (message)
+                && memcmp(m, message, sizeof (message)) == 0;
+        printf(", PKE %s", ok ? "OK" : "NOT OK");
+    }
+    printf("\n");
+
+    free(pk);
+    free(sk);
+    free(ct);
+    free(ss_i);
+    free(ss_r);
+    free(m);
+
+    return !ok;
+}
+
+/**
+ * Main program, runs an example flow of the parameter sets.
+ *
+ * @param[in] argc the number of arguments
+ * @param[in] argv the names of the parameter sets to run, all if none
+ * @return __0__ in case of success
+ */
+int main(int argc, char **argv) {
+    const r5_algorithm *alg;
+    int result = 0;
+    size_t i;
+
+    /* Initialize random bytes RNG */
+    unsigned char entropy_input[48];
+    for (i = 0; i < 48; i++) {
+        entropy_input[i] = (unsigned char) i;
+    }
+    randombytes_init(entropy_input, NULL, 256);
+
+    if (argc > 1) {
+        for (i = 1; i < (size_t) argc; i++) {
+            alg = r5_algorithm_by_name(argv[i]);
+            if (alg == NULL) {
+                fprintf(stderr, "%s is not a parameter set of this library\n", argv[i]);
+                result = 1;
+            } else {
+                result |= example_run(alg);
+            }
+        }
+    } else {
+        for (i = 0; i < r5_num_algorithms(); i++) {
+            result |= example_run(r5_algorithm_at(i));
+        }
+    }
+
+    return result;
+}
@@ -51,6 +51,7 @@ cpu_time_used[index][iteration] = (double)(end - start) / CLOCKS_PER_SEC;
 #include "kem.h"
 #include "rng.h"
 #include "r5_memory.h"
+#include "r5_dispatch.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -137,6 +138,7 @@ static int example_run() {
     printf("CRYPTO_PUBLICKEYBYTES =%u\n", CRYPTO_PUBLICKEYBYTES);
     printf("CRYPTO_BYTES          =%u\n", CRYPTO_BYTES);
     printf("CRYPTO_CIPHERTEXTBYTES=%u\n", CRYPTO_CIPHERTEXTBYTES);
+    printf("kernels               =%s\n", r5_kernels());
     
     PRINT(print_parameters())
 
@@ -15,6 +15,7 @@
 
 #include "rng.h"
 #include "r5_memory.h"
+#include "r5_dispatch.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -79,6 +80,7 @@ static int example_run() {
     printf("CRYPTO_PUBLICKEYBYTES =%u\n", CRYPTO_PUBLICKEYBYTES);
     printf("CRYPTO_BYTES          =%u\n", CRYPTO_BYTES);
     printf("CRYPTO_CIPHERTEXTBYTES=%u\n", CRYPTO_CIPHERTEXTBYTES);
+    printf("kernels               =%s\n", r5_kernels());
     printf("CRYPTO_ALGNAME        =%s\n", CRYPTO_ALGNAME);
     print_parameters();
     printf("This set of parameters correspond to NIST security level %c.\n", CRYPTO_ALGNAME[5]);
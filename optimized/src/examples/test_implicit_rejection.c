@@ -0,0 +1,150 @@
+/*
+ * Copyright (c) 2020, Koninklijke Philips N.V.
+ */
+
+/**
+ * @file
+ * Regression test of the implicit rejection of the CCA KEM: a tampered
+ * ciphertext must decapsulate to k = H(y, ct), with y the secret rejection
+ * value of the secret key and ct the ciphertext as received, in
+ * crypto_kem_dec() as well as in crypto_kem_dec_batch().
+ */
+
+#include "kem.h"
+#include "rng.h"
+#include "r5_hash.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if PARAMS_TAU == 1 && PARAMS_N == 1
+#include "a_fixed.h"
+#endif
+
+/** The number of ciphertexts: two groups of four and a leftover one. */
+#define NUM_CT 9
+
+#ifdef ROUND5_CCA_PKE
+
+/**
+ * Checks the shared secrets of the decapsulations of ciphertexts of which
+ * the odd ones were tampered with.
+ *
+ * @param[in] name the function that decapsulated
+ * @param[in] k    the decapsulated shared secrets
+ * @param[in] ss   the shared secrets of the encapsulations
+ * @param[in] ct   the ciphertexts, as decapsulated
+ * @param[in] sk   the secret key
+ * @return __0__ if all shared secrets are the expected ones
+ */
+static int check(const char *name, unsigned char k[NUM_CT][CRYPTO_BYTES], unsigned char ss[NUM_CT][CRYPTO_BYTES], unsigned char ct[NUM_CT][CRYPTO_CIPHERTEXTBYTES], const unsigned char *sk) {
+    const unsigned char *y = sk + PARAMS_KAPPA_BYTES;
+    unsigned char expected[CRYPTO_BYTES];
+    int ok = 0;
+    int i;
+
+    for (i = 0; i < NUM_CT; i++) {
+        if (i & 1) {
+            HCCAKEM(expected, PARAMS_KAPPA_BYTES, y, PARAMS_KAPPA_BYTES, ct[i], CRYPTO_CIPHERTEXTBYTES Params);
+        } else {
+            memcpy(expected, ss[i], CRYPTO_BYTES);
+        }
+        ok |= memcmp(k[i], expected, CRYPTO_BYTES) != 0;
+    }
+    printf("%-20s: %s\n", name, ok ? "NOT OK" : "OK");
+
+    return ok;
+}
+
+/**
+ * Decapsulates valid and tampered ciphertexts, one at a time and as a
+ * batch.
+ *
+ * @return __0__ in case of success
+ */
+static int test_run(void) {
+    unsigned char sk[CRYPTO_SECRETKEYBYTES];
+    unsigned char pk[CRYPTO_PUBLICKEYBYTES];
+    unsigned char ct[NUM_CT][CRYPTO_CIPHERTEXTBYTES];
+    unsigned char ss[NUM_CT][CRYPTO_BYTES];
+    unsigned char k[NUM_CT][CRYPTO_BYTES];
+    unsigned char *kb[NUM_CT];
+    const unsigned char *ctb[NUM_CT];
+    int ok = 0;
+    int i;
+
+#if PARAMS_TAU == 1 && PARAMS_N == 1
+    unsigned char seed[PARAMS_KAPPA_BYTES];
+    randombytes(seed, PARAMS_KAPPA_BYTES);
+    create_A_fixed(seed);
+#endif
+
+    printf("CRYPTO_ALGNAME=%s\n", CRYPTO_ALGNAME);
+
+    if (crypto_kem_keypair(pk, sk) != 0) {
+        printf("crypto_kem_keypair failed\n");
+        return 1;
+    }
+    for (i = 0; i < NUM_CT; i++) {
+        if (crypto_kem_enc(ct[i], ss[i], pk) != 0) {
+            printf("crypto_kem_enc failed\n");
+            return 1;
+        }
+        // tamper with the odd ones, in a different byte each
+        if (i & 1) {
+            ct[i][CRYPTO_CIPHERTEXTBYTES - 1 - i] ^= 0x01;
+        }
+        kb[i] = k[i];
+        ctb[i] = ct[i];
+    }
+
+    memset(k, 0, sizeof (k));
+    for (i = 0; i < NUM_CT; i++) {
+        if (crypto_kem_dec(k[i], ct[i], sk) != 0) {
+            printf("crypto_kem_dec failed\n");
+            return 1;
+        }
+    }
+    ok |= check("crypto_kem_dec", k, ss, ct, sk);
+
+    memset(k, 0, sizeof (k));
+    if (crypto_kem_dec_batch(kb, ctb, NUM_CT, sk) != 0) {
+        printf("crypto_kem_dec_batch failed\n");
+        return 1;
+    }
+    ok |= check("crypto_kem_dec_batch", k, ss, ct, sk);
+
+    return ok;
+}
+
+#else
+
+/**
+ * The CPA KEM has no implicit rejection.
+ *
+ * @return __0__
+ */
+static int test_run(void) {
+    printf("CRYPTO_ALGNAME=%s\n", CRYPTO_ALGNAME);
+    printf("Not a CCA KEM, no implicit rejection to test\n");
+
+    return 0;
+}
+
+#endif
+
+/**
+ * Main program, runs the test.
+ *
+ * @return __0__ in case of success
+ */
+int main(void) {
+    /* Initialize random bytes RNG */
+    unsigned char entropy_input[48];
+    for (int i = 0; i < 48; i++) {
+        entropy_input[i] = (unsigned char) i;
+    }
+    randombytes_init(entropy_input, NULL, 256);
+
+    return test_run();
+}
@@ -0,0 +1,160 @@
+/*
+ * Copyright (c) 2020, Koninklijke Philips N.V.
+ */
+
+/**
+ * @file
+ * LibFuzzer and AFL target that checks the packing functions of the build
+ * (the AVX2 kernels, when built with AVX2) against the scalar code.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+/* The scalar packing functions, under other names */
+#undef AVX2
+#define pack_qp pack_qp_scalar
+#define unpack_p unpack_p_scalar
+#define pack_t pack_t_scalar
+#define unpack_t unpack_t_scalar
+#define unpack_t_message unpack_t_message_scalar
+#include "../pack.c"
+#undef pack_qp
+#undef unpack_p
+#undef pack_t
+#undef unpack_t
+#undef unpack_t_message
+
+#include "pack.h"
+#include "r5_memory.h"
+
+/** The maximum number of values packed at once. */
+#define MAX_COEFF 4096
+
+/** The number of bytes checked to be left alone after the packed values. */
+#define GUARD 32
+
+#ifndef LIBFUZZER
+/**
+ * Reads a block of data from the specified input file.
+ *
+ * @param input buffer for the data read (must be at least nr_bytes big)
+ * @param nr_bytes the (maximum) number of bytes to read
+ * @param input_file the file to read from
+ * @return the number of bytes read (can be < nr_bytes when the end of file was reached),
+           -1 in case of error
+ */
+static ssize_t read_bytes(uint8_t *input, const size_t nr_bytes, FILE *input_file) {
+    size_t read_bytes = fread(input, 1, nr_bytes, input_file);
+    if (ferror(input_file)) {
+        return -1;
+    }
+    return (ssize_t) read_bytes;
+}
+#endif
+
+static void check(const void *a, const void *b, size_t len, const char *what, size_t num_coeff) {
+    if (memcmp(a, b, len) != 0) {
+        fprintf(stderr, "%s differs from the scalar code for %zu values\n", what, num_coeff);
+        abort();
+    }
+}
+
+/**
+ * Packs and unpacks the input data, taken as values and as packed values, for
+ * the number of values given by the first two bytes. The packed values are
+ * unpacked from a buffer of their exact size, so that reads beyond it show
+ * up with the address sanitizer.
+ *
+ * @param[in] Data input data
+ * @param[in] Size size of input data
+ * @return __0__
+ */
+extern int LLVMFuzzerTestOneInput(const uint8_t *Data, size_t Size) {
+    static modq_t vq[MAX_COEFF];
+    static modp_t vp[2][MAX_COEFF + GUARD];
+    static uint8_t pv[2][2 * MAX_COEFF + GUARD];
+    size_t num_coeff, size, i;
+    modq_t rounding_constant;
+    uint8_t *in;
+
+    if (Size < 4) {
+        return 0;
+    }
+    num_coeff = (size_t) (Data[0] | Data[1] << 8) % (MAX_COEFF + 1);
+    rounding_constant = (modq_t) (Data[2] | Data[3] << 8);
+    Data += 4;
+    Size -= 4;
+    for (i = 0; i < MAX_COEFF; i++) {
+        vq[i] = (modq_t) (i < Size / 2 ? Data[2 * i] | Data[2 * i + 1] << 8 : 31 * i);
+    }
+
+    /* q -> p bits */
+    size = BITS_TO_BYTES(num_coeff * PARAMS_P_BITS);
+    memset(pv, 0xa5, sizeof (pv));
+    pack_qp_scalar(pv[0], vq, rounding_constant, num_coeff, size);
+    pack_qp(pv[1], vq, rounding_constant, num_coeff, size);
+    check(pv[0], pv[1], size + GUARD, "pack_qp", num_coeff);
+
+    in = checked_malloc(size ? size : 1);
+    memcpy(in, pv[0], size);
+    memset(vp, 0xa5, sizeof (vp));
+    unpack_p_scalar(vp[0], in, num_coeff);
+    unpack_p(vp[1], in, num_coeff);
+    check(vp[0], vp[1], (num_coeff + GUARD) * sizeof (modp_t), "unpack_p", num_coeff);
+    free(in);
+
+    /* t bits */
+    for (i = 0; i < num_coeff; i++) {
+        vp[0][i] = (modp_t) (vq[i] & ((1 << PARAMS_T_BITS) - 1));
+    }
+    size = BITS_TO_BYTES(num_coeff * PARAMS_T_BITS);
+    memset(pv, 0xa5, sizeof (pv));
+    pack_t_scalar(pv[0], vp[0], num_coeff);
+    pack_t(pv[1], vp[0], num_coeff);
+    check(pv[0], pv[1], size + GUARD, "pack_t", num_coeff);
+
+    /* unpacking arbitrary bytes */
+    in = checked_malloc(size ? size : 1);
+    for (i = 0; i < size; i++) {
+        in[i] = (uint8_t) (vq[i / 2] >> (8 * (i & 1)));
+    }
+    memset(vp, 0xa5, sizeof (vp));
+    unpack_t_scalar(vp[0], in, num_coeff);
+    unpack_t(vp[1], in, num_coeff);
+    check(vp[0], vp[1], (num_coeff + GUARD) * sizeof (modp_t), "unpack_t", num_coeff);
+
+    /* the message bits of decryption */
+    size = BITS_TO_BYTES(num_coeff * PARAMS_B_BITS);
+    memset(pv, 0xa5, sizeof (pv));
+    unpack_t_message_scalar(pv[0], in, vp[0], num_coeff);
+    unpack_t_message(pv[1], in, vp[0], num_coeff);
+    check(pv[0], pv[1], size + GUARD, "unpack_t_message", num_coeff);
+    free(in);
+
+    return 0;
+}
+
+#ifndef LIBFUZZER
+
+/**
+ * The program body. Reads data from stdin and runs the fuzzer test on it.
+ *
+ * @returns __0__ in case of success, __1__ in case of failure.
+ */
+int main(void) {
+    static uint8_t Data[2 * MAX_COEFF + 4];
+
+    /* Run test on input data */
+    ssize_t Size = read_bytes(Data, sizeof (Data), stdin);
+    if (Size < 0) {
+        fprintf(stderr, "Error reading stdin\n");
+        exit(1);
+    } else {
+        LLVMFuzzerTestOneInput(Data, (size_t) Size);
+    }
+}
+#endif
@@ -94,7 +94,7 @@ extern int LLVMFuzzerTestOneInput(const uint8_t *Data, size_t Size) {
     unsigned long long ct_len;
 
     /* Responder encrypts message with public key and sends the cipher text */
-    r5_cca_pke_encrypt(ct, &ct_len, message, message_len, pk);
+    r5_cca_pke_encrypt(NULL, ct, &ct_len, message, message_len, pk);
 #else
     /* “Receive” PK */
     const unsigned char *pk = Data;
@@ -102,7 +102,7 @@ extern int LLVMFuzzerTestOneInput(const uint8_t *Data, size_t Size) {
     unsigned char ss[CRYPTO_BYTES];
 
     /* Responder determines shared secret, encapsulates and sends the cipher text */
-    r5_cpa_kem_encapsulate(ct, ss, pk);
+    r5_cpa_kem_encapsulate(NULL, ct, ss, pk);
 #endif
 
 #else /* !FUZZ_RESPONDER */
@@ -118,14 +118,14 @@ extern int LLVMFuzzerTestOneInput(const uint8_t *Data, size_t Size) {
     unsigned long long m_len;
 
     /* Initiator sets up key */
-    r5_cca_pke_keygen(pk, sk);
+    r5_cca_pke_keygen(NULL, pk, sk);
 
     /* “Receive” CT */
     const unsigned char *ct = Data;
     unsigned long long ct_len = Size;
 
     /* Initiator decrypts cipher text with its secret key and determines the original message */
-    r5_cca_pke_decrypt(m, &m_len, ct, ct_len, sk);
+    r5_cca_pke_decrypt(NULL, m, &m_len, ct, ct_len, sk);
 
     free(m);
 #else
@@ -137,7 +137,7 @@ extern int LLVMFuzzerTestOneInput(const uint8_t *Data, size_t Size) {
     unsigned char ss[CRYPTO_BYTES];
 
     /* Initiator sets up key */
-    r5_cpa_kem_keygen(pk, sk);
+    r5_cpa_kem_keygen(NULL, pk, sk);
 
     /* “Receive” CT */
     const unsigned char *ct = Data;
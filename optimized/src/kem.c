@@ -15,5 +15,20 @@
 extern int crypto_kem_keypair(unsigned char *pk, unsigned char *sk);
 extern int crypto_kem_enc(unsigned char *ct, unsigned char *k, const unsigned char *pk);
 extern int crypto_kem_dec(unsigned char *k, const unsigned char *ct, const unsigned char *sk);
+extern int crypto_kem_enc_prepared(unsigned char *ct, unsigned char *k, const r5_prepared_pk *ppk);
+extern int crypto_kem_enc_batch(unsigned char *ct[], unsigned char *k[], const unsigned char *pk[], size_t count);
+extern int crypto_kem_prepare_pk(r5_prepared_pk *ppk, const unsigned char *pk);
+extern int crypto_kem_expand_sk(crypto_kem_expanded_sk *esk, const unsigned char *sk);
+extern int crypto_kem_dec_expanded(unsigned char *k, const unsigned char *ct, const crypto_kem_expanded_sk *esk);
+extern int crypto_kem_dec_batch(unsigned char *k[], const unsigned char *ct[], size_t count, const unsigned char *sk);
+extern int crypto_kem_keypair_ctx(r5_ctx *ctx, unsigned char *pk, unsigned char *sk);
+extern int crypto_kem_enc_ctx(r5_ctx *ctx, unsigned char *ct, unsigned char *k, const unsigned char *pk);
+extern int crypto_kem_enc_prepared_ctx(r5_ctx *ctx, unsigned char *ct, unsigned char *k, const r5_prepared_pk *ppk);
+extern int crypto_kem_enc_batch_ctx(r5_ctx *ctx, unsigned char *ct[], unsigned char *k[], const unsigned char *pk[], size_t count);
+extern int crypto_kem_prepare_pk_ctx(r5_ctx *ctx, r5_prepared_pk *ppk, const unsigned char *pk);
+extern int crypto_kem_dec_ctx(r5_ctx *ctx, unsigned char *k, const unsigned char *ct, const unsigned char *sk);
+extern int crypto_kem_expand_sk_ctx(r5_ctx *ctx, crypto_kem_expanded_sk *esk, const unsigned char *sk);
+extern int crypto_kem_dec_expanded_ctx(r5_ctx *ctx, unsigned char *k, const unsigned char *ct, const crypto_kem_expanded_sk *esk);
+extern int crypto_kem_dec_batch_ctx(r5_ctx *ctx, unsigned char *k[], const unsigned char *ct[], size_t count, const unsigned char *sk);
 
 #endif
@@ -11,6 +11,7 @@
 //#define _CPA_KEM_H_
 
 #include "r5_parameter_sets.h"
+#include "r5_cpa_pke.h"
 
 /*
  * Conditionally provide the KEM NIST API functions.
@@ -30,7 +31,11 @@ extern "C" {
     #define CRYPTO_PUBLICKEYBYTES  PARAMS_PK_SIZE
     #define CRYPTO_BYTES           PARAMS_KAPPA_BYTES
     #define CRYPTO_CIPHERTEXTBYTES PARAMS_CT_SIZE
+
+    typedef r5_expanded_sk crypto_kem_expanded_sk;
         
+#ifndef R5_DISPATCH
+
     /**
      * Generates a CPA KEM key pair.
      *
@@ -39,7 +44,7 @@ extern "C" {
      * @return __0__ in case of success
      */
     inline int crypto_kem_keypair(unsigned char *pk, unsigned char *sk) {
-        return r5_cpa_kem_keygen(pk, sk);
+        return r5_cpa_kem_keygen(NULL, pk, sk);
     }
 
     /**
@@ -51,7 +56,33 @@ extern "C" {
      * @return __0__ in case of success
      */
     inline int crypto_kem_enc(unsigned char *ct, unsigned char *k, const unsigned char *pk) {
-        return r5_cpa_kem_encapsulate(ct, k, pk);
+        return r5_cpa_kem_encapsulate(NULL, ct, k, pk);
+    }
+
+    /**
+     * CPA KEM encapsulate with a prepared public key.
+     *
+     * @param[out] ct    key encapsulation message (ciphertext)
+     * @param[out] k     shared secret
+     * @param[in]  ppk   prepared public key (see crypto_kem_prepare_pk())
+     * @return __0__ in case of success
+     */
+    inline int crypto_kem_enc_prepared(unsigned char *ct, unsigned char *k, const r5_prepared_pk *ppk) {
+        return r5_cpa_kem_encapsulate_prepared(NULL, ct, k, ppk);
+    }
+
+    /**
+     * CPA KEM encapsulate to count public keys, four at a time. Same result
+     * as crypto_kem_enc() on each key in turn.
+     *
+     * @param[out] ct    key encapsulation messages (ciphertexts)
+     * @param[out] k     shared secrets
+     * @param[in]  pk    public keys with which the messages are encapsulated
+     * @param[in]  count the number of public keys
+     * @return __0__ in case of success
+     */
+    inline int crypto_kem_enc_batch(unsigned char *ct[], unsigned char *k[], const unsigned char *pk[], size_t count) {
+        return r5_cpa_kem_encapsulate_batch(NULL, ct, k, pk, count);
     }
 
     /**
@@ -65,7 +96,97 @@ extern "C" {
     inline int crypto_kem_dec(unsigned char *k, const unsigned char *ct, const unsigned char *sk) {
         return r5_cpa_kem_decapsulate(k, ct, sk);
     }
+
+    /**
+     * Expands a secret key for repeated de-capsulation: the secret is
+     * sampled and (CCA) the embedded public key prepared only once.
+     *
+     * @param[out] esk   expanded secret key
+     * @param[in]  sk    secret key
+     * @return __0__ in case of success
+     */
+    inline int crypto_kem_expand_sk(crypto_kem_expanded_sk *esk, const unsigned char *sk) {
+        return r5_cpa_kem_expand_sk(esk, sk);
+    }
+
+    /**
+     * CPA KEM de-capsulate with an expanded secret key.
+     *
+     * @param[out] k     shared secret
+     * @param[in]  ct    key encapsulation message (ciphertext)
+     * @param[in]  esk   expanded secret key (see crypto_kem_expand_sk())
+     * @return __0__ in case of success
+     */
+    inline int crypto_kem_dec_expanded(unsigned char *k, const unsigned char *ct, const crypto_kem_expanded_sk *esk) {
+        return r5_cpa_kem_decapsulate_expanded(k, ct, esk);
+    }
+
+    /**
+     * CPA KEM de-capsulate count messages with one secret key, four at a
+     * time. Same result as crypto_kem_dec() on each message in turn.
+     *
+     * @param[out] k     shared secrets
+     * @param[in]  ct    key encapsulation messages (ciphertexts)
+     * @param[in]  count the number of messages
+     * @param[in]  sk    secret key with which the messages are to be de-capsulated
+     * @return __0__ in case of success
+     */
+    inline int crypto_kem_dec_batch(unsigned char *k[], const unsigned char *ct[], size_t count, const unsigned char *sk) {
+        return r5_cpa_kem_decapsulate_batch(k, ct, count, sk);
+    }
+
+    /*
+     * The functions above with a context (see r5_ctx.h): the random bytes
+     * are drawn from the context and (tau 1) its A_fixed is used, so that
+     * threads with a context of their own share no state. A NULL context
+     * gives the functions above.
+     */
+
+    /** crypto_kem_keypair() with a context */
+    inline int crypto_kem_keypair_ctx(r5_ctx *ctx, unsigned char *pk, unsigned char *sk) {
+        return r5_cpa_kem_keygen(ctx, pk, sk);
+    }
+
+    /** crypto_kem_enc() with a context */
+    inline int crypto_kem_enc_ctx(r5_ctx *ctx, unsigned char *ct, unsigned char *k, const unsigned char *pk) {
+        return r5_cpa_kem_encapsulate(ctx, ct, k, pk);
+    }
+
+    /** crypto_kem_enc_prepared() with a context */
+    inline int crypto_kem_enc_prepared_ctx(r5_ctx *ctx, unsigned char *ct, unsigned char *k, const r5_prepared_pk *ppk) {
+        return r5_cpa_kem_encapsulate_prepared(ctx, ct, k, ppk);
+    }
+
+    /** crypto_kem_enc_batch() with a context */
+    inline int crypto_kem_enc_batch_ctx(r5_ctx *ctx, unsigned char *ct[], unsigned char *k[], const unsigned char *pk[], size_t count) {
+        return r5_cpa_kem_encapsulate_batch(ctx, ct, k, pk, count);
+    }
+
+    /** crypto_kem_dec() with a context */
+    inline int crypto_kem_dec_ctx(r5_ctx *ctx, unsigned char *k, const unsigned char *ct, const unsigned char *sk) {
+        (void) ctx;
+        return r5_cpa_kem_decapsulate(k, ct, sk);
+    }
+
+    /** crypto_kem_expand_sk() with a context */
+    inline int crypto_kem_expand_sk_ctx(r5_ctx *ctx, crypto_kem_expanded_sk *esk, const unsigned char *sk) {
+        (void) ctx;
+        return r5_cpa_kem_expand_sk(esk, sk);
+    }
+
+    /** crypto_kem_dec_expanded() with a context (the expanded secret key holds all it needs) */
+    inline int crypto_kem_dec_expanded_ctx(r5_ctx *ctx, unsigned char *k, const unsigned char *ct, const crypto_kem_expanded_sk *esk) {
+        (void) ctx;
+        return r5_cpa_kem_decapsulate_expanded(k, ct, esk);
+    }
+
+    /** crypto_kem_dec_batch() with a context */
+    inline int crypto_kem_dec_batch_ctx(r5_ctx *ctx, unsigned char *k[], const unsigned char *ct[], size_t count, const unsigned char *sk) {
+        (void) ctx;
+        return r5_cpa_kem_decapsulate_batch(k, ct, count, sk);
+    }
     
+#endif /* R5_DISPATCH */
 #else /*CCA KEM*/
     
     #include "r5_cca_kem.h"
@@ -74,7 +195,11 @@ extern "C" {
     #define CRYPTO_PUBLICKEYBYTES  PARAMS_PK_SIZE
     #define CRYPTO_BYTES           PARAMS_KAPPA_BYTES
     #define CRYPTO_CIPHERTEXTBYTES (PARAMS_CT_SIZE + PARAMS_KAPPA_BYTES)
+
+    typedef r5_cca_expanded_sk crypto_kem_expanded_sk;
     
+#ifndef R5_DISPATCH
+
     /**
      * Generates a CCA KEM key pair.
      *
@@ -83,7 +208,7 @@ extern "C" {
      * @return __0__ in case of success
      */
     inline int crypto_kem_keypair(unsigned char *pk, unsigned char *sk) {
-        return r5_cca_kem_keygen(pk, sk);
+        return r5_cca_kem_keygen(NULL, pk, sk);
     }
     
     /**
@@ -95,7 +220,33 @@ extern "C" {
      * @return __0__ in case of success
      */
     inline int crypto_kem_enc(unsigned char *ct, unsigned char *k, const unsigned char *pk) {
-        return r5_cca_kem_encapsulate(ct, k, pk);
+        return r5_cca_kem_encapsulate(NULL, ct, k, pk);
+    }
+
+    /**
+     * CCA KEM encapsulate with a prepared public key.
+     *
+     * @param[out] ct    key encapsulation message (ciphertext)
+     * @param[out] k     shared secret
+     * @param[in]  ppk   prepared public key (see crypto_kem_prepare_pk())
+     * @return __0__ in case of success
+     */
+    inline int crypto_kem_enc_prepared(unsigned char *ct, unsigned char *k, const r5_prepared_pk *ppk) {
+        return r5_cca_kem_encapsulate_prepared(NULL, ct, k, ppk);
+    }
+
+    /**
+     * CCA KEM encapsulate to count public keys, four at a time. Same result
+     * as crypto_kem_enc() on each key in turn.
+     *
+     * @param[out] ct    key encapsulation messages (ciphertexts)
+     * @param[out] k     shared secrets
+     * @param[in]  pk    public keys with which the messages are encapsulated
+     * @param[in]  count the number of public keys
+     * @return __0__ in case of success
+     */
+    inline int crypto_kem_enc_batch(unsigned char *ct[], unsigned char *k[], const unsigned char *pk[], size_t count) {
+        return r5_cca_kem_encapsulate_batch(NULL, ct, k, pk, count);
     }
     
     /**
@@ -107,11 +258,157 @@ extern "C" {
      * @return __0__ in case of success
      */
     inline int crypto_kem_dec(unsigned char *k, const unsigned char *ct, const unsigned char *sk) {
-        return r5_cca_kem_decapsulate(k, ct, sk);
+        return r5_cca_kem_decapsulate(NULL, k, ct, sk);
+    }
+
+    /**
+     * Expands a secret key for repeated de-capsulation: the secret is
+     * sampled and (CCA) the embedded public key prepared only once.
+     *
+     * @param[out] esk   expanded secret key
+     * @param[in]  sk    secret key
+     * @return __0__ in case of success
+     */
+    inline int crypto_kem_expand_sk(crypto_kem_expanded_sk *esk, const unsigned char *sk) {
+        return r5_cca_kem_expand_sk(NULL, esk, sk);
+    }
+
+    /**
+     * CCA KEM de-capsulate with an expanded secret key.
+     *
+     * @param[out] k     shared secret
+     * @param[in]  ct    key encapsulation message (ciphertext)
+     * @param[in]  esk   expanded secret key (see crypto_kem_expand_sk())
+     * @return __0__ in case of success
+     */
+    inline int crypto_kem_dec_expanded(unsigned char *k, const unsigned char *ct, const crypto_kem_expanded_sk *esk) {
+        return r5_cca_kem_decapsulate_expanded(k, ct, esk);
+    }
+
+    /**
+     * CCA KEM de-capsulate count messages with one secret key, four at a
+     * time. Same result as crypto_kem_dec() on each message in turn.
+     *
+     * @param[out] k     shared secrets
+     * @param[in]  ct    key encapsulation messages (ciphertexts)
+     * @param[in]  count the number of messages
+     * @param[in]  sk    secret key with which the messages are to be de-capsulated
+     * @return __0__ in case of success
+     */
+    inline int crypto_kem_dec_batch(unsigned char *k[], const unsigned char *ct[], size_t count, const unsigned char *sk) {
+        return r5_cca_kem_decapsulate_batch(NULL, k, ct, count, sk);
+    }
+
+    /*
+     * The functions above with a context (see r5_ctx.h): the random bytes
+     * are drawn from the context and (tau 1) its A_fixed is used, so that
+     * threads with a context of their own share no state. A NULL context
+     * gives the functions above.
+     */
+
+    /** crypto_kem_keypair() with a context */
+    inline int crypto_kem_keypair_ctx(r5_ctx *ctx, unsigned char *pk, unsigned char *sk) {
+        return r5_cca_kem_keygen(ctx, pk, sk);
+    }
+
+    /** crypto_kem_enc() with a context */
+    inline int crypto_kem_enc_ctx(r5_ctx *ctx, unsigned char *ct, unsigned char *k, const unsigned char *pk) {
+        return r5_cca_kem_encapsulate(ctx, ct, k, pk);
+    }
+
+    /** crypto_kem_enc_prepared() with a context */
+    inline int crypto_kem_enc_prepared_ctx(r5_ctx *ctx, unsigned char *ct, unsigned char *k, const r5_prepared_pk *ppk) {
+        return r5_cca_kem_encapsulate_prepared(ctx, ct, k, ppk);
+    }
+
+    /** crypto_kem_enc_batch() with a context */
+    inline int crypto_kem_enc_batch_ctx(r5_ctx *ctx, unsigned char *ct[], unsigned char *k[], const unsigned char *pk[], size_t count) {
+        return r5_cca_kem_encapsulate_batch(ctx, ct, k, pk, count);
+    }
+
+    /** crypto_kem_dec() with a context */
+    inline int crypto_kem_dec_ctx(r5_ctx *ctx, unsigned char *k, const unsigned char *ct, const unsigned char *sk) {
+        return r5_cca_kem_decapsulate(ctx, k, ct, sk);
+    }
+
+    /** crypto_kem_expand_sk() with a context */
+    inline int crypto_kem_expand_sk_ctx(r5_ctx *ctx, crypto_kem_expanded_sk *esk, const unsigned char *sk) {
+        return r5_cca_kem_expand_sk(ctx, esk, sk);
+    }
+
+    /** crypto_kem_dec_expanded() with a context (the expanded secret key holds all it needs) */
+    inline int crypto_kem_dec_expanded_ctx(r5_ctx *ctx, unsigned char *k, const unsigned char *ct, const crypto_kem_expanded_sk *esk) {
+        (void) ctx;
+        return r5_cca_kem_decapsulate_expanded(k, ct, esk);
+    }
+
+    /** crypto_kem_dec_batch() with a context */
+    inline int crypto_kem_dec_batch_ctx(r5_ctx *ctx, unsigned char *k[], const unsigned char *ct[], size_t count, const unsigned char *sk) {
+        return r5_cca_kem_decapsulate_batch(ctx, k, ct, count, sk);
     }
     
+#endif /* R5_DISPATCH */
 #endif
-    
+
+#ifndef R5_DISPATCH
+
+    /**
+     * Prepares a public key for repeated encapsulation: A is generated and
+     * lifted, B unpacked and (CCA) the hash states set up once, instead of
+     * on every crypto_kem_enc().
+     *
+     * With tau 1 the prepared key points to the global A_fixed (to that of
+     * the context with crypto_kem_prepare_pk_ctx()), it does not copy it.
+     * That matrix must outlive the prepared key: an unmap_A_fixed(),
+     * map_A_fixed() or create_A_fixed() while the key is in use leaves it
+     * with a matrix that is gone or another one. Prepare the key again
+     * after any of these.
+     *
+     * @param[out] ppk   prepared public key
+     * @param[in]  pk    public key
+     * @return __0__ in case of success
+     */
+    inline int crypto_kem_prepare_pk(r5_prepared_pk *ppk, const unsigned char *pk) {
+#ifdef ROUND5_CCA_PKE
+        return r5_cca_kem_prepare_pk(NULL, ppk, pk);
+#else
+        return r5_cpa_pke_prepare_pk(NULL, ppk, pk);
+#endif
+    }
+
+    /** crypto_kem_prepare_pk() with a context (tau 1: the A_fixed of the context, which must outlive ppk) */
+    inline int crypto_kem_prepare_pk_ctx(r5_ctx *ctx, r5_prepared_pk *ppk, const unsigned char *pk) {
+#ifdef ROUND5_CCA_PKE
+        return r5_cca_kem_prepare_pk(ctx, ppk, pk);
+#else
+        return r5_cpa_pke_prepare_pk(ctx, ppk, pk);
+#endif
+    }
+
+#else /* R5_DISPATCH */
+
+    /*
+     * A DISPATCH build holds a generic and an AVX2 set of kernels and runs
+     * the one chosen at start-up (see r5_dispatch.h). Only the functions
+     * on byte strings are dispatched: the prepared public key and expanded
+     * secret key types differ between the sets. The functions with a
+     * context run the kernel set of the context (see r5_ctx_set_kernels()).
+     */
+
+    int crypto_kem_keypair(unsigned char *pk, unsigned char *sk);
+    int crypto_kem_enc(unsigned char *ct, unsigned char *k, const unsigned char *pk);
+    int crypto_kem_enc_batch(unsigned char *ct[], unsigned char *k[], const unsigned char *pk[], size_t count);
+    int crypto_kem_dec(unsigned char *k, const unsigned char *ct, const unsigned char *sk);
+    int crypto_kem_dec_batch(unsigned char *k[], const unsigned char *ct[], size_t count, const unsigned char *sk);
+
+    int crypto_kem_keypair_ctx(r5_ctx *ctx, unsigned char *pk, unsigned char *sk);
+    int crypto_kem_enc_ctx(r5_ctx *ctx, unsigned char *ct, unsigned char *k, const unsigned char *pk);
+    int crypto_kem_enc_batch_ctx(r5_ctx *ctx, unsigned char *ct[], unsigned char *k[], const unsigned char *pk[], size_t count);
+    int crypto_kem_dec_ctx(r5_ctx *ctx, unsigned char *k, const unsigned char *ct, const unsigned char *sk);
+    int crypto_kem_dec_batch_ctx(r5_ctx *ctx, unsigned char *k[], const unsigned char *ct[], size_t count, const unsigned char *sk);
+
+#endif /* R5_DISPATCH */
+
 #ifdef __cplusplus
 }
 #endif
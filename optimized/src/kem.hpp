@@ -0,0 +1,175 @@
+/*
+ * Copyright (c) 2020, Koninklijke Philips N.V.
+ */
+
+/**
+ * @file
+ * Header-only C++ (C++20) interface to the KEM functions of the NIST api.
+ *
+ * round5::Kem<ParamSet> gives the sizes of a parameter set as constants,
+ * the keys, ciphertext and shared secret as `std::array` types of those
+ * sizes, and the KEM functions on fixed-size `std::span`s, which are passed
+ * on to the C functions as they are. Nothing is allocated or copied.
+ *
+ * The span functions return the result of the C function (__0__ in case of
+ * success); the ones that return their outputs by value throw round5::error
+ * on failure instead.
+ */
+
+#ifndef R5_KEM_HPP
+#define R5_KEM_HPP
+
+#include <array>
+#include <cstddef>
+#include <span>
+#include <stdexcept>
+
+#include "kem.h"
+
+namespace round5 {
+
+    /**
+     * The exception thrown when a KEM function fails.
+     */
+    class error : public std::runtime_error {
+    public:
+        using std::runtime_error::runtime_error;
+    };
+
+    /**
+     * The parameter set the code is compiled for (`ALG`), with the functions
+     * of kem.h. Any type with these members can be used as a parameter set
+     * of Kem.
+     */
+    struct NistApi {
+        static constexpr const char *name = CRYPTO_ALGNAME;
+        static constexpr std::size_t public_key_bytes = CRYPTO_PUBLICKEYBYTES;
+        static constexpr std::size_t secret_key_bytes = CRYPTO_SECRETKEYBYTES;
+        static constexpr std::size_t ciphertext_bytes = CRYPTO_CIPHERTEXTBYTES;
+        static constexpr std::size_t shared_secret_bytes = CRYPTO_BYTES;
+
+        static int keypair(unsigned char *pk, unsigned char *sk) noexcept {
+            return crypto_kem_keypair(pk, sk);
+        }
+
+        static int enc(unsigned char *ct, unsigned char *k, const unsigned char *pk) noexcept {
+            return crypto_kem_enc(ct, k, pk);
+        }
+
+        static int dec(unsigned char *k, const unsigned char *ct, const unsigned char *sk) noexcept {
+            return crypto_kem_dec(k, ct, sk);
+        }
+    };
+
+    /**
+     * The KEM of a parameter set.
+     *
+     * @tparam ParamSet the parameter set, e.g. NistApi
+     */
+    template <class ParamSet>
+    class Kem {
+    public:
+        static constexpr const char *name = ParamSet::name;
+        static constexpr std::size_t public_key_size = ParamSet::public_key_bytes;
+        static constexpr std::size_t secret_key_size = ParamSet::secret_key_bytes;
+        static constexpr std::size_t ciphertext_size = ParamSet::ciphertext_bytes;
+        static constexpr std::size_t shared_secret_size = ParamSet::shared_secret_bytes;
+
+        using PublicKey = std::array<unsigned char, public_key_size>;
+        using SecretKey = std::array<unsigned char, secret_key_size>;
+        using Ciphertext = std::array<unsigned char, ciphertext_size>;
+        using SharedSecret = std::array<unsigned char, shared_secret_size>;
+
+        /** A key pair, as returned by keypair(). */
+        struct KeyPair {
+            PublicKey public_key;
+            SecretKey secret_key;
+        };
+
+        /** A ciphertext and its shared secret, as returned by encapsulate(). */
+        struct Encapsulation {
+            Ciphertext ciphertext;
+            SharedSecret shared_secret;
+        };
+
+        /**
+         * Generates a key pair.
+         *
+         * @param[out] pk public key
+         * @param[out] sk secret key
+         * @return __0__ in case of success
+         */
+        static int keypair(std::span<unsigned char, public_key_size> pk, std::span<unsigned char, secret_key_size> sk) noexcept {
+            return ParamSet::keypair(pk.data(), sk.data());
+        }
+
+        /**
+         * Encapsulates a shared secret.
+         *
+         * @param[out] ct key encapsulation message (ciphertext)
+         * @param[out] k  shared secret
+         * @param[in]  pk public key with which the message is encapsulated
+         * @return __0__ in case of success
+         */
+        static int encapsulate(std::span<unsigned char, ciphertext_size> ct, std::span<unsigned char, shared_secret_size> k, std::span<const unsigned char, public_key_size> pk) noexcept {
+            return ParamSet::enc(ct.data(), k.data(), pk.data());
+        }
+
+        /**
+         * De-capsulates a shared secret.
+         *
+         * @param[out] k  shared secret
+         * @param[in]  ct key encapsulation message (ciphertext)
+         * @param[in]  sk secret key with which the message is to be de-capsulated
+         * @return __0__ in case of success
+         */
+        static int decapsulate(std::span<unsigned char, shared_secret_size> k, std::span<const unsigned char, ciphertext_size> ct, std::span<const unsigned char, secret_key_size> sk) noexcept {
+            return ParamSet::dec(k.data(), ct.data(), sk.data());
+        }
+
+        /**
+         * Generates a key pair.
+         *
+         * @return the key pair
+         */
+        static KeyPair keypair() {
+            KeyPair kp;
+            if (keypair(kp.public_key, kp.secret_key) != 0) {
+                throw error("round5: key pair generation failed");
+            }
+            return kp;
+        }
+
+        /**
+         * Encapsulates a shared secret.
+         *
+         * @param[in] pk public key with which the message is encapsulated
+         * @return the ciphertext and the shared secret
+         */
+        static Encapsulation encapsulate(std::span<const unsigned char, public_key_size> pk) {
+            Encapsulation e;
+            if (encapsulate(e.ciphertext, e.shared_secret, pk) != 0) {
+                throw error("round5: encapsulation failed");
+            }
+            return e;
+        }
+
+        /**
+         * De-capsulates a shared secret.
+         *
+         * @param[in] ct key encapsulation message (ciphertext)
+         * @param[in] sk secret key with which the message is to be de-capsulated
+         * @return the shared secret
+         */
+        static SharedSecret decapsulate(std::span<const unsigned char, ciphertext_size> ct, std::span<const unsigned char, secret_key_size> sk) {
+            SharedSecret k;
+            if (decapsulate(k, ct, sk) != 0) {
+                throw error("round5: de-capsulation failed");
+            }
+            return k;
+        }
+    };
+
+}
+
+#endif /* R5_KEM_HPP */
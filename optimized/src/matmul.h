@@ -17,15 +17,34 @@
 #if PARAMS_TAU == 0
 void matmul_as_q(modq_t d[PARAMS_D][PARAMS_N_BAR], modq_t a[PARAMS_D][PARAMS_D], tern_secret_s secret_vector);
 void matmul_rta_q(modq_t d[PARAMS_M_BAR][PARAMS_D], modq_t a[PARAMS_D][PARAMS_D], tern_secret_r secret_vector);
+
+// The same, on nrows rows of A at a time (as when A is streamed, see
+// a_random.h). matmul_as_q_rows sets the nrows rows of d that go with the
+// rows of A given. matmul_rta_q_rows adds the part of rows row0 .. row0 +
+// nrows - 1 of A to d, which must be zeroed before the first rows.
+void matmul_as_q_rows(modq_t d[][PARAMS_N_BAR], const modq_t a[][PARAMS_D], size_t nrows, tern_secret_s secret_vector);
+void matmul_rta_q_rows(modq_t d[PARAMS_M_BAR][PARAMS_D], const modq_t a[][PARAMS_D], size_t row0, size_t nrows, tern_secret_r secret_vector);
 #elif PARAMS_TAU == 1
-void matmul_as_q(modq_t d[PARAMS_D][PARAMS_N_BAR], modq_t a[2 * PARAMS_D * PARAMS_D], uint32_t a_permutation[PARAMS_D], tern_secret_s secret_vector);
-void matmul_rta_q(modq_t d[PARAMS_M_BAR][PARAMS_D], modq_t a[2 * PARAMS_D * PARAMS_D], uint32_t a_permutation[PARAMS_D], tern_secret_r secret_vector);
+void matmul_as_q(modq_t d[PARAMS_D][PARAMS_N_BAR], const modq_t a[2 * PARAMS_D * PARAMS_D], const uint32_t a_permutation[PARAMS_D], tern_secret_s secret_vector);
+void matmul_rta_q(modq_t d[PARAMS_M_BAR][PARAMS_D], const modq_t a[2 * PARAMS_D * PARAMS_D], const uint32_t a_permutation[PARAMS_D], tern_secret_r secret_vector);
 #else
-void matmul_as_q(modq_t d[PARAMS_D][PARAMS_N_BAR], modq_t a[PARAMS_TAU2_LEN + PARAMS_D], uint16_t a_permutation[PARAMS_D], tern_secret_s secret_vector);
-void matmul_rta_q(modq_t d[PARAMS_M_BAR][PARAMS_D], modq_t a[PARAMS_TAU2_LEN + PARAMS_D], uint16_t a_permutation[PARAMS_D], tern_secret_r secret_vector);
+void matmul_as_q(modq_t d[PARAMS_D][PARAMS_N_BAR], const modq_t a[PARAMS_TAU2_LEN + PARAMS_D], const uint16_t a_permutation[PARAMS_D], tern_secret_s secret_vector);
+void matmul_rta_q(modq_t d[PARAMS_M_BAR][PARAMS_D], const modq_t a[PARAMS_TAU2_LEN + PARAMS_D], const uint16_t a_permutation[PARAMS_D], tern_secret_r secret_vector);
+#endif
+
+#ifdef AVX2
+// matmul_as_q with an inner product per row of A and 8 secrets, as it was
+// before the register-blocked kernel; kept to compare against
+#if PARAMS_TAU == 0
+void matmul_as_q_inner(modq_t d[PARAMS_D][PARAMS_N_BAR], modq_t a[PARAMS_D][PARAMS_D], tern_secret_s secret_vector);
+#elif PARAMS_TAU == 1
+void matmul_as_q_inner(modq_t d[PARAMS_D][PARAMS_N_BAR], const modq_t a[2 * PARAMS_D * PARAMS_D], const uint32_t a_permutation[PARAMS_D], tern_secret_s secret_vector);
+#else
+void matmul_as_q_inner(modq_t d[PARAMS_D][PARAMS_N_BAR], const modq_t a[PARAMS_TAU2_LEN + PARAMS_D], const uint16_t a_permutation[PARAMS_D], tern_secret_s secret_vector);
+#endif
 #endif
 
-void matmul_stu_p(modp_t d[PARAMS_MU], modp_t u_t[PARAMS_M_BAR][PARAMS_D], tern_secret_s secret_vector);
+void matmul_stu_p(modp_t d[PARAMS_MU], modp_t u_t[PARAMS_M_BAR][PARAMS_D], const tern_secret_s secret_vector);
 
 void matmul_btr_p(modp_t d[PARAMS_MU], modp_t b[PARAMS_D][PARAMS_N_BAR], tern_secret_r secret_vector);
 
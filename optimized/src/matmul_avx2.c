@@ -18,8 +18,6 @@
 
 //  This allows working on blocks of data < PARAMS_D.
 #define BLOCK_SIZE_COL PARAMS_D
-//  If > 1, this allows using multiple secrets in parallel.
-#define BLOCK_SIZE_ROW 1
 // Number of elements for which the operations are performed in parallel.
 #define BLOCK_AVX 16
 
@@ -58,7 +56,7 @@ static const int16_t mask[16] __attribute__ ((aligned(32))) =
 } ;
 #endif
 
-#define vGet(X)   _mm256_loadu_si256((__m256i*)(X))
+#define vGet(X)   _mm256_loadu_si256((const __m256i*)(X))
 #define vPut(X,Y) _mm256_storeu_si256((__m256i*)(X),Y)
 #define vSet(X)   _mm256_set1_epi16(X)
 #define vMul(X,Y) _mm256_mullo_epi16(X,Y)
@@ -74,8 +72,8 @@ modq_t vSum( __m256i v ) {
 
 // precondition: length vector >= BLOCK_AVX
 
-inline void inner1(modq_t *vx, int16_t *vy, modq_t *a) __attribute__ ((always_inline));
-void inner1 ( modq_t *vx, int16_t *vy, modq_t *a ) {
+inline void inner1(const modq_t *vx, const int16_t *vy, modq_t *a) __attribute__ ((always_inline));
+void inner1 ( const modq_t *vx, const int16_t *vy, modq_t *a ) {
     size_t c;
     register __m256i a256 = vMul(vGet(vx), vGet(vy));
 #if PARAMS_D % BLOCK_AVX != 0
@@ -137,8 +135,8 @@ void inner1 ( modq_t *vx, int16_t *vy, modq_t *a ) {
 #define a256M8(X) a256M7(X); acm(7,X);
 #define a256S8(A) a256S7(A); acs(7,A);
 
-inline void inner2(modq_t *vx, int16_t *vy, modq_t *a) __attribute__ ((always_inline));
-void inner2 ( modq_t *vx, int16_t *vy, modq_t *a ) {
+inline void inner2(const modq_t *vx, const int16_t *vy, modq_t *a) __attribute__ ((always_inline));
+void inner2 ( const modq_t *vx, const int16_t *vy, modq_t *a ) {
     size_t c;
     register __m256i xx = vGet(vx); a256I2(xx);
 #if PARAMS_D % BLOCK_AVX != 0
@@ -153,8 +151,8 @@ void inner2 ( modq_t *vx, int16_t *vy, modq_t *a ) {
     a256S2(a);
 }
 
-inline void inner3(modq_t *vx, int16_t *vy, modq_t *a) __attribute__ ((always_inline));
-void inner3 ( modq_t *vx, int16_t *vy, modq_t *a ) {
+inline void inner3(const modq_t *vx, const int16_t *vy, modq_t *a) __attribute__ ((always_inline));
+void inner3 ( const modq_t *vx, const int16_t *vy, modq_t *a ) {
     size_t c;
     register __m256i xx = vGet(vx); a256I3(xx);
 #if PARAMS_D % BLOCK_AVX != 0
@@ -169,8 +167,8 @@ void inner3 ( modq_t *vx, int16_t *vy, modq_t *a ) {
     a256S3(a);
 }
 
-inline void inner4(modq_t *vx, int16_t *vy, modq_t *a) __attribute__ ((always_inline));
-void inner4 ( modq_t *vx, int16_t *vy, modq_t *a ) {
+inline void inner4(const modq_t *vx, const int16_t *vy, modq_t *a) __attribute__ ((always_inline));
+void inner4 ( const modq_t *vx, const int16_t *vy, modq_t *a ) {
     size_t c;
     register __m256i xx = vGet(vx); a256I4(xx);
 #if PARAMS_D % BLOCK_AVX != 0
@@ -185,8 +183,8 @@ void inner4 ( modq_t *vx, int16_t *vy, modq_t *a ) {
     a256S4(a);
 }
 
-inline void inner5(modq_t *vx, int16_t *vy, modq_t *a) __attribute__ ((always_inline));
-void inner5 ( modq_t *vx, int16_t *vy, modq_t *a ) {
+inline void inner5(const modq_t *vx, const int16_t *vy, modq_t *a) __attribute__ ((always_inline));
+void inner5 ( const modq_t *vx, const int16_t *vy, modq_t *a ) {
     size_t c;
     register __m256i xx = vGet(vx); a256I5(xx);
 #if PARAMS_D % BLOCK_AVX != 0
@@ -201,8 +199,8 @@ void inner5 ( modq_t *vx, int16_t *vy, modq_t *a ) {
     a256S5(a);
 }
 
-inline void inner6(modq_t *vx, int16_t *vy, modq_t *a) __attribute__ ((always_inline));
-void inner6 ( modq_t *vx, int16_t *vy, modq_t *a ) {
+inline void inner6(const modq_t *vx, const int16_t *vy, modq_t *a) __attribute__ ((always_inline));
+void inner6 ( const modq_t *vx, const int16_t *vy, modq_t *a ) {
     size_t c;
     register __m256i xx = vGet(vx); a256I6(xx);
 #if PARAMS_D % BLOCK_AVX != 0
@@ -217,8 +215,8 @@ void inner6 ( modq_t *vx, int16_t *vy, modq_t *a ) {
     a256S6(a);
 }
 
-inline void inner7(modq_t *vx, int16_t *vy, modq_t *a) __attribute__ ((always_inline));
-void inner7 ( modq_t *vx, int16_t *vy, modq_t *a ) {
+inline void inner7(const modq_t *vx, const int16_t *vy, modq_t *a) __attribute__ ((always_inline));
+void inner7 ( const modq_t *vx, const int16_t *vy, modq_t *a ) {
     size_t c;
     register __m256i xx = vGet(vx); a256I7(xx);
 #if PARAMS_D % BLOCK_AVX != 0
@@ -233,8 +231,8 @@ void inner7 ( modq_t *vx, int16_t *vy, modq_t *a ) {
     a256S7(a);
 }
 
-// inline void inner8(modq_t *vx, int16_t *vy, modq_t *a) __attribute__ ((always_inline));
-void inner8 ( modq_t *vx, int16_t *vy, modq_t *a ) {
+// inline void inner8(const modq_t *vx, const int16_t *vy, modq_t *a) __attribute__ ((always_inline));
+void inner8 ( const modq_t *vx, const int16_t *vy, modq_t *a ) {
     size_t c;
     register __m256i xx = vGet(vx); a256I8(xx);
 #if PARAMS_D % BLOCK_AVX != 0
@@ -252,15 +250,15 @@ void inner8 ( modq_t *vx, int16_t *vy, modq_t *a ) {
 // Matrix a can be permted !
 
 #if PARAMS_TAU == 0
-#define matrix(A) A[PARAMS_D][PARAMS_D]
+#define matrix(A) modq_t A[PARAMS_D][PARAMS_D]
 #define access(A,R) A[R]
 
 #elif PARAMS_TAU == 1
-#define matrix(A) A[2 * PARAMS_D * PARAMS_D], uint32_t a_permutation[PARAMS_D]
+#define matrix(A) const modq_t A[2 * PARAMS_D * PARAMS_D], const uint32_t a_permutation[PARAMS_D]
 #define access(A,R) &A[a_permutation[R]]
 
 #elif PARAMS_TAU == 2
-#define matrix(A) A[PARAMS_TAU2_LEN + PARAMS_D], uint16_t a_permutation[PARAMS_D]
+#define matrix(A) const modq_t A[PARAMS_TAU2_LEN + PARAMS_D], const uint16_t a_permutation[PARAMS_D]
 #define access(A,R) &A[a_permutation[R]]
 #endif
 
@@ -285,7 +283,113 @@ void inner8 ( modq_t *vx, int16_t *vy, modq_t *a ) {
 //
 // B = A * S
 //
-void matmul_as_q(modq_t d[PARAMS_D][PARAMS_N_BAR], modq_t matrix(a), tern_secret_s secret_vector){
+
+// Register-blocked kernel: AS_Q_ROWS rows of A against up to AS_Q_SECRETS
+// secrets at once, with the AS_Q_ROWS * AS_Q_SECRETS partial inner products
+// kept in registers over the whole row and reduced together at the end.
+#define AS_Q_ROWS 2
+#define AS_Q_SECRETS 4
+
+// d0[k], d1[k] = inner(x0, y[k]), inner(x1, y[k]) for k < ns, y[k] = y + k * PARAMS_D
+inline void as_q_block(const modq_t *x0, const modq_t *x1, const int16_t *y, size_t ns, modq_t *d0, modq_t *d1) __attribute__ ((always_inline));
+void as_q_block(const modq_t *x0, const modq_t *x1, const int16_t *y, size_t ns, modq_t *d0, modq_t *d1) {
+    size_t c, k;
+    __m256i acc0[AS_Q_SECRETS], acc1[AS_Q_SECRETS];
+    __m256i xx0, xx1, yy, t0, t1, t2, t3;
+    __m128i sum;
+    modq_t out[AS_Q_ROWS * AS_Q_SECRETS] __attribute__ ((aligned(16)));
+#if PARAMS_D % BLOCK_AVX != 0
+    const __m256i m256 = vGet(&mask);
+#endif
+
+    for (k = 0; k < AS_Q_SECRETS; k++) {
+        acc0[k] = _mm256_setzero_si256();
+        acc1[k] = _mm256_setzero_si256();
+    }
+    for (c = 0; c < BLOCK_AVX * (PARAMS_D / BLOCK_AVX); c += BLOCK_AVX) {
+        xx0 = vGet(x0 + c);
+        xx1 = vGet(x1 + c);
+        for (k = 0; k < ns; k++) {
+            yy = vGet(y + k * PARAMS_D + c);
+            acc0[k] = vAdd(acc0[k], vMul(xx0, yy));
+            acc1[k] = vAdd(acc1[k], vMul(xx1, yy));
+        }
+    }
+#if PARAMS_D % BLOCK_AVX != 0
+    // the last, overlapping, vector with the elements already done masked out
+    xx0 = vGet(x0 + PARAMS_D - BLOCK_AVX) & m256;
+    xx1 = vGet(x1 + PARAMS_D - BLOCK_AVX) & m256;
+    for (k = 0; k < ns; k++) {
+        yy = vGet(y + k * PARAMS_D + PARAMS_D - BLOCK_AVX);
+        acc0[k] = vAdd(acc0[k], vMul(xx0, yy));
+        acc1[k] = vAdd(acc1[k], vMul(xx1, yy));
+    }
+#endif
+
+    // per 128-bit lane: acc0[0..3], acc1[0..3] summed to one element each
+    t0 = _mm256_hadd_epi16(acc0[0], acc0[1]);
+    t1 = _mm256_hadd_epi16(acc0[2], acc0[3]);
+    t2 = _mm256_hadd_epi16(acc1[0], acc1[1]);
+    t3 = _mm256_hadd_epi16(acc1[2], acc1[3]);
+    t0 = _mm256_hadd_epi16(t0, t1);
+    t2 = _mm256_hadd_epi16(t2, t3);
+    t0 = _mm256_hadd_epi16(t0, t2);
+    sum = _mm_add_epi16(_mm256_castsi256_si128(t0), _mm256_extracti128_si256(t0, 1));
+    _mm_store_si128((__m128i *) out, sum);
+
+    for (k = 0; k < ns; k++) {
+        d0[k] = out[k];
+        d1[k] = out[AS_Q_SECRETS + k];
+    }
+}
+
+// one or two rows of A (x1 == x0 and d1 a scratch row for one) against all secrets
+inline void as_q_rows(const modq_t *x0, const modq_t *x1, const int16_t *y, modq_t *d0, modq_t *d1) __attribute__ ((always_inline));
+void as_q_rows(const modq_t *x0, const modq_t *x1, const int16_t *y, modq_t *d0, modq_t *d1) {
+    size_t l;
+
+    for (l = 0; l < AS_Q_SECRETS * (PARAMS_N_BAR / AS_Q_SECRETS); l += AS_Q_SECRETS) {
+        as_q_block(x0, x1, y + l * PARAMS_D, AS_Q_SECRETS, d0 + l, d1 + l);
+    }
+#if PARAMS_N_BAR % AS_Q_SECRETS != 0
+    as_q_block(x0, x1, y + l * PARAMS_D, PARAMS_N_BAR % AS_Q_SECRETS, d0 + l, d1 + l);
+#endif
+}
+
+#if PARAMS_TAU == 0
+void matmul_as_q(modq_t d[PARAMS_D][PARAMS_N_BAR], matrix(a), tern_secret_s secret_vector){
+    matmul_as_q_rows(d, (const modq_t (*)[PARAMS_D]) a, PARAMS_D, secret_vector);
+}
+
+void matmul_as_q_rows(modq_t d[][PARAMS_N_BAR], const modq_t a[][PARAMS_D], size_t nrows, tern_secret_s secret_vector){
+    
+    size_t r;
+    modq_t scratch[PARAMS_N_BAR];
+
+    for (r = 0; r + 1 < nrows; r += AS_Q_ROWS) {
+        as_q_rows(a[r], a[r + 1], secret_vector[0], d[r], d[r + 1]);
+    }
+    if (r < nrows) {
+        as_q_rows(a[r], a[r], secret_vector[0], d[r], scratch);
+    }
+}
+#else
+void matmul_as_q(modq_t d[PARAMS_D][PARAMS_N_BAR], matrix(a), tern_secret_s secret_vector){
+    
+    size_t r;
+
+    for (r = 0; r + 1 < PARAMS_D; r += AS_Q_ROWS) {
+        as_q_rows(access(a,r), access(a,r + 1), secret_vector[0], d[r], d[r + 1]);
+    }
+#if PARAMS_D % AS_Q_ROWS != 0
+    modq_t scratch[PARAMS_N_BAR];
+    as_q_rows(access(a,r), access(a,r), secret_vector[0], d[r], scratch);
+#endif
+}
+#endif
+
+// matmul_as_q with one row of A and 8 secrets at a time (inner8)
+void matmul_as_q_inner(modq_t d[PARAMS_D][PARAMS_N_BAR], matrix(a), tern_secret_s secret_vector){
     
     size_t r, l;
     for (r = 0; r < PARAMS_D; r++) {
@@ -297,46 +401,153 @@ void matmul_as_q(modq_t d[PARAMS_D][PARAMS_N_BAR], modq_t matrix(a), tern_secret
     }
 }
 
-void matmul_rta_q(modq_t d[PARAMS_M_BAR][PARAMS_D], modq_t matrix(a), tern_secret_r secret_vector){
-    
-    size_t r, c, l;
-    modq_t * row __attribute__ ((aligned(32)));
-    
-    
-    __m256i accum[PARAMS_M_BAR * PARAMS_D / 16] __attribute__ ((aligned(32)));
-    for (l = 0; l < PARAMS_M_BAR; l++) {
-        for (c = 0; c < 16 * (PARAMS_D / 16); c += 16) {
-            accum[(l * BLOCK_SIZE_COL + c) >> 4] = _mm256_setzero_si256();
+//
+// U^T = R^T * A
+//
+
+// Register-tiled kernel: RTA_VECS vectors of columns of U^T for RTA_SECRETS
+// secrets at once, kept in registers over all the rows of A given. The rows
+// are reached through pointers, so that the kernel does not depend on how
+// A is laid out (tau 0, the rows of A_fixed or the windows on A_random).
+#if PARAMS_M_BAR >= 4
+#define RTA_SECRETS 4
+#else
+#define RTA_SECRETS PARAMS_M_BAR
+#endif
+#define RTA_VECS (8 / RTA_SECRETS)
+
+// d[k][c + v * BLOCK_AVX ..] += sum_l s[k * PARAMS_D + l] * row[l][c + v * BLOCK_AVX ..]
+// for k < ns, v < nv; masked: only the lanes of mask (the last vector of a row)
+inline void rta_block(modq_t *d, const modq_t *const *row, size_t nrows, const int16_t *s, size_t c, size_t nv, size_t ns, int masked) __attribute__ ((always_inline));
+void rta_block(modq_t *d, const modq_t *const *row, size_t nrows, const int16_t *s, size_t c, size_t nv, size_t ns, int masked) {
+    size_t l, k, v;
+    __m256i acc[RTA_SECRETS][RTA_VECS], x[RTA_VECS], sk;
+
+    for (k = 0; k < ns; k++) {
+        for (v = 0; v < nv; v++) {
+            acc[k][v] = _mm256_setzero_si256();
         }
     }
-    
-    memset(d, 0, PARAMS_M_BAR * PARAMS_D * sizeof (modq_t));
-    for (l = 0; l < PARAMS_D ; l++) {
-        row = access(a,l);
-        for (c = 0; c < (PARAMS_D/16) ; c+=1)
-        for (r = 0; r < PARAMS_M_BAR; r++)
-        {
-            accum[r * BLOCK_SIZE_COL / BLOCK_AVX + c] = vAdd( accum[r * BLOCK_SIZE_COL / BLOCK_AVX + c], vMul(vSet(secret_vector[r][l]), vGet(&row[c<<4])));
-            //vPut(&d[r][c], vAdd(vGet(&d[r][c]), vMul(vSet(r_t[r][l]), vGet(&row[c<<4]))));
+    for (l = 0; l < nrows; l++) {
+        for (v = 0; v < nv; v++) {
+            x[v] = vGet(row[l] + c + v * BLOCK_AVX);
+        }
+        for (k = 0; k < ns; k++) {
+            sk = vSet(s[k * PARAMS_D + l]);
+            for (v = 0; v < nv; v++) {
+                acc[k][v] = vAdd(acc[k][v], vMul(sk, x[v]));
+            }
         }
-#if PARAMS_D % 16 != 0
-        for (c = (PARAMS_D/16)*16 ;  c < PARAMS_D ;c++)
-        for (r = 0; r < PARAMS_M_BAR; r++)
-        d[r][c] +=  secret_vector[r][l] * row[c];
     }
+    for (k = 0; k < ns; k++) {
+        for (v = 0; v < nv; v++) {
+#if PARAMS_D % BLOCK_AVX != 0
+            if (masked) {
+                acc[k][v] = acc[k][v] & vGet(&mask);
+            }
+#else
+            (void) masked;
+#endif
+            vPut(d + k * PARAMS_D + c + v * BLOCK_AVX, vAdd(vGet(d + k * PARAMS_D + c + v * BLOCK_AVX), acc[k][v]));
+        }
+    }
+}
+
+// the columns c .. c + nv * BLOCK_AVX - 1 of U^T, for all secrets
+inline void rta_cols(modq_t d[PARAMS_M_BAR][PARAMS_D], const modq_t *const *row, size_t nrows, const int16_t *s, size_t c, size_t nv, int masked) __attribute__ ((always_inline));
+void rta_cols(modq_t d[PARAMS_M_BAR][PARAMS_D], const modq_t *const *row, size_t nrows, const int16_t *s, size_t c, size_t nv, int masked) {
+    size_t r;
+
+    for (r = 0; r + RTA_SECRETS <= PARAMS_M_BAR; r += RTA_SECRETS) {
+        rta_block(d[r], row, nrows, s + r * PARAMS_D, c, nv, RTA_SECRETS, masked);
+    }
+#if PARAMS_M_BAR % RTA_SECRETS != 0
+    rta_block(d[r], row, nrows, s + r * PARAMS_D, c, nv, PARAMS_M_BAR % RTA_SECRETS, masked);
+#endif
+}
+
+// d += R^T * A for the nrows rows of A given, s = &secret_vector[0][first row]
+static void rta_rows(modq_t d[PARAMS_M_BAR][PARAMS_D], const modq_t *const *row, size_t nrows, const int16_t *s) {
+    size_t c;
+
+    for (c = 0; c + RTA_VECS * BLOCK_AVX <= BLOCK_AVX * (PARAMS_D / BLOCK_AVX); c += RTA_VECS * BLOCK_AVX) {
+        rta_cols(d, row, nrows, s, c, RTA_VECS, 0);
+    }
+#if (PARAMS_D / BLOCK_AVX) % RTA_VECS != 0
+    rta_cols(d, row, nrows, s, c, (PARAMS_D / BLOCK_AVX) % RTA_VECS, 0);
+#endif
+#if PARAMS_D % BLOCK_AVX != 0
+    // the last, overlapping, vector with the columns already done masked out
+    rta_cols(d, row, nrows, s, PARAMS_D - BLOCK_AVX, 1, 1);
+#endif
+}
+
+#if PARAMS_TAU == 1 && PARAMS_M_BAR >= 4
+// tau 1: the rows of A_fixed are far apart, so they are copied, a few at a
+// time and each in one sequential sweep, into an aligned tile first. With
+// fewer secrets the copy costs more than it saves.
+#define RTA_TILE_ROWS 4
 #endif
-    for (l = 0; l < PARAMS_M_BAR; l++) {
-        for (c = 0; c < BLOCK_AVX * (BLOCK_SIZE_COL / BLOCK_AVX); c += BLOCK_AVX) {
-            _mm256_storeu_si256((__m256i *) &(d[l][c]), accum[(l * BLOCK_SIZE_COL + c) >> 4]);
+
+#if PARAMS_TAU == 0
+void matmul_rta_q(modq_t d[PARAMS_M_BAR][PARAMS_D], matrix(a), tern_secret_r secret_vector){
+
+    memset(d, 0, PARAMS_M_BAR * PARAMS_D * sizeof (modq_t));
+
+    matmul_rta_q_rows(d, (const modq_t (*)[PARAMS_D]) a, 0, PARAMS_D, secret_vector);
+}
+
+void matmul_rta_q_rows(modq_t d[PARAMS_M_BAR][PARAMS_D], const modq_t a[][PARAMS_D], size_t row0, size_t nrows, tern_secret_r secret_vector){
+
+    size_t l;
+    const modq_t *row[PARAMS_D];
+
+    for (l = 0; l < nrows; l++) {
+        row[l] = a[l];
+    }
+    rta_rows(d, row, nrows, &secret_vector[0][row0]);
+}
+#elif defined(RTA_TILE_ROWS)
+void matmul_rta_q(modq_t d[PARAMS_M_BAR][PARAMS_D], matrix(a), tern_secret_r secret_vector){
+
+    size_t l, t, n;
+    modq_t tile[RTA_TILE_ROWS][BLOCK_AVX * CEIL_DIV(PARAMS_D, BLOCK_AVX)] __attribute__ ((aligned(32)));
+    const modq_t *row[RTA_TILE_ROWS];
+
+    memset(d, 0, PARAMS_M_BAR * PARAMS_D * sizeof (modq_t));
+    for (l = 0; l < RTA_TILE_ROWS; l++) {
+        row[l] = tile[l];
+    }
+    for (t = 0; t < PARAMS_D; t += RTA_TILE_ROWS) {
+        n = PARAMS_D - t < RTA_TILE_ROWS ? PARAMS_D - t : RTA_TILE_ROWS;
+        for (l = 0; l < n; l++) {
+            memcpy(tile[l], access(a,t + l), PARAMS_D * sizeof (modq_t));
         }
+        rta_rows(d, row, n, &secret_vector[0][t]);
     }
 }
+#else
+// the rows read in place; for tau 2 they are windows on A_random
+// (PARAMS_TAU2_LEN + PARAMS_D elements, with its start repeated at the end),
+// which stays in cache
+void matmul_rta_q(modq_t d[PARAMS_M_BAR][PARAMS_D], matrix(a), tern_secret_r secret_vector){
+
+    size_t l;
+    const modq_t *row[PARAMS_D];
+
+    for (l = 0; l < PARAMS_D; l++) {
+        row[l] = access(a,l);
+    }
+    memset(d, 0, PARAMS_M_BAR * PARAMS_D * sizeof (modq_t));
+    rta_rows(d, row, PARAMS_D, secret_vector[0]);
+}
+#endif
 
 //
 // X' = S^T * U
 //
 // assumption: PARAMS_MU <= PARAMS_N_BAR * PARAMS_N_BAR
-void matmul_stu_p(modp_t d[PARAMS_MU], modp_t u_t[PARAMS_M_BAR][PARAMS_D], tern_secret_s secret_vector){
+void matmul_stu_p(modp_t d[PARAMS_MU], modp_t u_t[PARAMS_M_BAR][PARAMS_D], const tern_secret_s secret_vector){
     
     size_t l, j;
     size_t index = 0;
@@ -344,4 +555,134 @@ void matmul_stu_p(modp_t d[PARAMS_MU], modp_t u_t[PARAMS_M_BAR][PARAMS_D], tern_
     for (j = 0; j < PARAMS_M_BAR && index < PARAMS_MU; j++)
     Inner(1)(u_t[j], secret_vector[l], &d[index++]);
 }
+//
+// X = B^T * R, only the PARAMS_MU elements that are used
+//
+
+// the columns of B that take part in the PARAMS_MU elements
+#define BTR_COLS CEIL_DIV(PARAMS_MU, PARAMS_M_BAR)
+
+#if PARAMS_P_BITS <= 8
+#define vGetP(X)  _mm_cvtepu8_epi16(_mm_loadl_epi64((__m128i*)(X)))
+#define vGetP16(X) _mm256_cvtepu8_epi16(_mm_loadu_si128((__m128i*)(X)))
+#else
+#define vGetP(X)  _mm_loadu_si128((__m128i*)(X))
+#define vGetP16(X) vGet(X)
+#endif
+
+#if PARAMS_N_BAR < BLOCK_AVX
+
+// Narrow B: its needed columns are transposed into rows, which are then
+// multiplied with the secrets by the matmul_as_q kernel.
+void matmul_btr_p(modp_t d[PARAMS_MU], modp_t b[PARAMS_D][PARAMS_N_BAR], tern_secret_r secret_vector) {
+
+    size_t i, j, l;
+    modq_t b_t[BTR_COLS][PARAMS_D] __attribute__ ((aligned(32)));
+    modq_t x[BTR_COLS + 1][PARAMS_M_BAR];
+
+    i = 0;
+#if PARAMS_N_BAR == 8
+    // 8 x 8 transposes, 8 rows of B at a time
+    __m128i r0, r1, r2, r3, r4, r5, r6, r7, t0, t1, t2, t3, t4, t5, t6, t7;
+    __m128i col[8];
+    for (; i + 8 <= PARAMS_D; i += 8) {
+        r0 = vGetP(b[i]);     r1 = vGetP(b[i + 1]); r2 = vGetP(b[i + 2]); r3 = vGetP(b[i + 3]);
+        r4 = vGetP(b[i + 4]); r5 = vGetP(b[i + 5]); r6 = vGetP(b[i + 6]); r7 = vGetP(b[i + 7]);
+        t0 = _mm_unpacklo_epi16(r0, r1); t1 = _mm_unpackhi_epi16(r0, r1);
+        t2 = _mm_unpacklo_epi16(r2, r3); t3 = _mm_unpackhi_epi16(r2, r3);
+        t4 = _mm_unpacklo_epi16(r4, r5); t5 = _mm_unpackhi_epi16(r4, r5);
+        t6 = _mm_unpacklo_epi16(r6, r7); t7 = _mm_unpackhi_epi16(r6, r7);
+        r0 = _mm_unpacklo_epi32(t0, t2); r1 = _mm_unpackhi_epi32(t0, t2);
+        r2 = _mm_unpacklo_epi32(t1, t3); r3 = _mm_unpackhi_epi32(t1, t3);
+        r4 = _mm_unpacklo_epi32(t4, t6); r5 = _mm_unpackhi_epi32(t4, t6);
+        r6 = _mm_unpacklo_epi32(t5, t7); r7 = _mm_unpackhi_epi32(t5, t7);
+        col[0] = _mm_unpacklo_epi64(r0, r4); col[1] = _mm_unpackhi_epi64(r0, r4);
+        col[2] = _mm_unpacklo_epi64(r1, r5); col[3] = _mm_unpackhi_epi64(r1, r5);
+        col[4] = _mm_unpacklo_epi64(r2, r6); col[5] = _mm_unpackhi_epi64(r2, r6);
+        col[6] = _mm_unpacklo_epi64(r3, r7); col[7] = _mm_unpackhi_epi64(r3, r7);
+        for (l = 0; l < BTR_COLS; l++) {
+            _mm_storeu_si128((__m128i *) &b_t[l][i], col[l]);
+        }
+    }
+#endif
+    for (; i < PARAMS_D; i++) {
+        for (l = 0; l < BTR_COLS; l++) {
+            b_t[l][i] = b[i][l];
+        }
+    }
+
+    for (l = 0; l < BTR_COLS; l += AS_Q_ROWS) {
+        // with an odd number of columns, the last one is done twice
+        const modq_t *x1 = l + 1 < BTR_COLS ? b_t[l + 1] : b_t[l];
+        for (j = 0; j < AS_Q_SECRETS * (PARAMS_M_BAR / AS_Q_SECRETS); j += AS_Q_SECRETS) {
+            as_q_block(b_t[l], x1, secret_vector[j], AS_Q_SECRETS, &x[l][j], &x[l + 1][j]);
+        }
+#if PARAMS_M_BAR % AS_Q_SECRETS != 0
+        as_q_block(b_t[l], x1, secret_vector[j], PARAMS_M_BAR % AS_Q_SECRETS, &x[l][j], &x[l + 1][j]);
+#endif
+    }
+
+    for (i = 0; i < PARAMS_MU; i++) {
+        d[i] = (modp_t) x[i / PARAMS_M_BAR][i % PARAMS_M_BAR];
+    }
+}
+
+#else
+
+// Wide B: vectors along the rows of B, the secret coefficients broadcast,
+// with BTR_VECS vectors of columns kept in registers over all rows.
+#define BTR_VECS 12
+
+// x[k * BLOCK_AVX ..] += b[i][c0 + k * BLOCK_AVX ..] * r[i] for k < nv, all rows i
+inline void btr_block(__m256i *x, modp_t b[PARAMS_D][PARAMS_N_BAR], size_t c0, const int16_t *r, size_t nv) __attribute__ ((always_inline));
+void btr_block(__m256i *x, modp_t b[PARAMS_D][PARAMS_N_BAR], size_t c0, const int16_t *r, size_t nv) {
+    size_t i, k;
+    __m256i acc[BTR_VECS], s;
+
+    for (k = 0; k < nv; k++) {
+        acc[k] = _mm256_setzero_si256();
+    }
+    for (i = 0; i < PARAMS_D; i++) {
+        s = vSet(r[i]);
+        for (k = 0; k < nv; k++) {
+            acc[k] = vAdd(acc[k], vMul(s, vGetP16(&b[i][c0 + k * BLOCK_AVX])));
+        }
+    }
+    for (k = 0; k < nv; k++) {
+        x[k] = acc[k];
+    }
+}
+
+void matmul_btr_p(modp_t d[PARAMS_MU], modp_t b[PARAMS_D][PARAMS_N_BAR], tern_secret_r secret_vector) {
+
+    size_t i, j, c;
+    __m256i x_t[PARAMS_M_BAR][CEIL_DIV(BTR_COLS, BLOCK_AVX)];
+    modq_t *x;
+
+    for (j = 0; j < PARAMS_M_BAR; j++) {
+        for (c = 0; c + BTR_VECS * BLOCK_AVX <= BLOCK_AVX * (BTR_COLS / BLOCK_AVX); c += BTR_VECS * BLOCK_AVX) {
+            btr_block(&x_t[j][c / BLOCK_AVX], b, c, secret_vector[j], BTR_VECS);
+        }
+#if (BTR_COLS / BLOCK_AVX) % BTR_VECS != 0
+        btr_block(&x_t[j][c / BLOCK_AVX], b, c, secret_vector[j], (BTR_COLS / BLOCK_AVX) % BTR_VECS);
+#endif
+#if BTR_COLS % BLOCK_AVX != 0
+        // the last columns, one at a time
+        x = (modq_t *) x_t[j];
+        for (c = BLOCK_AVX * (BTR_COLS / BLOCK_AVX); c < BTR_COLS; c++) {
+            x[c] = 0;
+            for (i = 0; i < PARAMS_D; i++) {
+                x[c] = (modq_t) (x[c] + b[i][c] * secret_vector[j][i]);
+            }
+        }
+#endif
+    }
+
+    for (i = 0; i < PARAMS_MU; i++) {
+        x = (modq_t *) x_t[i % PARAMS_M_BAR];
+        d[i] = (modp_t) x[i / PARAMS_M_BAR];
+    }
+}
+
+#endif
 #endif /* PARAMS_K !=1 && defined(AVX2) */
@@ -19,24 +19,17 @@
 #if PARAMS_TAU == 0
 
 void matmul_as_q(modq_t d[PARAMS_D][PARAMS_N_BAR], modq_t a[PARAMS_D][PARAMS_D], tern_secret_s  s_t) {
+    matmul_as_q_rows(d, (const modq_t (*)[PARAMS_D]) a, PARAMS_D, s_t);
+}
 
-#elif PARAMS_TAU == 1
-
-void matmul_as_q(modq_t d[PARAMS_D][PARAMS_N_BAR], modq_t a[2 * PARAMS_D * PARAMS_D], uint32_t a_permutation[PARAMS_D], tern_secret_s  s_t) {
-
-#else
-
-void matmul_as_q(modq_t d[PARAMS_D][PARAMS_N_BAR], modq_t a[PARAMS_TAU2_LEN + PARAMS_D], uint16_t a_permutation[PARAMS_D], tern_secret_s s_t) {
-
-#endif
+void matmul_as_q_rows(modq_t d[][PARAMS_N_BAR], const modq_t a[][PARAMS_D], size_t nrows, tern_secret_s s_t) {
     size_t i, j, l;
 
     // Initialize result
-    memset(d, 0, PARAMS_N_BAR * PARAMS_D * sizeof (modq_t));
+    memset(d, 0, PARAMS_N_BAR * nrows * sizeof (modq_t));
 
-#if PARAMS_TAU == 0
 #define A_element(x) a[j][s_t[l][i][x]]
-    for (j = 0; j < PARAMS_D; j++) {
+    for (j = 0; j < nrows; j++) {
         for (l = 0; l < PARAMS_N_BAR; l++) {
             for (i = 0; i < PARAMS_H / 2; i++) {
                 d[j][l] = (modq_t) (d[j][l] + (A_element(0) - A_element(1)));
@@ -44,17 +37,34 @@ void matmul_as_q(modq_t d[PARAMS_D][PARAMS_N_BAR], modq_t a[PARAMS_TAU2_LEN + PA
         }
     }
 #undef A_element
+}
+
 #else
+
+#if PARAMS_TAU == 1
+
+void matmul_as_q(modq_t d[PARAMS_D][PARAMS_N_BAR], const modq_t a[2 * PARAMS_D * PARAMS_D], const uint32_t a_permutation[PARAMS_D], tern_secret_s  s_t) {
+
+#else
+
+void matmul_as_q(modq_t d[PARAMS_D][PARAMS_N_BAR], const modq_t a[PARAMS_TAU2_LEN + PARAMS_D], const uint16_t a_permutation[PARAMS_D], tern_secret_s s_t) {
+
+#endif
+    size_t i, j, l;
+
+    // Initialize result
+    memset(d, 0, PARAMS_N_BAR * PARAMS_D * sizeof (modq_t));
+
     for (l = 0; l < PARAMS_N_BAR; l++) {
         for (i = 0; i < PARAMS_H / 2 - 3; i += 4) {
-            modq_t *a_add0 = &a[s_t[l][i + 0][0]];
-            modq_t *a_sub0 = &a[s_t[l][i + 0][1]];
-            modq_t *a_add1 = &a[s_t[l][i + 1][0]];
-            modq_t *a_sub1 = &a[s_t[l][i + 1][1]];
-            modq_t *a_add2 = &a[s_t[l][i + 2][0]];
-            modq_t *a_sub2 = &a[s_t[l][i + 2][1]];
-            modq_t *a_add3 = &a[s_t[l][i + 3][0]];
-            modq_t *a_sub3 = &a[s_t[l][i + 3][1]];
+            const modq_t *a_add0 = &a[s_t[l][i + 0][0]];
+            const modq_t *a_sub0 = &a[s_t[l][i + 0][1]];
+            const modq_t *a_add1 = &a[s_t[l][i + 1][0]];
+            const modq_t *a_sub1 = &a[s_t[l][i + 1][1]];
+            const modq_t *a_add2 = &a[s_t[l][i + 2][0]];
+            const modq_t *a_sub2 = &a[s_t[l][i + 2][1]];
+            const modq_t *a_add3 = &a[s_t[l][i + 3][0]];
+            const modq_t *a_sub3 = &a[s_t[l][i + 3][1]];
             modq_t *dst = &d[0][l];
             size_t dst_idx = 0;
             for (j = 0; j < PARAMS_D; j++) {
@@ -64,8 +74,8 @@ void matmul_as_q(modq_t d[PARAMS_D][PARAMS_N_BAR], modq_t a[PARAMS_TAU2_LEN + PA
             }
         }
         while (i < PARAMS_H / 2) {
-            modq_t *a_add = &a[s_t[l][i][0]];
-            modq_t *a_sub = &a[s_t[l][i][1]];
+            const modq_t *a_add = &a[s_t[l][i][0]];
+            const modq_t *a_sub = &a[s_t[l][i][1]];
             modq_t *dst = &d[0][l];
             size_t dst_idx = 0;
             for (j = 0; j < PARAMS_D; j++) {
@@ -76,9 +86,10 @@ void matmul_as_q(modq_t d[PARAMS_D][PARAMS_N_BAR], modq_t a[PARAMS_TAU2_LEN + PA
             ++i;
         }
     }
-#endif
 }
 
+#endif
+
 
 
 // U^T = R^T * A
@@ -87,13 +98,47 @@ void matmul_as_q(modq_t d[PARAMS_D][PARAMS_N_BAR], modq_t a[PARAMS_TAU2_LEN + PA
 
 void matmul_rta_q(modq_t d[PARAMS_M_BAR][PARAMS_D], modq_t a[PARAMS_D][PARAMS_D], tern_secret_r r_t) {
 
-#elif PARAMS_TAU == 1
+    // Initialize result
+    memset(d, 0, PARAMS_M_BAR * PARAMS_D * sizeof (modq_t));
+
+    matmul_rta_q_rows(d, (const modq_t (*)[PARAMS_D]) a, 0, PARAMS_D, r_t);
+}
 
-void matmul_rta_q(modq_t d[PARAMS_M_BAR][PARAMS_D], modq_t a[2 * PARAMS_D * PARAMS_D], uint32_t a_permutation[PARAMS_D], tern_secret_r r_t) {
+void matmul_rta_q_rows(modq_t d[PARAMS_M_BAR][PARAMS_D], const modq_t a[][PARAMS_D], size_t row0, size_t nrows, tern_secret_r r_t) {
+    size_t i, j, l, k0, k1;
+
+    // indices of rows outside of row0 .. row0 + nrows - 1 wrap around to
+    // k >= nrows
+    for (l = 0; l < PARAMS_M_BAR; l++) {
+        for (i = 0; i < PARAMS_H / 2; i++) {
+            k0 = r_t[l][i][0] - row0;
+            k1 = r_t[l][i][1] - row0;
+            if (k0 < nrows && k1 < nrows) {
+                for (j = 0; j < PARAMS_D; j++) {
+                    d[l][j] = (modq_t) (d[l][j] + a[k0][j] - a[k1][j]);
+                }
+            } else if (k0 < nrows) {
+                for (j = 0; j < PARAMS_D; j++) {
+                    d[l][j] = (modq_t) (d[l][j] + a[k0][j]);
+                }
+            } else if (k1 < nrows) {
+                for (j = 0; j < PARAMS_D; j++) {
+                    d[l][j] = (modq_t) (d[l][j] - a[k1][j]);
+                }
+            }
+        }
+    }
+}
+
+#else
+
+#if PARAMS_TAU == 1
+
+void matmul_rta_q(modq_t d[PARAMS_M_BAR][PARAMS_D], const modq_t a[2 * PARAMS_D * PARAMS_D], const uint32_t a_permutation[PARAMS_D], tern_secret_r r_t) {
 
 #else
 
-void matmul_rta_q(modq_t d[PARAMS_M_BAR][PARAMS_D], modq_t a[PARAMS_TAU2_LEN + PARAMS_D], uint16_t a_permutation[PARAMS_D], tern_secret_r r_t) {
+void matmul_rta_q(modq_t d[PARAMS_M_BAR][PARAMS_D], const modq_t a[PARAMS_TAU2_LEN + PARAMS_D], const uint16_t a_permutation[PARAMS_D], tern_secret_r r_t) {
 
 #endif
     size_t i, j, l;
@@ -101,17 +146,13 @@ void matmul_rta_q(modq_t d[PARAMS_M_BAR][PARAMS_D], modq_t a[PARAMS_TAU2_LEN + P
     // Initialize result
     memset(d, 0, PARAMS_M_BAR * PARAMS_D * sizeof (modq_t));
 
-#if PARAMS_TAU == 0
-#define A_element(x) a[r_t[l][i][x]][j]
-#else
 #define A_element(x) a[a_permutation[r_t[l][i][x]] + j]
-#endif
 
     for (l = 0; l < PARAMS_M_BAR; l++) {
         for (i = 0; i < PARAMS_H / 2; i++) {
             j = 0;
-            modq_t *a_add = &A_element(0);
-            modq_t *a_sub = &A_element(1);
+            const modq_t *a_add = &A_element(0);
+            const modq_t *a_sub = &A_element(1);
             for (j = 0; j < PARAMS_D; j++) {
                 d[l][j] = (modq_t) (d[l][j] + a_add[j] - a_sub[j]);
             }
@@ -120,10 +161,12 @@ void matmul_rta_q(modq_t d[PARAMS_M_BAR][PARAMS_D], modq_t a[PARAMS_TAU2_LEN + P
 #undef A_element
 }
 
+#endif
+
 
 // X' = S^T * U
 
-void matmul_stu_p(modp_t d[PARAMS_MU], modp_t u_t[PARAMS_M_BAR][PARAMS_D], tern_secret_s s_t) {
+void matmul_stu_p(modp_t d[PARAMS_MU], modp_t u_t[PARAMS_M_BAR][PARAMS_D], const tern_secret_s s_t) {
     size_t k, i, j;
 
     // Initialize result
@@ -16,10 +16,28 @@
 
 #if PARAMS_TAU == 0
 void matmul_as_q(modq_t d[PARAMS_D][PARAMS_N_BAR], modq_t a[PARAMS_D][PARAMS_D], tern_secret_s secret_vector) {
-#elif PARAMS_TAU == 1
-void matmul_as_q(modq_t d[PARAMS_D][PARAMS_N_BAR], modq_t a[2 * PARAMS_D * PARAMS_D], uint32_t a_permutation[PARAMS_D], tern_secret_s secret_vector) {
+    matmul_as_q_rows(d, (const modq_t (*)[PARAMS_D]) a, PARAMS_D, secret_vector);
+}
+
+void matmul_as_q_rows(modq_t d[][PARAMS_N_BAR], const modq_t a[][PARAMS_D], size_t nrows, tern_secret_s secret_vector) {
+    size_t i, j, l;
+
+    // Initialize result
+    memset(d, 0, PARAMS_N_BAR * nrows * sizeof (modq_t));
+
+    for (j = 0; j < nrows; j++) {
+        for (l = 0; l < PARAMS_N_BAR; l++) {
+            for (i = 0; i < PARAMS_D; i++) {
+                d[j][l] = (modq_t) (d[j][l] + secret_vector[l][i] * a[j][i]);
+            }
+        }
+    }
+}
+#else
+#if PARAMS_TAU == 1
+void matmul_as_q(modq_t d[PARAMS_D][PARAMS_N_BAR], const modq_t a[2 * PARAMS_D * PARAMS_D], const uint32_t a_permutation[PARAMS_D], tern_secret_s secret_vector) {
 #else
-void matmul_as_q(modq_t d[PARAMS_D][PARAMS_N_BAR], modq_t a[PARAMS_TAU2_LEN + PARAMS_D], uint16_t a_permutation[PARAMS_D], tern_secret_s secret_vector) {
+void matmul_as_q(modq_t d[PARAMS_D][PARAMS_N_BAR], const modq_t a[PARAMS_TAU2_LEN + PARAMS_D], const uint16_t a_permutation[PARAMS_D], tern_secret_s secret_vector) {
 #endif
     size_t i, j, l;
 
@@ -27,11 +45,7 @@ void matmul_as_q(modq_t d[PARAMS_D][PARAMS_N_BAR], modq_t a[PARAMS_TAU2_LEN + PA
     memset(d, 0, PARAMS_N_BAR * PARAMS_D * sizeof (modq_t));
 
 #undef A_coeff
-#if PARAMS_TAU == 0
-#define A_coeff(j, i) a[j][i]
-#else
 #define A_coeff(j, i) a[a_permutation[j] + i]
-#endif
     for (j = 0; j < PARAMS_D; j++) {
         for (l = 0; l < PARAMS_N_BAR; l++) {
             for (i = 0; i < PARAMS_D; i++) {
@@ -42,15 +56,35 @@ void matmul_as_q(modq_t d[PARAMS_D][PARAMS_N_BAR], modq_t a[PARAMS_TAU2_LEN + PA
 
 #undef A_coeff
 }
+#endif
 
 // U^T = R^T * A
 
 #if PARAMS_TAU == 0
 void matmul_rta_q(modq_t d[PARAMS_M_BAR][PARAMS_D], modq_t a[PARAMS_D][PARAMS_D], tern_secret_r secret_vector) {
-#elif PARAMS_TAU == 1
-void matmul_rta_q(modq_t d[PARAMS_M_BAR][PARAMS_D], modq_t a[2 * PARAMS_D * PARAMS_D], uint32_t a_permutation[PARAMS_D], tern_secret_r secret_vector) {
+
+    // Initialize result
+    memset(d, 0, PARAMS_M_BAR * PARAMS_D * sizeof (modq_t));
+
+    matmul_rta_q_rows(d, (const modq_t (*)[PARAMS_D]) a, 0, PARAMS_D, secret_vector);
+}
+
+void matmul_rta_q_rows(modq_t d[PARAMS_M_BAR][PARAMS_D], const modq_t a[][PARAMS_D], size_t row0, size_t nrows, tern_secret_r secret_vector) {
+    size_t i, j, l;
+
+    for (i = 0; i < nrows; i++) {
+        for (j = 0; j < PARAMS_D; j++) {
+            for (l = 0; l < PARAMS_M_BAR; l++) {
+                d[l][j] = (modq_t) (d[l][j] + secret_vector[l][row0 + i] * a[i][j]);
+            }
+        }
+    }
+}
 #else
-void matmul_rta_q(modq_t d[PARAMS_M_BAR][PARAMS_D], modq_t a[PARAMS_TAU2_LEN + PARAMS_D], uint16_t a_permutation[PARAMS_D], tern_secret_r secret_vector) {
+#if PARAMS_TAU == 1
+void matmul_rta_q(modq_t d[PARAMS_M_BAR][PARAMS_D], const modq_t a[2 * PARAMS_D * PARAMS_D], const uint32_t a_permutation[PARAMS_D], tern_secret_r secret_vector) {
+#else
+void matmul_rta_q(modq_t d[PARAMS_M_BAR][PARAMS_D], const modq_t a[PARAMS_TAU2_LEN + PARAMS_D], const uint16_t a_permutation[PARAMS_D], tern_secret_r secret_vector) {
 #endif
     size_t i, j, l;
 
@@ -58,11 +92,7 @@ void matmul_rta_q(modq_t d[PARAMS_M_BAR][PARAMS_D], modq_t a[PARAMS_TAU2_LEN + P
     memset(d, 0, PARAMS_M_BAR * PARAMS_D * sizeof (modq_t));
 
 #undef A_coeff
-#if PARAMS_TAU == 0
-#define A_coeff(i, j) a[i][j]
-#else
 #define A_coeff(i, j) a[a_permutation[i] + j]
-#endif
     for (i = 0; i < PARAMS_D; i++) {
         for (j = 0; j < PARAMS_D; j++) {
             for (l = 0; l < PARAMS_M_BAR; l++) {
@@ -72,10 +102,11 @@ void matmul_rta_q(modq_t d[PARAMS_M_BAR][PARAMS_D], modq_t a[PARAMS_TAU2_LEN + P
     }
 #undef A_coeff
 }
+#endif
 
 // X' = S^T * U
 
-void matmul_stu_p(modp_t d[PARAMS_MU], modp_t u_t[PARAMS_M_BAR][PARAMS_D], tern_secret_s secret_vector) {
+void matmul_stu_p(modp_t d[PARAMS_MU], modp_t u_t[PARAMS_M_BAR][PARAMS_D], const tern_secret_s secret_vector) {
     size_t i, l, j;
 
     // Initialize result
@@ -92,9 +123,6 @@ void matmul_stu_p(modp_t d[PARAMS_MU], modp_t u_t[PARAMS_M_BAR][PARAMS_D], tern_
     }
 }
 
-
-#endif /* !AVX2 */
-
 // X = B^T * R
 
 void matmul_btr_p(modp_t d[PARAMS_MU], modp_t b[PARAMS_D][PARAMS_N_BAR], tern_secret_r secret_vector) {
@@ -114,4 +142,6 @@ void matmul_btr_p(modp_t d[PARAMS_MU], modp_t b[PARAMS_D][PARAMS_N_BAR], tern_se
     }
 }
 
+#endif /* !AVX2 */
+
 #endif /* PARAMS_K !=1 && (defined(CM_CT) || defined(CM_CACHE)) */
@@ -1,4 +1,3 @@
-
 /*
  * Copyright (c) 2020, Koninklijke Philips N.V.
  */
@@ -9,17 +8,194 @@
 #include <stdint.h>
 #include <string.h>
 
+#if defined(AVX2)
+#include <immintrin.h>
+
+/*
+ * AVX2 kernels, for fields of up to 12 bits. They pack 16 values at a time
+ * into 2 * bits bytes, 8 values (bits bytes) in each 128-bit lane: pairs of
+ * values are merged into 32-bit words and pairs of those into 64-bit words,
+ * of 4 * bits bits, whose bytes are then put together with byte shuffles.
+ * Unpacking shuffles the (at most four) bytes of each value into a 32-bit
+ * word, and shifts and masks it into place.
+ *
+ * 16 values take a whole number of bytes, so the kernels go from a byte
+ * boundary to the next. They write, or read, 16 - bits bytes beyond the
+ * 2 * bits bytes of the values; the last values of a buffer go through a
+ * buffer on the stack.
+ */
+
+typedef struct {
+    __m256i lo, hi; // byte shuffles of the first and second word (or half) of a lane
+    __m256i shift_lo, shift_hi; // unpacking: the shifts of the values
+} pack_avx2_t;
+
+static void pack_avx2_init(pack_avx2_t *k, const unsigned bits) {
+    uint8_t lo[32], hi[32];
+    unsigned l, i;
+
+    // the second word of a lane starts at bit 4 * bits, halfway a byte if
+    // bits is odd (it is shifted by 4 bits to line up with it)
+    memset(lo, 0x80, sizeof (lo));
+    memset(hi, 0x80, sizeof (hi));
+    for (l = 0; l < 32; l += 16) {
+        for (i = 0; i < (4 * bits + 7) / 8; i++) {
+            lo[l + i] = (uint8_t) i;
+        }
+        for (i = 0; (4 * bits) / 8 + i < bits; i++) {
+            hi[l + (4 * bits) / 8 + i] = (uint8_t) (8 + i);
+        }
+    }
+    k->lo = _mm256_loadu_si256((const __m256i *) lo);
+    k->hi = _mm256_loadu_si256((const __m256i *) hi);
+}
+
+static void unpack_avx2_init(pack_avx2_t *k, const unsigned bits) {
+    uint8_t lo[32], hi[32];
+    unsigned l, i, b;
+
+    for (l = 0; l < 32; l += 16) {
+        for (i = 0; i < 4; i++) {
+            for (b = 0; b < 4; b++) {
+                lo[l + 4 * i + b] = (uint8_t) ((i * bits) / 8 + b);
+                hi[l + 4 * i + b] = (uint8_t) (((i + 4) * bits) / 8 + b);
+            }
+        }
+    }
+    k->lo = _mm256_loadu_si256((const __m256i *) lo);
+    k->hi = _mm256_loadu_si256((const __m256i *) hi);
+    k->shift_lo = _mm256_setr_epi32(0, (int) (bits & 7), (int) ((2 * bits) & 7), (int) ((3 * bits) & 7),
+                                    0, (int) (bits & 7), (int) ((2 * bits) & 7), (int) ((3 * bits) & 7));
+    k->shift_hi = _mm256_setr_epi32((int) ((4 * bits) & 7), (int) ((5 * bits) & 7), (int) ((6 * bits) & 7), (int) ((7 * bits) & 7),
+                                    (int) ((4 * bits) & 7), (int) ((5 * bits) & 7), (int) ((6 * bits) & 7), (int) ((7 * bits) & 7));
+}
+
+// packs the 16 (16-bit) values of x into pv[0 .. 2 * bits - 1], writes up to pv[bits + 15]
+static inline void pack_avx2(uint8_t *pv, __m256i x, const pack_avx2_t *k, const unsigned bits) {
+    x = _mm256_madd_epi16(x, _mm256_set1_epi32((int) ((1U << (16 + bits)) | 1)));
+    x = _mm256_or_si256(_mm256_and_si256(x, _mm256_set1_epi64x(0xffffffff)), _mm256_slli_epi64(_mm256_srli_epi64(x, 32), (int) (2 * bits)));
+    if (bits & 1) {
+        x = _mm256_sllv_epi64(x, _mm256_setr_epi64x(0, 4, 0, 4));
+    }
+    x = _mm256_or_si256(_mm256_shuffle_epi8(x, k->lo), _mm256_shuffle_epi8(x, k->hi));
+    _mm_storeu_si128((__m128i *) pv, _mm256_castsi256_si128(x));
+    _mm_storeu_si128((__m128i *) (pv + bits), _mm256_extracti128_si256(x, 1));
+}
+
+// unpacks 16 (16-bit) values from pv[0 .. 2 * bits - 1], reads up to pv[bits + 15]
+static inline __m256i unpack_avx2(const uint8_t *pv, const pack_avx2_t *k, const unsigned bits) {
+    const __m256i mask = _mm256_set1_epi32((1 << bits) - 1);
+    __m256i x, lo, hi;
+
+    x = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_loadu_si128((const __m128i *) pv)), _mm_loadu_si128((const __m128i *) (pv + bits)), 1);
+    lo = _mm256_and_si256(_mm256_srlv_epi32(_mm256_shuffle_epi8(x, k->lo), k->shift_lo), mask);
+    hi = _mm256_and_si256(_mm256_srlv_epi32(_mm256_shuffle_epi8(x, k->hi), k->shift_hi), mask);
+
+    return _mm256_packus_epi32(lo, hi);
+}
+
+// the lanes of the values before n
+static inline __m256i lanes_below(size_t n) {
+    return _mm256_cmpgt_epi16(_mm256_set1_epi16((short) (n < 16 ? n : 16)), _mm256_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+}
+
+// packs the 16 values of x at byte o of the size bytes of pv, and unpacks
+// the 16 values there; near the end of pv through a buffer
+static inline void pack_at_avx2(uint8_t *pv, size_t size, size_t o, __m256i x, const pack_avx2_t *k, const unsigned bits) {
+    uint8_t buf[32];
+
+    if (o + bits + 16 <= size) {
+        pack_avx2(pv + o, x, k, bits);
+    } else {
+        pack_avx2(buf, x, k, bits);
+        memcpy(pv + o, buf, size - o < 2 * bits ? size - o : 2 * bits);
+    }
+}
+
+static inline __m256i unpack_at_avx2(const uint8_t *pv, size_t size, size_t o, const pack_avx2_t *k, const unsigned bits) {
+    uint8_t buf[32];
+
+    if (o + bits + 16 <= size) {
+        return unpack_avx2(pv + o, k, bits);
+    }
+    memset(buf, 0, sizeof (buf));
+    memcpy(buf, pv + o, size - o < 2 * bits ? size - o : 2 * bits);
+    return unpack_avx2(buf, k, bits);
+}
+
+// loads and stores the n (at most 16) values at vp, as 16-bit values
+static inline __m256i load_p_avx2(const modp_t *vp, size_t n) {
+    modp_t t[16];
+
+    if (n < 16) {
+        memset(t, 0, sizeof (t));
+        memcpy(t, vp, n * sizeof (modp_t));
+        vp = t;
+    }
+#if (PARAMS_P_BITS <= 8)
+    return _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *) vp));
+#else
+    return _mm256_loadu_si256((const __m256i *) vp);
+#endif
+}
+
+static inline void store_p_avx2(modp_t *vp, __m256i x, size_t n) {
+    modp_t t[16];
+    modp_t *d = n < 16 ? t : vp;
+
+#if (PARAMS_P_BITS <= 8)
+    _mm_storeu_si128((__m128i *) d, _mm_packus_epi16(_mm256_castsi256_si128(x), _mm256_extracti128_si256(x, 1)));
+#else
+    _mm256_storeu_si256((__m256i *) d, x);
+#endif
+    if (n < 16) {
+        memcpy(vp, t, n * sizeof (modp_t));
+    }
+}
+
+// unpacks num_coeff values of bits bits
+static inline void unpack_p_avx2(modp_t *vp, const uint8_t *pv, size_t num_coeff, const unsigned bits) {
+    const size_t size = BITS_TO_BYTES(num_coeff * bits);
+    pack_avx2_t k;
+    size_t i;
+
+    unpack_avx2_init(&k, bits);
+    for (i = 0; i < num_coeff; i += 16) {
+        store_p_avx2(vp + i, unpack_at_avx2(pv, size, (i / 8) * bits, &k, bits), num_coeff - i);
+    }
+}
+#endif
+
 void pack_qp(uint8_t *pv, const modq_t *vq, const modq_t rounding_constant, size_t num_coeff, size_t size) {
 #if (PARAMS_P_BITS == 8)
     size_t i;
-    
+
     for (i = 0; i < num_coeff; i++) {
         pv[i] = (uint8_t) (((vq[i] + rounding_constant) >> (PARAMS_Q_BITS - PARAMS_P_BITS)) & (PARAMS_P - 1));
     }
+#elif defined(AVX2)
+    const __m256i h = _mm256_set1_epi16((short) rounding_constant);
+    const __m256i mask = _mm256_set1_epi16(PARAMS_P - 1);
+    modq_t t[16] = {0};
+    pack_avx2_t k;
+    size_t i;
+    __m256i x;
+
+    pack_avx2_init(&k, PARAMS_P_BITS);
+    for (i = 0; i < num_coeff; i += 16) {
+        if (i + 16 <= num_coeff) {
+            x = _mm256_loadu_si256((const __m256i *) (vq + i));
+        } else {
+            memcpy(t, vq + i, (num_coeff - i) * sizeof (modq_t));
+            x = _mm256_loadu_si256((const __m256i *) t);
+        }
+        x = _mm256_and_si256(_mm256_srli_epi16(_mm256_add_epi16(x, h), PARAMS_Q_BITS - PARAMS_P_BITS), mask);
+        pack_at_avx2(pv, size, (i / 8) * PARAMS_P_BITS, _mm256_and_si256(x, lanes_below(num_coeff - i)), &k, PARAMS_P_BITS);
+    }
 #else
     size_t i, j;
     modp_t t;
-    
+
     memset(pv, 0, size);
     j = 0;
     for (i = 0; i < num_coeff; i++) {
@@ -30,7 +206,7 @@ void pack_qp(uint8_t *pv, const modq_t *vq, const modq_t rounding_constant, size
             if ((j & 7) + PARAMS_P_BITS > 16) {
                 pv[(j >> 3) + 2] |= (uint8_t) (t >> (16 - (j & 7)));
             }
-            
+
         }
         j += PARAMS_P_BITS;
     }
@@ -38,11 +214,14 @@ void pack_qp(uint8_t *pv, const modq_t *vq, const modq_t rounding_constant, size
 }
 
 void unpack_p(modp_t *vp, const uint8_t *pv, size_t num_coeff) {
-    
-    // memcpy(vp, pv, PARAMS_N) can be used if PARAMS_P_BITS == 8
+#if (PARAMS_P_BITS == 8)
+    memcpy(vp, pv, num_coeff);
+#elif defined(AVX2)
+    unpack_p_avx2(vp, pv, num_coeff, PARAMS_P_BITS);
+#else
     size_t i, j;
     modp_t t;
-    
+
     j = 0;
     for (i = 0; i < num_coeff; i++) {
         t = (modp_t) (pv[j >> 3] >> (j & 7)); // unpack p bits
@@ -51,9 +230,112 @@ void unpack_p(modp_t *vp, const uint8_t *pv, size_t num_coeff) {
             if ((j & 7) + PARAMS_P_BITS > 16) {
                 t |= (modp_t)(pv[(j >> 3) + 2] << (16 - (j & 7)));
             }
-            
+
         }
         vp[i] = t & (PARAMS_P - 1);
         j += PARAMS_P_BITS;
     }
+#endif
+}
+
+void pack_t(uint8_t *pv, const modp_t *vt, size_t num_coeff) {
+#if defined(AVX2)
+    const size_t size = BITS_TO_BYTES(num_coeff * PARAMS_T_BITS);
+    pack_avx2_t k;
+    size_t i;
+
+    pack_avx2_init(&k, PARAMS_T_BITS);
+    for (i = 0; i < num_coeff; i += 16) {
+        pack_at_avx2(pv, size, (i / 8) * PARAMS_T_BITS, load_p_avx2(vt + i, num_coeff - i), &k, PARAMS_T_BITS);
+    }
+#else
+    size_t i, j;
+    modp_t t;
+
+    memset(pv, 0, BITS_TO_BYTES(num_coeff * PARAMS_T_BITS));
+    j = 0;
+    for (i = 0; i < num_coeff; i++) {
+        t = vt[i];
+        pv[j >> 3] = (uint8_t) (pv[j >> 3] | (t << (j & 7))); // pack t bits
+        if ((j & 7) + PARAMS_T_BITS > 8) {
+            pv[(j >> 3) + 1] |= (uint8_t) (t >> (8 - (j & 7)));
+            if ((j & 7) + PARAMS_T_BITS > 16) {
+                pv[(j >> 3) + 2] |= (uint8_t) (t >> (16 - (j & 7)));
+            }
+        }
+        j += PARAMS_T_BITS;
+    }
+#endif
+}
+
+void unpack_t(modp_t *vt, const uint8_t *pv, size_t num_coeff) {
+#if defined(AVX2)
+    unpack_p_avx2(vt, pv, num_coeff, PARAMS_T_BITS);
+#else
+    size_t i, j;
+    modp_t t;
+
+    j = 0;
+    for (i = 0; i < num_coeff; i++) {
+        t = (modp_t) (pv[j >> 3] >> (j & 7)); // unpack t bits
+        if ((j & 7) + PARAMS_T_BITS > 8) {
+            t |= (modp_t) (pv[(j >> 3) + 1] << (8 - (j & 7)));
+            if ((j & 7) + PARAMS_T_BITS > 16) {
+                t |= (modp_t) (pv[(j >> 3) + 2] << (16 - (j & 7)));
+            }
+        }
+        vt[i] = t & ((1 << PARAMS_T_BITS) - 1);
+        j += PARAMS_T_BITS;
+    }
+#endif
+}
+
+void unpack_t_message(uint8_t *m, const uint8_t *pv, const modp_t *x, size_t num_coeff) {
+#if defined(AVX2)
+    const size_t size_t_bits = BITS_TO_BYTES(num_coeff * PARAMS_T_BITS);
+    const size_t size_b_bits = BITS_TO_BYTES(num_coeff * PARAMS_B_BITS);
+    const __m256i h3 = _mm256_set1_epi16(PARAMS_H3);
+    const __m256i mask = _mm256_set1_epi16((1 << PARAMS_B_BITS) - 1);
+    pack_avx2_t kt, kb;
+    size_t i;
+    __m256i v;
+
+    unpack_avx2_init(&kt, PARAMS_T_BITS);
+    pack_avx2_init(&kb, PARAMS_B_BITS);
+    for (i = 0; i < num_coeff; i += 16) {
+        v = unpack_at_avx2(pv, size_t_bits, (i / 8) * PARAMS_T_BITS, &kt, PARAMS_T_BITS);
+        v = _mm256_sub_epi16(_mm256_slli_epi16(v, PARAMS_P_BITS - PARAMS_T_BITS), load_p_avx2(x + i, num_coeff - i));
+        v = _mm256_and_si256(_mm256_srli_epi16(_mm256_add_epi16(v, h3), PARAMS_P_BITS - PARAMS_B_BITS), mask);
+        pack_at_avx2(m, size_b_bits, (i / 8) * PARAMS_B_BITS, _mm256_and_si256(v, lanes_below(num_coeff - i)), &kb, PARAMS_B_BITS);
+    }
+#else
+    size_t i, j;
+    modp_t t, x_p;
+
+    memset(m, 0, BITS_TO_BYTES(num_coeff * PARAMS_B_BITS));
+    j = 0;
+    for (i = 0; i < num_coeff; i++) {
+        t = (modp_t) (pv[j >> 3] >> (j & 7)); // unpack t bits
+        if ((j & 7) + PARAMS_T_BITS > 8) {
+            t |= (modp_t) (pv[(j >> 3) + 1] << (8 - (j & 7)));
+            if ((j & 7) + PARAMS_T_BITS > 16) {
+                t |= (modp_t) (pv[(j >> 3) + 2] << (16 - (j & 7)));
+            }
+        }
+        t &= (1 << PARAMS_T_BITS) - 1;
+        j += PARAMS_T_BITS;
+
+        // v - X' as mod p value (to be able to perform the rounding!)
+        x_p = (modp_t) ((t << (PARAMS_P_BITS - PARAMS_T_BITS)) - x[i]);
+        x_p = (modp_t) (((x_p + PARAMS_H3) >> (PARAMS_P_BITS - PARAMS_B_BITS)) & ((1 << PARAMS_B_BITS) - 1));
+
+        m[i * PARAMS_B_BITS >> 3] = (uint8_t) (m[i * PARAMS_B_BITS >> 3] | (x_p << ((i * PARAMS_B_BITS) & 7)));
+#if (8 % PARAMS_B_BITS != 0)
+        if (((i * PARAMS_B_BITS) & 7) + PARAMS_B_BITS > 8) {
+            /* Spill over to next message byte */
+            m[(i * PARAMS_B_BITS >> 3) + 1] = (uint8_t) (m[(i * PARAMS_B_BITS >> 3) + 1] | (x_p >> (8 - ((i * PARAMS_B_BITS) & 7))));
+        }
+#endif
+    }
+#endif
 }
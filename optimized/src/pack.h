@@ -8,4 +8,13 @@
 void pack_qp(uint8_t *pv, const modq_t *vq, const modq_t rounding_constant, size_t num_coeff, size_t size);
 void unpack_p(modp_t *vp, const uint8_t *pv, size_t num_coeff);
 
+// pack and unpack num_coeff values of PARAMS_T_BITS bits (the v part of the
+// ciphertext), into and from BITS_TO_BYTES(num_coeff * PARAMS_T_BITS) bytes
+void pack_t(uint8_t *pv, const modp_t *vt, size_t num_coeff);
+void unpack_t(modp_t *vt, const uint8_t *pv, size_t num_coeff);
 
+// the end of decryption: unpacks the num_coeff values v of PARAMS_T_BITS
+// bits at pv, and packs the PARAMS_B_BITS message bits of each
+// ((v << (PARAMS_P_BITS - PARAMS_T_BITS)) - x + PARAMS_H3) >> (PARAMS_P_BITS - PARAMS_B_BITS)
+// into m, BITS_TO_BYTES(num_coeff * PARAMS_B_BITS) bytes
+void unpack_t_message(uint8_t *m, const uint8_t *pv, const modp_t *x, size_t num_coeff);
@@ -16,5 +16,8 @@
 extern int crypto_encrypt_keypair(unsigned char *pk, unsigned char *sk);
 extern int crypto_encrypt(unsigned char *ct, unsigned long long *ct_len, const unsigned char *m, const unsigned long long m_len, const unsigned char *pk);
 extern int crypto_encrypt_open(unsigned char *m, unsigned long long *m_len, const unsigned char *ct, const unsigned long long ct_len, const unsigned char *sk);
+extern int crypto_encrypt_keypair_ctx(r5_ctx *ctx, unsigned char *pk, unsigned char *sk);
+extern int crypto_encrypt_ctx(r5_ctx *ctx, unsigned char *ct, unsigned long long *ct_len, const unsigned char *m, const unsigned long long m_len, const unsigned char *pk);
+extern int crypto_encrypt_open_ctx(r5_ctx *ctx, unsigned char *m, unsigned long long *m_len, const unsigned char *ct, const unsigned long long ct_len, const unsigned char *sk);
 
 #endif
@@ -30,6 +30,8 @@ extern "C" {
     #define CRYPTO_BYTES           (PARAMS_CT_SIZE + PARAMS_KAPPA_BYTES + 16)
     #define CRYPTO_CIPHERTEXTBYTES 0
         
+#ifndef R5_DISPATCH
+
     /**
      * Generates an ENCRYPT key pair.
      *
@@ -38,7 +40,7 @@ extern "C" {
      * @return __0__ in case of success
      */
     inline int crypto_encrypt_keypair(unsigned char *pk, unsigned char *sk) {
-        return r5_cca_pke_keygen(pk, sk);
+        return r5_cca_pke_keygen(NULL, pk, sk);
     }
 
     /**
@@ -52,7 +54,7 @@ extern "C" {
      * @return __0__ in case of success
      */
     inline int crypto_encrypt(unsigned char *ct, unsigned long long *ct_len, const unsigned char *m, const unsigned long long m_len, const unsigned char *pk) {
-        return r5_cca_pke_encrypt(ct, ct_len, m, m_len, pk);
+        return r5_cca_pke_encrypt(NULL, ct, ct_len, m, m_len, pk);
     }
 
     /**
@@ -66,13 +68,45 @@ extern "C" {
      * @return __0__ in case of success
      */
     inline int crypto_encrypt_open(unsigned char *m, unsigned long long *m_len, const unsigned char *ct, const unsigned long long ct_len, const unsigned char *sk) {
-        return r5_cca_pke_decrypt(m, m_len, ct, ct_len, sk);
+        return r5_cca_pke_decrypt(NULL, m, m_len, ct, ct_len, sk);
     }
 
-#endif
+    /*
+     * The functions above with a context (see r5_ctx.h and kem.h). A NULL
+     * context gives the functions above.
+     */
+
+    /** crypto_encrypt_keypair() with a context */
+    inline int crypto_encrypt_keypair_ctx(r5_ctx *ctx, unsigned char *pk, unsigned char *sk) {
+        return r5_cca_pke_keygen(ctx, pk, sk);
+    }
+
+    /** crypto_encrypt() with a context */
+    inline int crypto_encrypt_ctx(r5_ctx *ctx, unsigned char *ct, unsigned long long *ct_len, const unsigned char *m, const unsigned long long m_len, const unsigned char *pk) {
+        return r5_cca_pke_encrypt(ctx, ct, ct_len, m, m_len, pk);
+    }
+
+    /** crypto_encrypt_open() with a context */
+    inline int crypto_encrypt_open_ctx(r5_ctx *ctx, unsigned char *m, unsigned long long *m_len, const unsigned char *ct, const unsigned long long ct_len, const unsigned char *sk) {
+        return r5_cca_pke_decrypt(ctx, m, m_len, ct, ct_len, sk);
+    }
+
+#else /* R5_DISPATCH */
+
+    /* dispatched to the kernel set chosen at start-up, see kem.h */
+    int crypto_encrypt_keypair(unsigned char *pk, unsigned char *sk);
+    int crypto_encrypt(unsigned char *ct, unsigned long long *ct_len, const unsigned char *m, const unsigned long long m_len, const unsigned char *pk);
+    int crypto_encrypt_open(unsigned char *m, unsigned long long *m_len, const unsigned char *ct, const unsigned long long ct_len, const unsigned char *sk);
+    int crypto_encrypt_keypair_ctx(r5_ctx *ctx, unsigned char *pk, unsigned char *sk);
+    int crypto_encrypt_ctx(r5_ctx *ctx, unsigned char *ct, unsigned long long *ct_len, const unsigned char *m, const unsigned long long m_len, const unsigned char *pk);
+    int crypto_encrypt_open_ctx(r5_ctx *ctx, unsigned char *m, unsigned long long *m_len, const unsigned char *ct, const unsigned long long ct_len, const unsigned char *sk);
+
+#endif /* R5_DISPATCH */
 
 #ifdef __cplusplus
 }
 #endif
 
+#endif
+
 #endif /* _CCA_ENCRYPT_H_ */
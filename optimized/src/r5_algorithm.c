@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2020, Koninklijke Philips N.V.
+ */
+
+/**
+ * @file
+ * The registry entry of the parameter set the code is compiled for. In a
+ * build with `ALGS` set, r5_algorithm_this is renamed to r5_<ALG>_algorithm
+ * in the code of each parameter set (see the Makefile).
+ */
+
+#include "r5_algorithms.h"
+#include "kem.h"
+
+/* kem.h and pke.h define the CRYPTO_ sizes each for their own api */
+enum {
+    KEM_PUBLICKEYBYTES = CRYPTO_PUBLICKEYBYTES,
+    KEM_SECRETKEYBYTES = CRYPTO_SECRETKEYBYTES,
+    KEM_CIPHERTEXTBYTES = CRYPTO_CIPHERTEXTBYTES,
+    KEM_BYTES = CRYPTO_BYTES
+};
+
+#undef CRYPTO_PUBLICKEYBYTES
+#undef CRYPTO_SECRETKEYBYTES
+#undef CRYPTO_CIPHERTEXTBYTES
+#undef CRYPTO_BYTES
+
+#include "pke.h"
+
+const r5_algorithm r5_algorithm_this = {
+    CRYPTO_ALGNAME,
+    KEM_PUBLICKEYBYTES, KEM_SECRETKEYBYTES, KEM_CIPHERTEXTBYTES, KEM_BYTES,
+    crypto_kem_keypair, crypto_kem_enc, crypto_kem_enc_batch, crypto_kem_dec, crypto_kem_dec_batch,
+    crypto_kem_keypair_ctx, crypto_kem_enc_ctx, crypto_kem_enc_batch_ctx, crypto_kem_dec_ctx, crypto_kem_dec_batch_ctx,
+#ifdef ROUND5_CCA_PKE
+    CRYPTO_BYTES,
+    crypto_encrypt_keypair, crypto_encrypt, crypto_encrypt_open,
+    crypto_encrypt_keypair_ctx, crypto_encrypt_ctx, crypto_encrypt_open_ctx
+#else
+    0,
+    NULL, NULL, NULL,
+    NULL, NULL, NULL
+#endif
+};
@@ -0,0 +1,60 @@
+/*
+ * Copyright (c) 2020, Koninklijke Philips N.V.
+ */
+
+/**
+ * @file
+ * Implementation of the registry of the parameter sets held by the library.
+ *
+ * In a build with `ALGS` set, `R5_ALGORITHMS` lists the parameter sets as
+ * `R5_ALGORITHM(<ALG>)`, and the entry of each is r5_<ALG>_algorithm (see
+ * r5_algorithm.c). Otherwise the library holds r5_algorithm_this only.
+ */
+
+#include "r5_algorithms.h"
+
+#include <string.h>
+
+#ifdef R5_ALGORITHMS
+
+#define R5_ALGORITHM(alg) extern const r5_algorithm r5_##alg##_algorithm;
+R5_ALGORITHMS
+#undef R5_ALGORITHM
+
+#define R5_ALGORITHM(alg) &r5_##alg##_algorithm,
+static const r5_algorithm * const algorithms[] = {
+    R5_ALGORITHMS
+};
+#undef R5_ALGORITHM
+
+#else
+
+extern const r5_algorithm r5_algorithm_this;
+
+static const r5_algorithm * const algorithms[] = {
+    &r5_algorithm_this
+};
+
+#endif
+
+#define NUM_ALGORITHMS (sizeof (algorithms) / sizeof (algorithms[0]))
+
+const r5_algorithm *r5_algorithm_by_name(const char *name) {
+    size_t i;
+
+    for (i = 0; i < NUM_ALGORITHMS; i++) {
+        if (strcmp(name, algorithms[i]->name) == 0) {
+            return algorithms[i];
+        }
+    }
+
+    return NULL;
+}
+
+size_t r5_num_algorithms(void) {
+    return NUM_ALGORITHMS;
+}
+
+const r5_algorithm *r5_algorithm_at(size_t i) {
+    return i < NUM_ALGORITHMS ? algorithms[i] : NULL;
+}
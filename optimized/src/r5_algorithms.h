@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2020, Koninklijke Philips N.V.
+ */
+
+/**
+ * @file
+ * Declaration of the registry of the parameter sets held by the library.
+ *
+ * A normal build holds the one parameter set it is compiled for (`ALG`).
+ * A build with `ALGS` set compiles the optimized code once for each of the
+ * parameter sets listed, each with its own compile-time parameters, and
+ * holds all of them. The functions of a parameter set are also available
+ * as r5_<ALG>_<name> (e.g. `r5_R5ND_1CCA_5d_crypto_kem_enc`) in such a
+ * build.
+ */
+
+#ifndef R5_ALGORITHMS_H
+#define R5_ALGORITHMS_H
+
+#include <stddef.h>
+
+#include "r5_ctx.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /**
+     * A parameter set and its NIST api functions.
+     */
+    typedef struct {
+        const char *name; /**< The name of the parameter set (`CRYPTO_ALGNAME`) */
+
+        size_t kem_pk_bytes; /**< The size of a KEM public key */
+        size_t kem_sk_bytes; /**< The size of a KEM secret key */
+        size_t kem_ct_bytes; /**< The size of a KEM ciphertext */
+        size_t kem_ss_bytes; /**< The size of a KEM shared secret */
+
+        /** see crypto_kem_keypair() */
+        int (*kem_keypair)(unsigned char *pk, unsigned char *sk);
+        /** see crypto_kem_enc() */
+        int (*kem_enc)(unsigned char *ct, unsigned char *k, const unsigned char *pk);
+        /** see crypto_kem_enc_batch() */
+        int (*kem_enc_batch)(unsigned char *ct[], unsigned char *k[], const unsigned char *pk[], size_t count);
+        /** see crypto_kem_dec() */
+        int (*kem_dec)(unsigned char *k, const unsigned char *ct, const unsigned char *sk);
+        /** see crypto_kem_dec_batch() */
+        int (*kem_dec_batch)(unsigned char *k[], const unsigned char *ct[], size_t count, const unsigned char *sk);
+        /** see crypto_kem_keypair_ctx() */
+        int (*kem_keypair_ctx)(r5_ctx *ctx, unsigned char *pk, unsigned char *sk);
+        /** see crypto_kem_enc_ctx() */
+        int (*kem_enc_ctx)(r5_ctx *ctx, unsigned char *ct, unsigned char *k, const unsigned char *pk);
+        /** see crypto_kem_enc_batch_ctx() */
+        int (*kem_enc_batch_ctx)(r5_ctx *ctx, unsigned char *ct[], unsigned char *k[], const unsigned char *pk[], size_t count);
+        /** see crypto_kem_dec_ctx() */
+        int (*kem_dec_ctx)(r5_ctx *ctx, unsigned char *k, const unsigned char *ct, const unsigned char *sk);
+        /** see crypto_kem_dec_batch_ctx() */
+        int (*kem_dec_batch_ctx)(r5_ctx *ctx, unsigned char *k[], const unsigned char *ct[], size_t count, const unsigned char *sk);
+
+        /** The ciphertext expansion of the PKE (`CRYPTO_BYTES` of pke.h), __0__ for CPA parameter sets */
+        size_t pke_overhead_bytes;
+
+        /** see crypto_encrypt_keypair(), `NULL` for CPA parameter sets (the key sizes are those of the KEM) */
+        int (*encrypt_keypair)(unsigned char *pk, unsigned char *sk);
+        /** see crypto_encrypt(), `NULL` for CPA parameter sets */
+        int (*encrypt)(unsigned char *ct, unsigned long long *ct_len, const unsigned char *m, const unsigned long long m_len, const unsigned char *pk);
+        /** see crypto_encrypt_open(), `NULL` for CPA parameter sets */
+        int (*encrypt_open)(unsigned char *m, unsigned long long *m_len, const unsigned char *ct, const unsigned long long ct_len, const unsigned char *sk);
+        /** see crypto_encrypt_keypair_ctx(), `NULL` for CPA parameter sets */
+        int (*encrypt_keypair_ctx)(r5_ctx *ctx, unsigned char *pk, unsigned char *sk);
+        /** see crypto_encrypt_ctx(), `NULL` for CPA parameter sets */
+        int (*encrypt_ctx)(r5_ctx *ctx, unsigned char *ct, unsigned long long *ct_len, const unsigned char *m, const unsigned long long m_len, const unsigned char *pk);
+        /** see crypto_encrypt_open_ctx(), `NULL` for CPA parameter sets */
+        int (*encrypt_open_ctx)(r5_ctx *ctx, unsigned char *m, unsigned long long *m_len, const unsigned char *ct, const unsigned long long ct_len, const unsigned char *sk);
+    } r5_algorithm;
+
+    /**
+     * Looks up a parameter set of the library by name.
+     *
+     * @param[in] name the name of the parameter set, e.g. `R5ND_1CCA_5d`
+     * @return the parameter set, `NULL` if the library does not hold it
+     */
+    const r5_algorithm *r5_algorithm_by_name(const char *name);
+
+    /**
+     * @return the number of parameter sets of the library
+     */
+    size_t r5_num_algorithms(void);
+
+    /**
+     * @param[in] i the index of the parameter set, < r5_num_algorithms()
+     * @return the parameter set at index `i`, in the order of `ALGS`
+     */
+    const r5_algorithm *r5_algorithm_at(size_t i);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* R5_ALGORITHMS_H */
@@ -3,6 +3,7 @@
  * Markku-Juhani O. Saarinen, Koninklijke Philips N.V.
  */
 
+#include "r5_cca_kem.h"
 #include "r5_cpa_pke.h"
 #include "r5_parameter_sets.h"
 
@@ -17,15 +18,19 @@
 
 // CCA-KEM KeyGen()
 
-int r5_cca_kem_keygen(uint8_t *pk, uint8_t *sk) {
+int r5_cca_kem_keygen(r5_ctx *ctx, uint8_t *pk, uint8_t *sk) {
     
     uint8_t y[PARAMS_KAPPA_BYTES];
+    int ret;
 
     /* Generate the base key pair */
-    r5_cpa_pke_keygen(pk, sk);
+    ret = r5_cpa_pke_keygen(ctx, pk, sk);
+    if (ret < 0){
+        return ret;
+    }
 
     /* Append y and pk to sk */
-    randombytes(y, PARAMS_KAPPA_BYTES);
+    r5_ctx_randombytes(ctx, y, PARAMS_KAPPA_BYTES);
     
     memcpy(sk + PARAMS_KAPPA_BYTES, y, PARAMS_KAPPA_BYTES);
     memcpy(sk + PARAMS_KAPPA_BYTES + PARAMS_KAPPA_BYTES, pk, PARAMS_PK_SIZE);
@@ -33,21 +38,54 @@ int r5_cca_kem_keygen(uint8_t *pk, uint8_t *sk) {
     return 0;
 }
 
+// Prepares a public key for the CCA-KEM: the CPA part and the G and H
+// hash states
+
+int r5_cca_kem_prepare_pk(r5_ctx *ctx, r5_prepared_pk *ppk, const uint8_t *pk) {
+
+    int ret = 0;
+
+    ret = r5_cpa_pke_prepare_pk(ctx, ppk, pk);
+    if (ret < 0){
+        return ret;
+    }
+
+    GCCAKEM_prefix(&ppk->G, 3 * PARAMS_KAPPA_BYTES Params);
+    HCCAKEM_prefix(&ppk->H, PARAMS_KAPPA_BYTES Params);
+
+    return ret;
+}
+
 // CCA-KEM Encaps()
 
-int r5_cca_kem_encapsulate(uint8_t *ct, uint8_t *k, const uint8_t *pk) {
+int r5_cca_kem_encapsulate(r5_ctx *ctx, uint8_t *ct, uint8_t *k, const uint8_t *pk) {
+    
+    r5_prepared_pk ppk;
+    int ret = 0;
+
+    ret = r5_cca_kem_prepare_pk(ctx, &ppk, pk);
+    if (ret < 0){
+        return ret;
+    }
+
+    return r5_cca_kem_encapsulate_prepared(ctx, ct, k, &ppk);
+}
+
+// CCA-KEM Encaps() with a prepared public key
+
+int r5_cca_kem_encapsulate_prepared(r5_ctx *ctx, uint8_t *ct, uint8_t *k, const r5_prepared_pk *ppk) {
     
     uint8_t m[PARAMS_KAPPA_BYTES];
     uint8_t L_g_rho[3][PARAMS_KAPPA_BYTES];
     
     int ret = 0;
 
-    randombytes(m, PARAMS_KAPPA_BYTES); // generate random m
+    r5_ctx_randombytes(ctx, m, PARAMS_KAPPA_BYTES); // generate random m
 
-    GCCAKEM((uint8_t *)L_g_rho, 3 * PARAMS_KAPPA_BYTES, m, PARAMS_KAPPA_BYTES, pk, PARAMS_PK_SIZE Params);
+    r5_hash_prefixed((uint8_t *)L_g_rho, &ppk->G, m, PARAMS_KAPPA_BYTES, ppk->pk, PARAMS_PK_SIZE Params);
 
     /* Encrypt  */
-    ret = r5_cpa_pke_encrypt(ct, pk, m, L_g_rho[2]); // m: ct = (U,v)
+    ret = r5_cpa_pke_encrypt_prepared(ct, ppk, m, L_g_rho[2]); // m: ct = (U,v)
     if (ret < 0){
         return ret;
     }
@@ -56,7 +94,7 @@ int r5_cca_kem_encapsulate(uint8_t *ct, uint8_t *k, const uint8_t *pk) {
     memcpy(ct + PARAMS_CT_SIZE, L_g_rho[1], PARAMS_KAPPA_BYTES);
 
     /* k = H(L, ct) */
-    HCCAKEM(k, PARAMS_KAPPA_BYTES, L_g_rho[0], PARAMS_KAPPA_BYTES, ct, (PARAMS_CT_SIZE + PARAMS_KAPPA_BYTES) Params);
+    r5_hash_prefixed(k, &ppk->H, L_g_rho[0], PARAMS_KAPPA_BYTES, ct, (PARAMS_CT_SIZE + PARAMS_KAPPA_BYTES) Params);
     
     
 DEBUG_PRINT(
@@ -69,6 +107,88 @@ DEBUG_PRINT(
     return ret;
 }
 
+// CCA-KEM Encaps() to four prepared public keys, with the G and H hashes
+// and the sampling of R done for the four at once
+
+static int encapsulate_prepared_4x(r5_ctx *ctx, uint8_t *ct[4], uint8_t *k[4], const r5_prepared_pk *ppk[4]) {
+
+    uint8_t m[4][PARAMS_KAPPA_BYTES];
+    uint8_t L_g_rho[4][3][PARAMS_KAPPA_BYTES];
+    const uint8_t *m4[4] = {m[0], m[1], m[2], m[3]};
+    const uint8_t *rho4[4] = {L_g_rho[0][2], L_g_rho[1][2], L_g_rho[2][2], L_g_rho[3][2]};
+    size_t i;
+    int ret = 0;
+
+    for (i = 0; i < 4; i++) {
+        r5_ctx_randombytes(ctx, m[i], PARAMS_KAPPA_BYTES); // generate random m
+    }
+
+    GCCAKEM_4x((uint8_t *)L_g_rho[0], (uint8_t *)L_g_rho[1], (uint8_t *)L_g_rho[2], (uint8_t *)L_g_rho[3], 3 * PARAMS_KAPPA_BYTES,
+               m[0], m[1], m[2], m[3], PARAMS_KAPPA_BYTES,
+               ppk[0]->pk, ppk[1]->pk, ppk[2]->pk, ppk[3]->pk, PARAMS_PK_SIZE Params);
+
+    /* Encrypt  */
+    ret = r5_cpa_pke_encrypt_prepared_4x(ct, ppk, m4, rho4); // m: ct = (U,v)
+    if (ret < 0){
+        return ret;
+    }
+
+    /* Append g: ct = (U,v,g) */
+    for (i = 0; i < 4; i++) {
+        memcpy(ct[i] + PARAMS_CT_SIZE, L_g_rho[i][1], PARAMS_KAPPA_BYTES);
+    }
+
+    /* k = H(L, ct) */
+    HCCAKEM_4x(k[0], k[1], k[2], k[3], PARAMS_KAPPA_BYTES,
+               L_g_rho[0][0], L_g_rho[1][0], L_g_rho[2][0], L_g_rho[3][0], PARAMS_KAPPA_BYTES,
+               ct[0], ct[1], ct[2], ct[3], (PARAMS_CT_SIZE + PARAMS_KAPPA_BYTES) Params);
+
+    return ret;
+}
+
+// CCA-KEM Encaps() to count public keys
+
+int r5_cca_kem_encapsulate_batch(r5_ctx *ctx, uint8_t *ct[], uint8_t *k[], const uint8_t *pk[], size_t count) {
+
+    r5_prepared_pk *ppk;
+    const r5_prepared_pk *ppk4[4];
+    size_t i, j, n;
+    int ret = 0;
+    int enc = 0;
+
+    ppk = checked_malloc(4 * sizeof (r5_prepared_pk));
+    for (j = 0; j < 4; j++) {
+        ppk4[j] = &ppk[j];
+    }
+
+    for (i = 0; i < count && ret == 0; i += n) {
+        // a malformed key ends the batch, after the keys before it
+        for (n = 0; n < 4 && i + n < count; n++) {
+            ret = r5_cca_kem_prepare_pk(ctx, &ppk[n], pk[i + n]);
+            if (ret < 0) {
+                break;
+            }
+        }
+
+        if (n == 4) {
+            ret = encapsulate_prepared_4x(ctx, &ct[i], &k[i], ppk4);
+        } else {
+            // the last keys, or the ones before a malformed key (whose
+            // error is kept unless an encryption fails)
+            for (j = 0; j < n && enc == 0; j++) {
+                enc = r5_cca_kem_encapsulate_prepared(ctx, ct[i + j], k[i + j], &ppk[j]);
+            }
+            if (enc < 0) {
+                ret = enc;
+            }
+        }
+    }
+
+    free(ppk);
+
+    return ret;
+}
+
 /**
  * Verifies whether or not two byte strings are equal (in constant time).
  *
@@ -81,9 +201,34 @@ static int verify(const void *s1, const void *s2, size_t n) {
     return constant_time_memcmp(s1, s2, n);
 }
 
+// Expands a CCA-KEM secret key
+
+int r5_cca_kem_expand_sk(r5_ctx *ctx, r5_cca_expanded_sk *esk, const uint8_t *sk) {
+
+    r5_cpa_pke_expand_sk(&esk->sk, sk);
+    memcpy(esk->y, sk + PARAMS_KAPPA_BYTES, PARAMS_KAPPA_BYTES);
+
+    return r5_cca_kem_prepare_pk(ctx, &esk->ppk, sk + PARAMS_KAPPA_BYTES + PARAMS_KAPPA_BYTES);
+}
+
 // CCA-KEM Decaps()
 
-int r5_cca_kem_decapsulate(uint8_t *k, const uint8_t *ct, const uint8_t *sk) {
+int r5_cca_kem_decapsulate(r5_ctx *ctx, uint8_t *k, const uint8_t *ct, const uint8_t *sk) {
+
+    r5_cca_expanded_sk esk;
+    int ret = 0;
+
+    ret = r5_cca_kem_expand_sk(ctx, &esk, sk);
+    if (ret < 0){
+        return ret;
+    }
+
+    return r5_cca_kem_decapsulate_expanded(k, ct, &esk);
+}
+
+// CCA-KEM Decaps() with an expanded secret key
+
+int r5_cca_kem_decapsulate_expanded(uint8_t *k, const uint8_t *ct, const r5_cca_expanded_sk *esk) {
 
     uint8_t m_prime[PARAMS_KAPPA_BYTES];
     uint8_t L_g_rho_prime[3][PARAMS_KAPPA_BYTES];
@@ -92,12 +237,12 @@ int r5_cca_kem_decapsulate(uint8_t *k, const uint8_t *ct, const uint8_t *sk) {
     
     int ret = 0;
 
-    ret = r5_cpa_pke_decrypt(m_prime, sk, ct); // r5_cpa_pke_decrypt m'
+    ret = r5_cpa_pke_decrypt_expanded(m_prime, &esk->sk, ct); // r5_cpa_pke_decrypt m'
     if (ret < 0){
         return ret;
     }
     
-    GCCAKEM((uint8_t *)L_g_rho_prime, 3 * PARAMS_KAPPA_BYTES, m_prime, PARAMS_KAPPA_BYTES, sk + PARAMS_KAPPA_BYTES + PARAMS_KAPPA_BYTES, PARAMS_PK_SIZE Params);
+    r5_hash_prefixed((uint8_t *)L_g_rho_prime, &esk->ppk.G, m_prime, PARAMS_KAPPA_BYTES, esk->ppk.pk, PARAMS_PK_SIZE Params);
     
 DEBUG_PRINT(
     print_hex("r5_cca_kem_decapsulate: m_prime", m_prime, PARAMS_KAPPA_BYTES, 1);
@@ -107,18 +252,95 @@ DEBUG_PRINT(
 )
 
     // Encrypt m: ct' = (U',v')
-    r5_cpa_pke_encrypt(ct_prime, sk + PARAMS_KAPPA_BYTES + PARAMS_KAPPA_BYTES, m_prime, L_g_rho_prime[2]);
+    r5_cpa_pke_encrypt_prepared(ct_prime, &esk->ppk, m_prime, L_g_rho_prime[2]);
 
     // ct' = (U',v',g')
     memcpy(ct_prime + PARAMS_CT_SIZE, L_g_rho_prime[1], PARAMS_KAPPA_BYTES);
 
-    // k = H(L', ct')
-    // verification ok ? If fail, k = H(y, ct') depending on fail state
+    // k = H(L', ct), ct being equal to ct' unless verification fails
+    // verification ok ? If fail, k = H(y, ct) depending on fail state
     fail = (uint8_t) verify(ct, ct_prime, PARAMS_CT_SIZE + PARAMS_KAPPA_BYTES);
-    conditional_constant_time_memcpy(L_g_rho_prime[0], sk + PARAMS_KAPPA_BYTES, PARAMS_KAPPA_BYTES, fail);
+    conditional_constant_time_memcpy(L_g_rho_prime[0], esk->y, PARAMS_KAPPA_BYTES, fail);
 
-    HCCAKEM(k, PARAMS_KAPPA_BYTES, L_g_rho_prime[0], PARAMS_KAPPA_BYTES, ct_prime, (PARAMS_CT_SIZE + PARAMS_KAPPA_BYTES) Params);
+    r5_hash_prefixed(k, &esk->ppk.H, L_g_rho_prime[0], PARAMS_KAPPA_BYTES, ct, (PARAMS_CT_SIZE + PARAMS_KAPPA_BYTES) Params);
     
     
+    return ret;
+}
+
+// CCA-KEM Decaps() of four ciphertexts with one expanded secret key, with
+// the G and H hashes and the sampling of R for the re-encryption done for
+// the four at once
+
+static int decapsulate_expanded_4x(uint8_t *k[4], const uint8_t *ct[4], const r5_cca_expanded_sk *esk) {
+
+    uint8_t m_prime[4][PARAMS_KAPPA_BYTES];
+    uint8_t L_g_rho_prime[4][3][PARAMS_KAPPA_BYTES];
+    uint8_t ct_prime[4][PARAMS_CT_SIZE + PARAMS_KAPPA_BYTES];
+    uint8_t *ct_prime4[4] = {ct_prime[0], ct_prime[1], ct_prime[2], ct_prime[3]};
+    const uint8_t *m4[4] = {m_prime[0], m_prime[1], m_prime[2], m_prime[3]};
+    const uint8_t *rho4[4] = {L_g_rho_prime[0][2], L_g_rho_prime[1][2], L_g_rho_prime[2][2], L_g_rho_prime[3][2]};
+    const r5_prepared_pk *ppk4[4] = {&esk->ppk, &esk->ppk, &esk->ppk, &esk->ppk};
+    uint8_t fail;
+    size_t i;
+
+    int ret = 0;
+
+    for (i = 0; i < 4; i++) {
+        ret = r5_cpa_pke_decrypt_expanded(m_prime[i], &esk->sk, ct[i]); // r5_cpa_pke_decrypt m'
+        if (ret < 0){
+            return ret;
+        }
+    }
+
+    GCCAKEM_4x((uint8_t *)L_g_rho_prime[0], (uint8_t *)L_g_rho_prime[1], (uint8_t *)L_g_rho_prime[2], (uint8_t *)L_g_rho_prime[3], 3 * PARAMS_KAPPA_BYTES,
+               m_prime[0], m_prime[1], m_prime[2], m_prime[3], PARAMS_KAPPA_BYTES,
+               esk->ppk.pk, esk->ppk.pk, esk->ppk.pk, esk->ppk.pk, PARAMS_PK_SIZE Params);
+
+    // Encrypt m: ct' = (U',v')
+    r5_cpa_pke_encrypt_prepared_4x(ct_prime4, ppk4, m4, rho4);
+
+    for (i = 0; i < 4; i++) {
+        // ct' = (U',v',g')
+        memcpy(ct_prime[i] + PARAMS_CT_SIZE, L_g_rho_prime[i][1], PARAMS_KAPPA_BYTES);
+
+        // verification ok ? If fail, k = H(y, ct) depending on fail state
+        fail = (uint8_t) verify(ct[i], ct_prime[i], PARAMS_CT_SIZE + PARAMS_KAPPA_BYTES);
+        conditional_constant_time_memcpy(L_g_rho_prime[i][0], esk->y, PARAMS_KAPPA_BYTES, fail);
+    }
+
+    // k = H(L', ct)
+    HCCAKEM_4x(k[0], k[1], k[2], k[3], PARAMS_KAPPA_BYTES,
+               L_g_rho_prime[0][0], L_g_rho_prime[1][0], L_g_rho_prime[2][0], L_g_rho_prime[3][0], PARAMS_KAPPA_BYTES,
+               ct[0], ct[1], ct[2], ct[3], (PARAMS_CT_SIZE + PARAMS_KAPPA_BYTES) Params);
+
+    return ret;
+}
+
+// CCA-KEM Decaps() of count ciphertexts with one secret key
+
+int r5_cca_kem_decapsulate_batch(r5_ctx *ctx, uint8_t *k[], const uint8_t *ct[], size_t count, const uint8_t *sk) {
+
+    r5_cca_expanded_sk *esk;
+    size_t i, j;
+    int ret = 0;
+
+    esk = checked_malloc(sizeof (r5_cca_expanded_sk));
+
+    ret = r5_cca_kem_expand_sk(ctx, esk, sk);
+
+    for (i = 0; i + 4 <= count && ret == 0; i += 4) {
+        ret = decapsulate_expanded_4x(&k[i], &ct[i], esk);
+        if (ret < 0) {
+            // a malformed ciphertext ends the batch, after the ones before it
+            for (j = i; j < i + 4 && (ret = r5_cca_kem_decapsulate_expanded(k[j], ct[j], esk)) == 0; j++);
+        }
+    }
+    for (; i < count && ret == 0; i++) {
+        ret = r5_cca_kem_decapsulate_expanded(k[i], ct[i], esk);
+    }
+
+    free(esk);
+
     return ret;
 }
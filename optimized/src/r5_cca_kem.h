@@ -6,6 +6,22 @@
 #ifndef R5_CCA_KEM_H
 #define R5_CCA_KEM_H
 
+#include "r5_cpa_pke.h"
+
+/*
+ * Expanded CCA KEM secret key, for repeated decapsulation with one key:
+ *
+ *   sk   the expanded CPA secret key (the sampled ternary secret S)
+ *   y    the value used for implicit rejection
+ *   ppk  the public key embedded in the secret key, prepared for the
+ *        re-encryption check
+ */
+typedef struct {
+    r5_expanded_sk sk;
+    uint8_t y[PARAMS_KAPPA_BYTES];
+    r5_prepared_pk ppk;
+} r5_cca_expanded_sk;
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -13,31 +29,114 @@ extern "C" {
     /**
      * Generates a CCA KEM key pair. Uses the parameters as specified.
      *
+     * @param[in,out] ctx the context (see r5_ctx.h), `NULL` for the global state
      * @param[out] pk     public key
      * @param[out] sk     secret key
      * @return __0__ in case of success
      */
-    int r5_cca_kem_keygen(unsigned char *pk, unsigned char *sk);
+    int r5_cca_kem_keygen(r5_ctx *ctx, unsigned char *pk, unsigned char *sk);
 
     /**
      * CCA KEM encapsulate. Uses the parameters as specified.
      *
+     * @param[in,out] ctx the context (see r5_ctx.h), `NULL` for the global state
      * @param[out] ct     key encapsulation message (<b>important:</b> the size of `ct` is `ct_size` + `kappa_bytes`!)
      * @param[out] k      shared secret
      * @param[in]  pk     public key with which the message is encapsulated
      * @return __0__ in case of success
      */
-    int r5_cca_kem_encapsulate(unsigned char *ct, unsigned char *k, const unsigned char *pk);
+    int r5_cca_kem_encapsulate(r5_ctx *ctx, unsigned char *ct, unsigned char *k, const unsigned char *pk);
+
+    /**
+     * Prepares a public key for the CCA KEM: r5_cpa_pke_prepare_pk(), and
+     * the G and H hashes with their domain absorbed.
+     *
+     * @param[in,out] ctx the context (see r5_ctx.h), `NULL` for the global state
+     * @param[out] ppk    prepared public key
+     * @param[in]  pk     public key
+     * @return __0__ in case of success, negative if pk is malformed
+     */
+    int r5_cca_kem_prepare_pk(r5_ctx *ctx, r5_prepared_pk *ppk, const unsigned char *pk);
+
+    /**
+     * CCA KEM encapsulate with a prepared public key (see r5_cca_kem_prepare_pk()).
+     * Gives the same result as r5_cca_kem_encapsulate() with the key it was
+     * prepared from, without expanding that key again.
+     *
+     * @param[in,out] ctx the context (see r5_ctx.h), `NULL` for the global state
+     * @param[out] ct     key encapsulation message (<b>important:</b> the size of `ct` is `ct_size` + `kappa_bytes`!)
+     * @param[out] k      shared secret
+     * @param[in]  ppk    prepared public key with which the message is encapsulated
+     * @return __0__ in case of success
+     */
+    int r5_cca_kem_encapsulate_prepared(r5_ctx *ctx, unsigned char *ct, unsigned char *k, const r5_prepared_pk *ppk);
+
+    /**
+     * CCA KEM encapsulate to count public keys. Gives the same result as
+     * calling r5_cca_kem_encapsulate() for each key in turn: the random
+     * values are drawn in the same order. Four keys at a time, the hashes
+     * and the sampling of R run side by side (in the 4x Keccak lanes with
+     * AVX2). A malformed key ends the batch: the keys before it are
+     * encapsulated to, the ones from it on are not. So does a failing
+     * encryption, with its error.
+     *
+     * @param[in,out] ctx the context (see r5_ctx.h), `NULL` for the global state
+     * @param[out] ct     key encapsulation messages (each `ct_size` + `kappa_bytes` bytes)
+     * @param[out] k      shared secrets
+     * @param[in]  pk     public keys with which the messages are encapsulated
+     * @param[in]  count  the number of public keys
+     * @return __0__ in case of success, otherwise the error of the first
+     *         key that failed
+     */
+    int r5_cca_kem_encapsulate_batch(r5_ctx *ctx, unsigned char *ct[], unsigned char *k[], const unsigned char *pk[], size_t count);
 
     /**
      * CCA KEM de-capsulate. Uses the parameters as specified.
      *
+     * @param[in,out] ctx the context (see r5_ctx.h), `NULL` for the global state
      * @param[out] k      shared secret
      * @param[in]  ct     key encapsulation message (<b>important:</b> the size of `ct` is `ct_size` + `kappa_bytes`!)
      * @param[in]  sk     secret key with which the message is to be de-capsulated (<b>important:</b> the size of `sk` is `sk_size` + `kappa_bytes` + `pk_size`!)
      * @return __0__ in case of success
      */
-    int r5_cca_kem_decapsulate(unsigned char *k, const unsigned char *ct, const unsigned char *sk);
+    int r5_cca_kem_decapsulate(r5_ctx *ctx, unsigned char *k, const unsigned char *ct, const unsigned char *sk);
+
+    /**
+     * Expands a CCA KEM secret key for r5_cca_kem_decapsulate_expanded().
+     *
+     * @param[in,out] ctx the context (see r5_ctx.h), `NULL` for the global state
+     * @param[out] esk    expanded secret key
+     * @param[in]  sk     secret key (<b>important:</b> the size of `sk` is `sk_size` + `kappa_bytes` + `pk_size`!)
+     * @return __0__ in case of success
+     */
+    int r5_cca_kem_expand_sk(r5_ctx *ctx, r5_cca_expanded_sk *esk, const unsigned char *sk);
+
+    /**
+     * CCA KEM de-capsulate with an expanded secret key. Gives the same
+     * result as r5_cca_kem_decapsulate() with the key it was expanded from.
+     *
+     * @param[out] k      shared secret
+     * @param[in]  ct     key encapsulation message (<b>important:</b> the size of `ct` is `ct_size` + `kappa_bytes`!)
+     * @param[in]  esk    expanded secret key (only read)
+     * @return __0__ in case of success
+     */
+    int r5_cca_kem_decapsulate_expanded(unsigned char *k, const unsigned char *ct, const r5_cca_expanded_sk *esk);
+
+    /**
+     * CCA KEM de-capsulate count messages with one secret key. Gives the
+     * same result as calling r5_cca_kem_decapsulate() for each message in
+     * turn. The secret key is expanded once, and four messages at a time
+     * the hashes and the sampling of R of the re-encryption run side by side (in the 4x Keccak lanes with AVX2).
+     * A malformed message ends the batch, as in such a sequence of calls.
+     *
+     * @param[in,out] ctx the context (see r5_ctx.h), `NULL` for the global state
+     * @param[out] k      shared secrets
+     * @param[in]  ct     key encapsulation messages (each `ct_size` + `kappa_bytes` bytes)
+     * @param[in]  count  the number of messages
+     * @param[in]  sk     secret key with which the messages are to be de-capsulated (<b>important:</b> the size of `sk` is `sk_size` + `kappa_bytes` + `pk_size`!)
+     * @return __0__ in case of success
+     */
+    int r5_cca_kem_decapsulate_batch(r5_ctx *ctx, unsigned char *k[], const unsigned char *ct[], size_t count, const unsigned char *sk);
 
 #ifdef __cplusplus
 }
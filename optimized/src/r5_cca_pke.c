@@ -24,11 +24,11 @@
  * Public functions
  ******************************************************************************/
 
-int r5_cca_pke_keygen(unsigned char *pk, unsigned char *sk) {
-    return r5_cca_kem_keygen(pk, sk);
+int r5_cca_pke_keygen(r5_ctx *ctx, unsigned char *pk, unsigned char *sk) {
+    return r5_cca_kem_keygen(ctx, pk, sk);
 }
 
-int r5_cca_pke_encrypt(unsigned char *ct, unsigned long long *ct_len, const unsigned char *m, const unsigned long long m_len, const unsigned char *pk) {
+int r5_cca_pke_encrypt(r5_ctx *ctx, unsigned char *ct, unsigned long long *ct_len, const unsigned char *m, const unsigned long long m_len, const unsigned char *pk) {
     int ret = 0;
     const unsigned long long c1_len = PARAMS_CT_SIZE + PARAMS_KAPPA_BYTES;
     unsigned char c1[PARAMS_CT_SIZE + PARAMS_KAPPA_BYTES];
@@ -36,7 +36,7 @@ int r5_cca_pke_encrypt(unsigned char *ct, unsigned long long *ct_len, const unsi
     unsigned char k[PARAMS_KAPPA_BYTES];
 
     /* Determine c1 and k */
-    ret = r5_cca_kem_encapsulate(c1, k, pk);
+    ret = r5_cca_kem_encapsulate(ctx, c1, k, pk);
     if (ret < 0){
         return ret;
     }
@@ -56,7 +56,7 @@ int r5_cca_pke_encrypt(unsigned char *ct, unsigned long long *ct_len, const unsi
     return ret;
 }
 
-int r5_cca_pke_decrypt(unsigned char *m, unsigned long long *m_len, const unsigned char *ct, unsigned long long ct_len, const unsigned char *sk) {
+int r5_cca_pke_decrypt(r5_ctx *ctx, unsigned char *m, unsigned long long *m_len, const unsigned char *ct, unsigned long long ct_len, const unsigned char *sk) {
     int ret = 0;
     unsigned char k[PARAMS_KAPPA_BYTES];
     const unsigned char * const c1 = ct;
@@ -71,7 +71,7 @@ int r5_cca_pke_decrypt(unsigned char *m, unsigned long long *m_len, const unsign
     }
 
     /* Determine k */
-    ret = r5_cca_kem_decapsulate(k, c1, sk);
+    ret = r5_cca_kem_decapsulate(ctx, k, c1, sk);
     if (ret < 0){
         return ret;
     }
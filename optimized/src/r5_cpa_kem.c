@@ -12,21 +12,35 @@
 #include "drbg.h"
 #include "rng.h"
 #include "misc.h"
+#include "r5_memory.h"
 
 #include <stdlib.h>
 #include <string.h>
 
 // CPA-KEM KeyGen()
 
-int r5_cpa_kem_keygen(uint8_t *pk, uint8_t *sk) {
-    r5_cpa_pke_keygen(pk, sk);
-
-    return 0;
+int r5_cpa_kem_keygen(r5_ctx *ctx, uint8_t *pk, uint8_t *sk) {
+    return r5_cpa_pke_keygen(ctx, pk, sk);
 }
 
 // CPA-KEM Encaps()
 
-int r5_cpa_kem_encapsulate(uint8_t *ct, uint8_t *k, const uint8_t *pk) {
+int r5_cpa_kem_encapsulate(r5_ctx *ctx, uint8_t *ct, uint8_t *k, const uint8_t *pk) {
+
+    r5_prepared_pk ppk;
+    int ret = 0;
+
+    ret = r5_cpa_pke_prepare_pk(ctx, &ppk, pk);
+    if (ret < 0){
+        return ret;
+    }
+
+    return r5_cpa_kem_encapsulate_prepared(ctx, ct, k, &ppk);
+}
+
+// CPA-KEM Encaps() with a prepared public key
+
+int r5_cpa_kem_encapsulate_prepared(r5_ctx *ctx, uint8_t *ct, uint8_t *k, const r5_prepared_pk *ppk) {
 
     uint8_t m[PARAMS_KAPPA_BYTES];
     uint8_t rho[PARAMS_KAPPA_BYTES];
@@ -34,10 +48,10 @@ int r5_cpa_kem_encapsulate(uint8_t *ct, uint8_t *k, const uint8_t *pk) {
     int ret = 0;
 
     /* Generate a random m and rho */
-    randombytes(m, PARAMS_KAPPA_BYTES);
-    randombytes(rho, PARAMS_KAPPA_BYTES);
+    r5_ctx_randombytes(ctx, m, PARAMS_KAPPA_BYTES);
+    r5_ctx_randombytes(ctx, rho, PARAMS_KAPPA_BYTES);
 
-    ret = r5_cpa_pke_encrypt(ct, pk, m, rho);
+    ret = r5_cpa_pke_encrypt_prepared(ct, ppk, m, rho);
     if (ret < 0){
         return ret;
     }
@@ -47,16 +61,110 @@ int r5_cpa_kem_encapsulate(uint8_t *ct, uint8_t *k, const uint8_t *pk) {
     return ret;
 }
 
+// CPA-KEM Encaps() to four prepared public keys, with the H hash and the
+// sampling of R done for the four at once
+
+static int encapsulate_prepared_4x(r5_ctx *ctx, uint8_t *ct[4], uint8_t *k[4], const r5_prepared_pk *ppk[4]) {
+
+    uint8_t m[4][PARAMS_KAPPA_BYTES];
+    uint8_t rho[4][PARAMS_KAPPA_BYTES];
+    const uint8_t *m4[4] = {m[0], m[1], m[2], m[3]};
+    const uint8_t *rho4[4] = {rho[0], rho[1], rho[2], rho[3]};
+    size_t i;
+    int ret = 0;
+
+    /* Generate a random m and rho */
+    for (i = 0; i < 4; i++) {
+        r5_ctx_randombytes(ctx, m[i], PARAMS_KAPPA_BYTES);
+        r5_ctx_randombytes(ctx, rho[i], PARAMS_KAPPA_BYTES);
+    }
+
+    ret = r5_cpa_pke_encrypt_prepared_4x(ct, ppk, m4, rho4);
+    if (ret < 0){
+        return ret;
+    }
+
+    HCPAKEM_4x(k[0], k[1], k[2], k[3], PARAMS_KAPPA_BYTES,
+               m[0], m[1], m[2], m[3], PARAMS_KAPPA_BYTES,
+               ct[0], ct[1], ct[2], ct[3], PARAMS_CT_SIZE);
+
+    return ret;
+}
+
+// CPA-KEM Encaps() to count public keys
+
+int r5_cpa_kem_encapsulate_batch(r5_ctx *ctx, uint8_t *ct[], uint8_t *k[], const uint8_t *pk[], size_t count) {
+
+    r5_prepared_pk *ppk;
+    const r5_prepared_pk *ppk4[4];
+    size_t i, j, n;
+    int ret = 0;
+    int enc = 0;
+
+    ppk = checked_malloc(4 * sizeof (r5_prepared_pk));
+    for (j = 0; j < 4; j++) {
+        ppk4[j] = &ppk[j];
+    }
+
+    for (i = 0; i < count && ret == 0; i += n) {
+        // a malformed key ends the batch, after the keys before it
+        for (n = 0; n < 4 && i + n < count; n++) {
+            ret = r5_cpa_pke_prepare_pk(ctx, &ppk[n], pk[i + n]);
+            if (ret < 0) {
+                break;
+            }
+        }
+
+        if (n == 4) {
+            ret = encapsulate_prepared_4x(ctx, &ct[i], &k[i], ppk4);
+        } else {
+            // the last keys, or the ones before a malformed key (whose
+            // error is kept unless an encryption fails)
+            for (j = 0; j < n && enc == 0; j++) {
+                enc = r5_cpa_kem_encapsulate_prepared(ctx, ct[i + j], k[i + j], &ppk[j]);
+            }
+            if (enc < 0) {
+                ret = enc;
+            }
+        }
+    }
+
+    free(ppk);
+
+    return ret;
+}
+
+// Expands a CPA-KEM secret key
+
+int r5_cpa_kem_expand_sk(r5_expanded_sk *esk, const uint8_t *sk) {
+    return r5_cpa_pke_expand_sk(esk, sk);
+}
+
 // CPA-KEM Decaps()
 
 int r5_cpa_kem_decapsulate(uint8_t *k, const uint8_t *ct, const uint8_t *sk) {
 
+    r5_expanded_sk esk;
+    int ret = 0;
+
+    ret = r5_cpa_kem_expand_sk(&esk, sk);
+    if (ret < 0){
+        return ret;
+    }
+
+    return r5_cpa_kem_decapsulate_expanded(k, ct, &esk);
+}
+
+// CPA-KEM Decaps() with an expanded secret key
+
+int r5_cpa_kem_decapsulate_expanded(uint8_t *k, const uint8_t *ct, const r5_expanded_sk *esk) {
+
     uint8_t m[PARAMS_KAPPA_BYTES];
 
     int ret = 0;
     
     /* Decrypt m */
-    ret = r5_cpa_pke_decrypt(m, sk, ct);
+    ret = r5_cpa_pke_decrypt_expanded(m, esk, ct);
     if (ret < 0){
         return ret;
     }
@@ -65,3 +173,40 @@ int r5_cpa_kem_decapsulate(uint8_t *k, const uint8_t *ct, const uint8_t *sk) {
     
     return ret;
 }
+
+// CPA-KEM Decaps() of count ciphertexts with one secret key, with the H
+// hashes done four at a time
+
+int r5_cpa_kem_decapsulate_batch(uint8_t *k[], const uint8_t *ct[], size_t count, const uint8_t *sk) {
+
+    r5_expanded_sk esk;
+    uint8_t m[4][PARAMS_KAPPA_BYTES];
+    size_t i, j;
+    int ret = 0;
+
+    ret = r5_cpa_kem_expand_sk(&esk, sk);
+    if (ret < 0){
+        return ret;
+    }
+
+    for (i = 0; i + 4 <= count && ret == 0; i += 4) {
+        /* Decrypt m */
+        for (j = 0; j < 4 && ret == 0; j++) {
+            ret = r5_cpa_pke_decrypt_expanded(m[j], &esk, ct[i + j]);
+        }
+        if (ret < 0) {
+            // a malformed ciphertext ends the batch, after the ones before it
+            for (j = i; j < i + 4 && (ret = r5_cpa_kem_decapsulate_expanded(k[j], ct[j], &esk)) == 0; j++);
+            break;
+        }
+
+        HCPAKEM_4x(k[i], k[i + 1], k[i + 2], k[i + 3], PARAMS_KAPPA_BYTES,
+                   m[0], m[1], m[2], m[3], PARAMS_KAPPA_BYTES,
+                   ct[i], ct[i + 1], ct[i + 2], ct[i + 3], PARAMS_CT_SIZE);
+    }
+    for (; i < count && ret == 0; i++) {
+        ret = r5_cpa_kem_decapsulate_expanded(k[i], ct[i], &esk);
+    }
+
+    return ret;
+}
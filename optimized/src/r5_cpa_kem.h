@@ -10,6 +10,8 @@
 #ifndef R5_CPA_KEM_H
 #define R5_CPA_KEM_H
 
+#include "r5_cpa_pke.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -17,20 +19,52 @@ extern "C" {
     /**
      * Generates a CPA KEM key pair. Uses the parameters as specified.
      *
+     * @param[in,out] ctx the context (see r5_ctx.h), `NULL` for the global state
      * @param[out] pk     public key
      * @param[out] sk     secret key
      * @return __0__ in case of success
      */
-    int r5_cpa_kem_keygen(unsigned char *pk, unsigned char *sk);
+    int r5_cpa_kem_keygen(r5_ctx *ctx, unsigned char *pk, unsigned char *sk);
 
     /**
      * CPA KEM encapsulate. Uses the parameters as specified.
      *
+     * @param[in,out] ctx the context (see r5_ctx.h), `NULL` for the global state
+     * @param[out] ct     key encapsulation message
+     * @param[out] k      shared secret
+     * @return __0__ in case of success
+     */
+    int r5_cpa_kem_encapsulate(r5_ctx *ctx, unsigned char *ct, unsigned char *k, const unsigned char *pk);
+
+    /**
+     * CPA KEM encapsulate with a prepared public key (see r5_cpa_pke_prepare_pk()).
+     *
+     * @param[in,out] ctx the context (see r5_ctx.h), `NULL` for the global state
      * @param[out] ct     key encapsulation message
      * @param[out] k      shared secret
+     * @param[in]  ppk    prepared public key with which the message is encapsulated
      * @return __0__ in case of success
      */
-    int r5_cpa_kem_encapsulate(unsigned char *ct, unsigned char *k, const unsigned char *pk);
+    int r5_cpa_kem_encapsulate_prepared(r5_ctx *ctx, unsigned char *ct, unsigned char *k, const r5_prepared_pk *ppk);
+
+    /**
+     * CPA KEM encapsulate to count public keys. Gives the same result as
+     * calling r5_cpa_kem_encapsulate() for each key in turn: the random
+     * values are drawn in the same order. Four keys at a time, the hashes
+     * and the sampling of R run side by side (in the 4x Keccak lanes with
+     * AVX2). A malformed key ends the batch: the keys before it are
+     * encapsulated to, the ones from it on are not. So does a failing
+     * encryption, with its error.
+     *
+     * @param[in,out] ctx the context (see r5_ctx.h), `NULL` for the global state
+     * @param[out] ct     key encapsulation messages
+     * @param[out] k      shared secrets
+     * @param[in]  pk     public keys with which the messages are encapsulated
+     * @param[in]  count  the number of public keys
+     * @return __0__ in case of success, otherwise the error of the first
+     *         key that failed
+     */
+    int r5_cpa_kem_encapsulate_batch(r5_ctx *ctx, unsigned char *ct[], unsigned char *k[], const unsigned char *pk[], size_t count);
 
     /**
      * CPA KEM de-capsulate. Uses the parameters as specified.
@@ -42,6 +76,40 @@ extern "C" {
      */
     int r5_cpa_kem_decapsulate(unsigned char *k, const unsigned char *ct, const unsigned char *sk);
 
+    /**
+     * Expands a CPA KEM secret key for r5_cpa_kem_decapsulate_expanded().
+     *
+     * @param[out] esk    expanded secret key
+     * @param[in]  sk     secret key
+     * @return __0__ in case of success
+     */
+    int r5_cpa_kem_expand_sk(r5_expanded_sk *esk, const unsigned char *sk);
+
+    /**
+     * CPA KEM de-capsulate with an expanded secret key.
+     *
+     * @param[out] k      shared secret
+     * @param[in]  ct     key encapsulation message
+     * @param[in]  esk    expanded secret key (only read)
+     * @return __0__ in case of success
+     */
+    int r5_cpa_kem_decapsulate_expanded(unsigned char *k, const unsigned char *ct, const r5_expanded_sk *esk);
+
+    /**
+     * CPA KEM de-capsulate count messages with one secret key. Gives the
+     * same result as calling r5_cpa_kem_decapsulate() for each message in
+     * turn. The secret key is expanded once, and four messages at a time
+     * the H hashes run side by side (in the 4x Keccak lanes with AVX2).
+     * A malformed message ends the batch, as in such a sequence of calls.
+     *
+     * @param[out] k      shared secrets
+     * @param[in]  ct     key encapsulation messages
+     * @param[in]  count  the number of messages
+     * @param[in]  sk     secret key with which the messages are to be de-capsulated
+     * @return __0__ in case of success
+     */
+    int r5_cpa_kem_decapsulate_batch(unsigned char *k[], const unsigned char *ct[], size_t count, const unsigned char *sk);
+
 #ifdef __cplusplus
 }
 #endif
@@ -8,10 +8,103 @@
 
 #include <stdint.h>
 
-int r5_cpa_pke_keygen(uint8_t *pk, uint8_t *sk);
+#include "r5_parameter_sets.h"
+#if PARAMS_K == 1
+#include "ringmul.h"
+#else
+#include "a_random.h"
+#endif
+#include "r5_hash.h"
+#include "r5_ctx.h"
 
-int r5_cpa_pke_encrypt(uint8_t *ct, const uint8_t *pk, const uint8_t *m, const uint8_t *rho);
+/*
+ * Prepared public key: everything encryption derives from the public key
+ * alone, so that it is done once per key instead of once per encryption.
+ *
+ *   pk             the packed public key (sigma | B), as hashed by the CCA KEM
+ *   A              ND: A, lifted (and duplicated) in the ringmul layout;
+ *                  N1: A_random, for tau 0 (unless it is streamed, see
+ *                  a_random.h) and 2
+ *   A_permutation  N1: the row permutation, for tau 1 and 2
+ *   A_fixed        N1: the A_fixed matrix the key is prepared with, for
+ *                  tau 1 (see r5_ctx_set_A_fixed()); not a copy, so the
+ *                  matrix must outlive the prepared key
+ *   B              B, unpacked (mod p)
+ *   G, H           the G and H hashes of the CCA KEM, with their domain
+ *                  absorbed; only set up by r5_cca_kem_prepare_pk(). G
+ *                  hashes (m, pk), with the random m first, so the key
+ *                  itself cannot be absorbed ahead of time.
+ *
+ * The tau 0 N1 variant holds the full d x d matrix, so it is large: allocate
+ * it on the heap.
+ */
+typedef struct {
+    uint8_t pk[PARAMS_PK_SIZE];
+#if PARAMS_K == 1
+    modq_t A[RINGMUL_LIFT_LEN];
+    modp_t B[PARAMS_N];
+#else
+#if PARAMS_TAU == 0
+#ifndef A_RANDOM_STREAM
+    modq_t A[NBLOCKS*((PARAMS_K+NBLOCKS-1)/NBLOCKS)][PARAMS_D];
+#endif
+#elif PARAMS_TAU == 1
+    uint32_t A_permutation[PARAMS_D];
+    const modq_t *A_fixed;
+#elif PARAMS_TAU == 2
+    modq_t A[PARAMS_TAU2_LEN + PARAMS_D];
+    uint16_t A_permutation[PARAMS_D];
+#endif
+    modp_t B[PARAMS_D][PARAMS_N_BAR];
+#endif
+    r5_hash_prefix G;
+    r5_hash_prefix H;
+} r5_prepared_pk;
+
+/*
+ * Expanded secret key: the ternary secret S as sampled from the secret key
+ * seed, so that decryption does not sample it again. Its form is the one of
+ * the build (see tern_secret): dense coefficients in the constant-time
+ * builds, (+1, -1) index pairs otherwise. It is only read by decryption.
+ */
+typedef struct {
+#if PARAMS_K == 1
+    tern_secret S;
+#else
+    tern_secret_s S;
+#endif
+} r5_expanded_sk;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// the random bytes (and for tau 1 A_fixed) are taken from ctx, the global
+// ones if NULL (see r5_ctx.h)
+int r5_cpa_pke_keygen(r5_ctx *ctx, uint8_t *pk, uint8_t *sk);
+
+int r5_cpa_pke_encrypt(r5_ctx *ctx, uint8_t *ct, const uint8_t *pk, const uint8_t *m, const uint8_t *rho);
 
 int r5_cpa_pke_decrypt(uint8_t *m, const uint8_t *sk, const uint8_t *ct);
 
+// expand pk into ppk; negative if pk is malformed (CM_MALFORMED). The CCA
+// KEM also needs the hash states: see r5_cca_kem_prepare_pk()
+int r5_cpa_pke_prepare_pk(r5_ctx *ctx, r5_prepared_pk *ppk, const uint8_t *pk);
+
+// same as r5_cpa_pke_encrypt, with a prepared public key
+int r5_cpa_pke_encrypt_prepared(uint8_t *ct, const r5_prepared_pk *ppk, const uint8_t *m, const uint8_t *rho);
+
+// four r5_cpa_pke_encrypt_prepared at once, with the R sampled together
+int r5_cpa_pke_encrypt_prepared_4x(uint8_t *ct[4], const r5_prepared_pk *ppk[4], const uint8_t *m[4], const uint8_t *rho[4]);
+
+// expand sk into esk
+int r5_cpa_pke_expand_sk(r5_expanded_sk *esk, const uint8_t *sk);
+
+// same as r5_cpa_pke_decrypt, with an expanded secret key
+int r5_cpa_pke_decrypt_expanded(uint8_t *m, const r5_expanded_sk *esk, const uint8_t *ct);
+
+#ifdef __cplusplus
+}
+#endif
+
 #endif /* _R5_CPA_PKE_H_ */
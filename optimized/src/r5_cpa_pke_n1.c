@@ -15,12 +15,18 @@
 #include "misc.h"
 #include "a_random.h"
 #include "pack.h"
+#include "r5_parallel.h"
+#include "r5_memory.h"
+
+#include <string.h>
 
 #ifdef DEBUG
-#if PARAMS_TAU==0
+#if PARAMS_TAU==0 && defined(A_RANDOM_STREAM)
+#define A_element(r,c) 0 // A is not kept when it is streamed
+#elif PARAMS_TAU==0
 #define A_element(r,c) A_random[r][c]
 #elif PARAMS_TAU == 1
-#define A_element(r,c) A_fixed[A_permutation[r] + (uint32_t) c]
+#define A_element(r,c) A_matrix[A_permutation[r] + (uint32_t) c]
 #elif PARAMS_TAU == 2
 #define A_element(r,c) A_random[A_permutation[r] + (uint16_t) c]
 #endif
@@ -52,6 +58,17 @@ static int create_A_permutation(uint32_t A_permutation[PARAMS_D], const unsigned
     return 0;
 }
 
+// the A_fixed of ctx, the global one without a context
+static const modq_t *ctx_A_fixed(const r5_ctx *ctx) {
+    if (ctx == NULL) {
+        return A_fixed;
+    }
+    if (ctx->A_fixed == NULL) {
+        DEBUG_ERROR("No A_fixed set in the context (see r5_ctx_set_A_fixed())\n");
+    }
+    return (const modq_t *) ctx->A_fixed;
+}
+
 #elif PARAMS_TAU == 2
 
 static int create_A_permutation(uint16_t A_permutation[PARAMS_D], const unsigned char *sigma) {
@@ -76,21 +93,106 @@ static int create_A_permutation(uint16_t A_permutation[PARAMS_D], const unsigned
 
 #endif
 
+#if PARAMS_TAU == 0 && !defined(A_RANDOM_STREAM) && defined(THREADS) && THREADS > 1
+
+// the multiplications with A, with the rows of A in THREADS slices of
+// A_SLICE_ROWS rows, one per thread
+
+#define A_SLICE_ROWS ((PARAMS_D + THREADS - 1) / THREADS)
+
+typedef struct {
+    modq_t (*d)[PARAMS_N_BAR];
+    const modq_t (*a)[PARAMS_D];
+    tern_secret *s_t;
+} matmul_as_q_job;
+
+static void matmul_as_q_task(void *arg, size_t i) {
+    const matmul_as_q_job *job = arg;
+    size_t row0 = i * A_SLICE_ROWS;
+
+    if (row0 < PARAMS_D) {
+        matmul_as_q_rows(&job->d[row0], &job->a[row0], PARAMS_D - row0 < A_SLICE_ROWS ? PARAMS_D - row0 : A_SLICE_ROWS, job->s_t);
+    }
+}
+
+// B = A * S, the slices setting their own rows of B
+static void matmul_as_q_threads(modq_t d[PARAMS_D][PARAMS_N_BAR], const modq_t a[][PARAMS_D], tern_secret_s s_t) {
+    matmul_as_q_job job;
+
+    job.d = d;
+    job.a = a;
+    job.s_t = s_t;
+    r5_parallel_for(THREADS, matmul_as_q_task, &job);
+}
+
+typedef struct {
+    modq_t (*d[THREADS])[PARAMS_D];
+    const modq_t (*a)[PARAMS_D];
+    tern_secret *r_t;
+} matmul_rta_q_job;
+
+static void matmul_rta_q_task(void *arg, size_t i) {
+    const matmul_rta_q_job *job = arg;
+    size_t row0 = i * A_SLICE_ROWS;
+
+    memset(job->d[i], 0, PARAMS_M_BAR * PARAMS_D * sizeof (modq_t));
+    if (row0 < PARAMS_D) {
+        matmul_rta_q_rows(job->d[i], &job->a[row0], row0, PARAMS_D - row0 < A_SLICE_ROWS ? PARAMS_D - row0 : A_SLICE_ROWS, job->r_t);
+    }
+}
+
+// U^T = (R^T x A)^T, each slice adding to a partial U^T of its own. The
+// partials are summed in a fixed order, so the result does not depend on
+// the threads.
+static void matmul_rta_q_threads(modq_t d[PARAMS_M_BAR][PARAMS_D], const modq_t a[][PARAMS_D], tern_secret_r r_t) {
+    matmul_rta_q_job job;
+    modq_t (*partial)[PARAMS_M_BAR][PARAMS_D];
+    size_t i, l, j;
+
+    partial = checked_malloc((THREADS - 1) * sizeof (*partial));
+    job.d[0] = d;
+    for (i = 1; i < THREADS; i++) {
+        job.d[i] = partial[i - 1];
+    }
+    job.a = a;
+    job.r_t = r_t;
+    r5_parallel_for(THREADS, matmul_rta_q_task, &job);
+
+    for (i = 0; i < THREADS - 1; i++) {
+        for (l = 0; l < PARAMS_M_BAR; l++) {
+            for (j = 0; j < PARAMS_D; j++) {
+                d[l][j] = (modq_t) (d[l][j] + partial[i][l][j]);
+            }
+        }
+    }
+    free(partial);
+}
+
+#endif
+
 // generate a keypair (sigma, B)
-int r5_cpa_pke_keygen(uint8_t *pk, uint8_t *sk) {
+int r5_cpa_pke_keygen(r5_ctx *ctx, uint8_t *pk, uint8_t *sk) {
     
     modq_t B[PARAMS_D][PARAMS_N_BAR];
     tern_secret_s S_T;
     
-    randombytes(pk, PARAMS_KAPPA_BYTES); // sigma = seed of (permutation of) A
-#if PARAMS_TAU == 0
+    r5_ctx_randombytes(ctx, pk, PARAMS_KAPPA_BYTES); // sigma = seed of (permutation of) A
+#if PARAMS_TAU == 0 && defined(A_RANDOM_STREAM)
+    a_random_stream A_stream;
+    const modq_t (*A_rows)[PARAMS_D];
+    size_t row0, nrows;
+#elif PARAMS_TAU == 0
     modq_t A_random[NBLOCKS*((PARAMS_K+NBLOCKS-1)/NBLOCKS)][PARAMS_D];
     create_A_random((modq_t *) A_random, pk);
     #define A_matrix A_random
 #elif PARAMS_TAU == 1
     uint32_t A_permutation[PARAMS_D];
+    const modq_t *A_fixed_ctx = ctx_A_fixed(ctx);
+    if (A_fixed_ctx == NULL) {
+        return -1;
+    }
     create_A_permutation(A_permutation, pk);
-    #define A_matrix A_fixed
+    #define A_matrix A_fixed_ctx
 #elif PARAMS_TAU == 2
     modq_t A_random[PARAMS_TAU2_LEN + PARAMS_D];
     create_A_random(A_random, pk);
@@ -102,11 +204,18 @@ int r5_cpa_pke_keygen(uint8_t *pk, uint8_t *sk) {
 #endif
     
     // secret key -- Random S
-    randombytes(sk, PARAMS_KAPPA_BYTES);
+    r5_ctx_randombytes(ctx, sk, PARAMS_KAPPA_BYTES);
     create_secret_matrix_s_t(S_T, sk);
     
     // B = A * S
-#if PARAMS_TAU == 0
+#if PARAMS_TAU == 0 && defined(A_RANDOM_STREAM)
+    a_random_stream_init(&A_stream, pk);
+    while ((nrows = a_random_stream_next(&A_stream, &A_rows, &row0)) > 0) {
+        matmul_as_q_rows(&B[row0], A_rows, nrows, S_T);
+    }
+#elif PARAMS_TAU == 0 && defined(THREADS) && THREADS > 1
+    matmul_as_q_threads(B, (const modq_t (*)[PARAMS_D]) A_matrix, S_T);
+#elif PARAMS_TAU == 0
     matmul_as_q(B, A_matrix, S_T);
 #else
     matmul_as_q(B, A_matrix, A_permutation, S_T);
@@ -138,44 +247,65 @@ int r5_cpa_pke_keygen(uint8_t *pk, uint8_t *sk) {
     return 0;
 }
 
-int r5_cpa_pke_encrypt(uint8_t *ct, const uint8_t *pk, const uint8_t *m, const uint8_t *rho) {
-    
-    size_t i, j;
-    tern_secret_r R_T;
-    modq_t U_T[PARAMS_M_BAR][PARAMS_D];
-    modp_t B[PARAMS_D][PARAMS_N_BAR];
-    modp_t X[PARAMS_MU];
-    uint8_t m1[BITS_TO_BYTES(PARAMS_MU * PARAMS_B_BITS)];
-    modp_t t, tm;
+int r5_cpa_pke_prepare_pk(r5_ctx *ctx, r5_prepared_pk *ppk, const uint8_t *pk) {
+    size_t i;
+
+#if PARAMS_TAU == 1
+    ppk->A_fixed = ctx_A_fixed(ctx);
+    if (ppk->A_fixed == NULL) {
+        return -1;
+    }
+#else
+    (void) ctx; // A is generated from sigma
+#endif
 
-    unpack_p(&B[0][0], pk + PARAMS_KAPPA_BYTES, PARAMS_D*PARAMS_N_BAR);
+    unpack_p(&ppk->B[0][0], pk + PARAMS_KAPPA_BYTES, PARAMS_D*PARAMS_N_BAR);
     
 #if CM_MALFORMED
     int ret;
-    ret = checkPublicParameter(B, PARAMS_N_BAR);
+    ret = checkPublicParameter(&ppk->B[0][0], PARAMS_N_BAR);
     if (ret < 0){
         return ret;
     }
 #endif
     
-    #undef A_matrix
-#if PARAMS_TAU == 0
-    modq_t A_random[NBLOCKS*((PARAMS_K+NBLOCKS-1)/NBLOCKS)][PARAMS_D];
-    create_A_random((modq_t *) A_random, pk);
-    #define A_matrix A_random
+#if PARAMS_TAU == 0 && !defined(A_RANDOM_STREAM)
+    create_A_random((modq_t *) ppk->A, pk);
 #elif PARAMS_TAU == 1
-    uint32_t A_permutation[PARAMS_D];
-    create_A_permutation(A_permutation, pk);
-    #define A_matrix A_fixed
+    create_A_permutation(ppk->A_permutation, pk);
 #elif PARAMS_TAU == 2
-    modq_t A_random[PARAMS_TAU2_LEN + PARAMS_D];
-    create_A_random(A_random, pk);
-    for (i=0; i < PARAMS_D ; i++) {A_random[PARAMS_TAU2_LEN + i] = A_random[i];} //memcpy(A_random + PARAMS_TAU2_LEN, A_random, PARAMS_D * sizeof (modq_t));
-    uint16_t A_permutation[PARAMS_D];
-    create_A_permutation(A_permutation, pk);
-    #define A_matrix A_random
+    create_A_random(ppk->A, pk);
+    for (i=0; i < PARAMS_D ; i++) {ppk->A[PARAMS_TAU2_LEN + i] = ppk->A[i];} //memcpy(A_random + PARAMS_TAU2_LEN, A_random, PARAMS_D * sizeof (modq_t));
+    create_A_permutation(ppk->A_permutation, pk);
 #endif
+
+    for (i = 0; i < PARAMS_PK_SIZE; i++) {ppk->pk[i] = pk[i];}
+
+    return 0;
+}
+
+int r5_cpa_pke_encrypt(r5_ctx *ctx, uint8_t *ct, const uint8_t *pk, const uint8_t *m, const uint8_t *rho) {
+    r5_prepared_pk ppk;
+    int ret;
+
+    ret = r5_cpa_pke_prepare_pk(ctx, &ppk, pk);
+    if (ret < 0){
+        return ret;
+    }
+
+    return r5_cpa_pke_encrypt_prepared(ct, &ppk, m, rho);
+}
+
+// encryption with R already sampled from rho
+static void encrypt_r(uint8_t *ct, const r5_prepared_pk *ppk, const uint8_t *m, const uint8_t *rho, tern_secret_r R_T) {
     
+    size_t i;
+    modq_t U_T[PARAMS_M_BAR][PARAMS_D];
+    modp_t X[PARAMS_MU];
+    modp_t v[PARAMS_MU];
+    uint8_t m1[BITS_TO_BYTES(PARAMS_MU * PARAMS_B_BITS)];
+    modp_t t, tm;
+
     for (i=0; i < PARAMS_KAPPA_BYTES; i++) {m1[i] = m[i];} //
     //memcpy(m1, m, PARAMS_KAPPA_BYTES);
     for (i=PARAMS_KAPPA_BYTES; i <  BITS_TO_BYTES(PARAMS_MU * PARAMS_B_BITS) ; i++) {m1[i] = 0;} //
@@ -185,23 +315,31 @@ int r5_cpa_pke_encrypt(uint8_t *ct, const uint8_t *pk, const uint8_t *m, const u
     xef_compute(m1, PARAMS_KAPPA_BYTES, PARAMS_F);
 #endif
 
-    create_secret_matrix_r_t(R_T, rho); // Create R
+#if PARAMS_TAU == 0 && defined(A_RANDOM_STREAM)
+    a_random_stream A_stream;
+    const modq_t (*A_rows)[PARAMS_D];
+    size_t row0, nrows;
 
-#if PARAMS_TAU == 0
-    matmul_rta_q(U_T, A_matrix, R_T); // U^T = (R^T x A)^T   (mod q)
+    memset(U_T, 0, sizeof (U_T));
+    a_random_stream_init(&A_stream, ppk->pk);
+    while ((nrows = a_random_stream_next(&A_stream, &A_rows, &row0)) > 0) {
+        matmul_rta_q_rows(U_T, A_rows, row0, nrows, R_T); // U^T = (R^T x A)^T   (mod q)
+    }
+#elif PARAMS_TAU == 0 && defined(THREADS) && THREADS > 1
+    matmul_rta_q_threads(U_T, ppk->A, R_T); // U^T = (R^T x A)^T   (mod q)
+#elif PARAMS_TAU == 0
+    matmul_rta_q(U_T, (modq_t (*)[PARAMS_D]) ppk->A, R_T); // U^T = (R^T x A)^T   (mod q)
+#elif PARAMS_TAU == 1
+    matmul_rta_q(U_T, ppk->A_fixed, ppk->A_permutation, R_T);
 #else
-    matmul_rta_q(U_T, A_matrix, A_permutation, R_T);
+    matmul_rta_q(U_T, ppk->A, ppk->A_permutation, R_T);
 #endif
     
-    matmul_btr_p(X, B, R_T); // X = R^T x B   (mod p)
+    matmul_btr_p(X, (modp_t (*)[PARAMS_N_BAR]) ppk->B, R_T); // X = R^T x B   (mod p)
 
     pack_qp(ct, &U_T[0][0], PARAMS_H2, PARAMS_D * PARAMS_M_BAR,(size_t) BITS_TO_BYTES(PARAMS_P_BITS * PARAMS_D * PARAMS_M_BAR));
     
-    for (i=0; i < PARAMS_MUT_SIZE; i++) {ct[PARAMS_DPU_SIZE+i]=0;} // memset(ct + PARAMS_DPU_SIZE, 0, PARAMS_MUT_SIZE);
-    
-    j = 8 * PARAMS_DPU_SIZE;
-
-    for (i = 0; i < PARAMS_MU; i++) { // compute, pack v
+    for (i = 0; i < PARAMS_MU; i++) { // compute v
         t = (modp_t) ((X[i] + PARAMS_H2) >> (PARAMS_P_BITS - PARAMS_T_BITS)); // compress p->t
         tm = (modp_t) (m1[(i * PARAMS_B_BITS) >> 3] >> ((i * PARAMS_B_BITS) & 7)); // add message
         
@@ -212,32 +350,18 @@ int r5_cpa_pke_encrypt(uint8_t *ct, const uint8_t *pk, const uint8_t *m, const u
         }
 #endif
         
-        t = (modp_t) (t + ((tm & ((1 << PARAMS_B_BITS) - 1)) << (PARAMS_T_BITS - PARAMS_B_BITS))) & ((1 << PARAMS_T_BITS) - 1);
-        
-        ct[j >> 3] |= (uint8_t) (t << (j & 7)); // pack t bits
-        if ((j & 7) + PARAMS_T_BITS > 8) {
-            ct[(j >> 3) + 1] |= (uint8_t) (t >> (8 - (j & 7)));
-            if ((j & 7) + PARAMS_T_BITS > 16) {
-                ct[(j >> 3) + 2] |= (uint8_t) (t >> (16 - (j & 7)));
-            }
-        }
-        j += PARAMS_T_BITS;
+        v[i] = (modp_t) (t + ((tm & ((1 << PARAMS_B_BITS) - 1)) << (PARAMS_T_BITS - PARAMS_B_BITS))) & ((1 << PARAMS_T_BITS) - 1);
     }
-    
+    pack_t(ct + PARAMS_DPU_SIZE, v, PARAMS_MU); // pack v
+
+    (void) rho; // only printed in DEBUG builds
     DEBUG_PRINT(
         print_hex("r5_cpa_pke_encrypt: m", m, PARAMS_KAPPA_BYTES, 1);
         print_hex("r5_cpa_pke_encrypt: rho", rho, PARAMS_KAPPA_BYTES, 1);
-        print_hex("r5_cpa_pke_encrypt: sigma", pk, PARAMS_KAPPA_BYTES, 1);
-        modq_t DEBUG_OUT_A[PARAMS_D][PARAMS_D];
-        for (int i = 0; i < PARAMS_D; ++i) {
-            for (int j = 0; j < PARAMS_D; ++j) {
-                DEBUG_OUT_A[i][j] = (uint16_t) (A_element(i, j) & (PARAMS_Q - 1));
-            }
-        }
-        
+        print_hex("r5_cpa_pke_encrypt: sigma", ppk->pk, PARAMS_KAPPA_BYTES, 1);
         uint16_t debug_u[PARAMS_D][PARAMS_M_BAR];
         for (i = 0; i < PARAMS_D; ++i) {
-            for (j = 0; j < PARAMS_M_BAR; ++j) {
+            for (size_t j = 0; j < PARAMS_M_BAR; ++j) {
                 debug_u[i][j] = (uint16_t) (U_T[j][i] & (PARAMS_Q - 1));
             }
         }
@@ -251,21 +375,52 @@ int r5_cpa_pke_encrypt(uint8_t *ct, const uint8_t *pk, const uint8_t *m, const u
         print_hex("r5_cpa_pke_encrypt: m1", m1, BITS_TO_BYTES(PARAMS_MU * PARAMS_B_BITS), 1);
     
     )
+}
+
+int r5_cpa_pke_encrypt_prepared(uint8_t *ct, const r5_prepared_pk *ppk, const uint8_t *m, const uint8_t *rho) {
+    tern_secret_r R_T;
+
+    create_secret_matrix_r_t(R_T, rho); // Create R
+
+    encrypt_r(ct, ppk, m, rho, R_T);
+
+    return 0;
+}
+
+int r5_cpa_pke_encrypt_prepared_4x(uint8_t *ct[4], const r5_prepared_pk *ppk[4], const uint8_t *m[4], const uint8_t *rho[4]) {
+    size_t i;
+    tern_secret_r R_T[4];
+
+    // Create the four R at once
+    create_secret_matrix_r_t_4x(R_T[0], R_T[1], R_T[2], R_T[3], rho[0], rho[1], rho[2], rho[3]);
+
+    for (i = 0; i < 4; i++) {
+        encrypt_r(ct[i], ppk[i], m[i], rho[i], R_T[i]);
+    }
+
+    return 0;
+}
+
+int r5_cpa_pke_expand_sk(r5_expanded_sk *esk, const uint8_t *sk) {
+    create_secret_matrix_s_t(esk->S, sk);
 
     return 0;
 }
 
 int r5_cpa_pke_decrypt(uint8_t *m, const uint8_t *sk, const uint8_t *ct) {
-    size_t i, j;
-    
-    tern_secret_s S_T;
+    r5_expanded_sk esk;
 
-    modp_t U_T[PARAMS_M_BAR][PARAMS_D];
-    modp_t v[PARAMS_MU];
-    modp_t t, X_prime[PARAMS_MU];
-    uint8_t m1[BITS_TO_BYTES(PARAMS_MU * PARAMS_B_BITS)] = {0};
+    r5_cpa_pke_expand_sk(&esk, sk);
 
-    create_secret_matrix_s_t(S_T, sk);
+    return r5_cpa_pke_decrypt_expanded(m, &esk, ct);
+}
+
+int r5_cpa_pke_decrypt_expanded(uint8_t *m, const r5_expanded_sk *esk, const uint8_t *ct) {
+    size_t i;
+
+    modp_t U_T[PARAMS_M_BAR][PARAMS_D];
+    modp_t X_prime[PARAMS_MU];
+    uint8_t m1[BITS_TO_BYTES(PARAMS_MU * PARAMS_B_BITS)];
 
     unpack_p((modp_t *) U_T, ct, PARAMS_D*PARAMS_M_BAR);
     
@@ -277,37 +432,10 @@ int r5_cpa_pke_decrypt(uint8_t *m, const uint8_t *sk, const uint8_t *ct) {
     }
 #endif
     
-    j = 8 * PARAMS_DPU_SIZE;
-    for (i = 0; i < PARAMS_MU; i++) {
-        t = (modp_t) (ct[j >> 3] >> (j & 7)); // unpack t bits
-        if ((j & 7) + PARAMS_T_BITS > 8) {
-            t |= (modp_t) (ct[(j >> 3) + 1] << (8 - (j & 7)));
-            if ((j & 7) + PARAMS_T_BITS > 16) {
-                t |= (modp_t) ((ct[(j >> 3) + 2]) << (16 - (j & 7)));
-            }
-        }
-        v[i] = t & ((1 << PARAMS_T_BITS) - 1);
-        j += PARAMS_T_BITS;
-    }
-    
-    matmul_stu_p(X_prime, U_T, S_T); // X' = S^T * U (mod p)
+    matmul_stu_p(X_prime, U_T, esk->S); // X' = S^T * U (mod p)
 
-    modp_t x_p;
-    
-    for (i = 0; i < PARAMS_MU; i++) {
-        // v - X' as mod q value (to be able to perform the rounding!)
-        x_p = (modp_t) ((v[i] << (PARAMS_P_BITS - PARAMS_T_BITS)) - X_prime[i]);
-
-        x_p = (modp_t) (((x_p + PARAMS_H3) >> (PARAMS_P_BITS - PARAMS_B_BITS)) & ((1 << PARAMS_B_BITS) - 1));
-
-        m1[i * PARAMS_B_BITS >> 3] = (uint8_t) (m1[i * PARAMS_B_BITS >> 3] | (x_p << ((i * PARAMS_B_BITS) & 7)));
-#if (8 % PARAMS_B_BITS != 0)
-        if (((i * PARAMS_B_BITS) & 7) + PARAMS_B_BITS > 8) {
-            /* Spill over to next message byte */
-            m1[(i * PARAMS_B_BITS >> 3) + 1] = (uint8_t) (m1[(i * PARAMS_B_BITS >> 3) + 1] | (x_p >> (8 - ((i * PARAMS_B_BITS) & 7))));
-        }
-#endif
-    }
+    // X' = v - X', compressed to b bits
+    unpack_t_message(m1, ct + PARAMS_DPU_SIZE, X_prime, PARAMS_MU);
     
 #if (PARAMS_XE != 0) // Apply error correction
     xef_compute(m1, PARAMS_KAPPA_BYTES, PARAMS_F);
@@ -318,8 +446,10 @@ int r5_cpa_pke_decrypt(uint8_t *m, const uint8_t *sk, const uint8_t *ct) {
 
     DEBUG_PRINT(
         uint16_t DEBUG_OUT_U[PARAMS_D][PARAMS_M_BAR];
+        modp_t v[PARAMS_MU];
+        unpack_t(v, ct + PARAMS_DPU_SIZE, PARAMS_MU);
         for (i = 0; i < PARAMS_D; ++i) {
-            for (j = 0; j < PARAMS_M_BAR; ++j) {
+            for (size_t j = 0; j < PARAMS_M_BAR; ++j) {
                 DEBUG_OUT_U[i][j] = U_T[j][i] & (PARAMS_P - 1);
             }
         }
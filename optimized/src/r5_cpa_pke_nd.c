@@ -43,17 +43,17 @@
 
 
 // generate a keypair (sigma, B)
-int r5_cpa_pke_keygen(uint8_t *pk, uint8_t *sk) {
+int r5_cpa_pke_keygen(r5_ctx *ctx, uint8_t *pk, uint8_t *sk) {
     modq_t A[NBLOCKS*  ((PARAMS_N+NBLOCKS-1) / NBLOCKS)];
     modq_t B[PARAMS_N];
     tern_secret S_idx;
 
-    randombytes(pk, PARAMS_KAPPA_BYTES); // sigma = seed of A
+    r5_ctx_randombytes(ctx, pk, PARAMS_KAPPA_BYTES); // sigma = seed of A
 
     // A from sigma
     create_A_random(A, pk);
 
-    randombytes(sk, PARAMS_KAPPA_BYTES); // secret key -- Random S
+    r5_ctx_randombytes(ctx, sk, PARAMS_KAPPA_BYTES); // secret key -- Random S
     create_secret_vector_s(S_idx, sk);
     
     // B = A * S
@@ -77,29 +77,60 @@ int r5_cpa_pke_keygen(uint8_t *pk, uint8_t *sk) {
     return 0;
 }
 
-int r5_cpa_pke_encrypt(uint8_t *ct, const uint8_t *pk, const uint8_t *m, const uint8_t *rho) {
-    size_t i, j;
-    modp_t t, tm;
+int r5_cpa_pke_prepare_pk(r5_ctx *ctx, r5_prepared_pk *ppk, const uint8_t *pk) {
+    size_t i;
     modq_t A[NBLOCKS*((PARAMS_N+NBLOCKS-1)/NBLOCKS)];
-    tern_secret R_idx;
-    modq_t U_T[PARAMS_N];
-    modp_t B[PARAMS_N];
-    modp_t X[PARAMS_MU];
-    uint8_t m1[BITS_TO_BYTES(PARAMS_MU * PARAMS_B_BITS)] = {0};
-    
+
+    (void) ctx; // A is generated from sigma
+
     // unpack public key
-    unpack_p(B, pk + PARAMS_KAPPA_BYTES, PARAMS_N);
+    unpack_p(ppk->B, pk + PARAMS_KAPPA_BYTES, PARAMS_N);
 
 #if CM_MALFORMED
     int ret;
-    ret = checkPublicParameter(B, 1);
+    ret = checkPublicParameter(ppk->B, 1);
     if (ret < 0){
         return ret;
     }
 #endif
-    
-    // A from sigma
+
+    // A from sigma, kept lifted for ringmul_q_lifted
     create_A_random(A, pk);
+    ringmul_q_lift(ppk->A, A);
+
+    for (i = 0; i < PARAMS_PK_SIZE; i++) {ppk->pk[i] = pk[i];}
+
+    DEBUG_PRINT(
+        print_hex("r5_cpa_pke_prepare_pk: sigma", pk, PARAMS_KAPPA_BYTES, 1);
+        for (i = 0; i < PARAMS_N; ++i) {
+            A[i] &= (PARAMS_Q - 1);
+        }
+        print_sage_u_vector_matrix("r5_cpa_pke_prepare_pk: A", A, PARAMS_K, PARAMS_K, PARAMS_N);
+    )
+
+    return 0;
+}
+
+int r5_cpa_pke_encrypt(r5_ctx *ctx, uint8_t *ct, const uint8_t *pk, const uint8_t *m, const uint8_t *rho) {
+    r5_prepared_pk ppk;
+    int ret;
+
+    ret = r5_cpa_pke_prepare_pk(ctx, &ppk, pk);
+    if (ret < 0){
+        return ret;
+    }
+
+    return r5_cpa_pke_encrypt_prepared(ct, &ppk, m, rho);
+}
+
+// encryption with R already sampled from rho
+static void encrypt_r(uint8_t *ct, const r5_prepared_pk *ppk, const uint8_t *m, const uint8_t *rho, tern_secret R_idx) {
+    size_t i;
+    modp_t t, tm;
+    modq_t U_T[PARAMS_N];
+    modp_t X[PARAMS_MU];
+    modp_t v[PARAMS_MU];
+    uint8_t m1[BITS_TO_BYTES(PARAMS_MU * PARAMS_B_BITS)] = {0};
     
     for (i = 0; i < PARAMS_KAPPA_BYTES; i++) {m1[i] = m[i];}
     
@@ -107,20 +138,14 @@ int r5_cpa_pke_encrypt(uint8_t *ct, const uint8_t *pk, const uint8_t *m, const u
     xef_compute(m1, PARAMS_KAPPA_BYTES, PARAMS_F);
 #endif
 
-    // Create R
-    create_secret_vector_r(R_idx, rho);
-
-    ringmul_q(U_T, A, R_idx); // U^T == U = A^T * R == A * R (mod q)
-    ringmul_p(X, B, R_idx); // X = B^T * R == B * R (mod p)
+    // U^T == U = A^T * R == A * R (mod q), X = B^T * R == B * R (mod p)
+    ringmul_qp(U_T, ppk->A, X, ppk->B, R_idx);
 
 
     //pack_q_p(ct, U_T, PARAMS_H2);
     pack_qp(ct, U_T, PARAMS_H2, PARAMS_N, PARAMS_DP_SIZE); // ct = U^T | v
     
-    for (i = 0; i < PARAMS_MUT_SIZE; i++) {ct[i+PARAMS_DP_SIZE] = 0;}
-    
-    j = 8 * PARAMS_DP_SIZE;
-    for (i = 0; i < PARAMS_MU; i++) { // compute, pack v
+    for (i = 0; i < PARAMS_MU; i++) { // compute v
         // compress p->t
         t = (modp_t) ((X[i] + PARAMS_H2) >> (PARAMS_P_BITS - PARAMS_T_BITS));
         // add message
@@ -131,26 +156,18 @@ int r5_cpa_pke_encrypt(uint8_t *ct, const uint8_t *pk, const uint8_t *m, const u
             tm = (modp_t) (tm | (m1[((i * PARAMS_B_BITS) >> 3) + 1] << (8 - ((i * PARAMS_B_BITS) & 7))));
         }
 #endif
-        t = (modp_t) (t + ((tm & ((1 << PARAMS_B_BITS) - 1)) << (PARAMS_T_BITS - PARAMS_B_BITS))) & ((1 << PARAMS_T_BITS) - 1);
-
-        ct[j >> 3] = (uint8_t) (ct[j >> 3] | (t << (j & 7))); // pack t bits
-        if ((j & 7) + PARAMS_T_BITS > 8) {
-            ct[(j >> 3) + 1] = (uint8_t) (ct[(j >> 3) + 1] | (t >> (8 - (j & 7))));
-        }
-        j += PARAMS_T_BITS;
+        v[i] = (modp_t) (t + ((tm & ((1 << PARAMS_B_BITS) - 1)) << (PARAMS_T_BITS - PARAMS_B_BITS))) & ((1 << PARAMS_T_BITS) - 1);
     }
+    pack_t(ct + PARAMS_DP_SIZE, v, PARAMS_MU); // pack v
 
+    (void) rho; // only printed in DEBUG builds
     DEBUG_PRINT(
         print_hex("r5_cpa_pke_encrypt: m", m, PARAMS_KAPPA_BYTES, 1);
         print_hex("r5_cpa_pke_encrypt: rho", rho, PARAMS_KAPPA_BYTES, 1);
-        print_hex("r5_cpa_pke_encrypt: sigma", pk, PARAMS_KAPPA_BYTES, 1);
-        for (i = 0; i < PARAMS_N; ++i) {
-            A[i] &= (PARAMS_Q - 1);
-        }
-        print_sage_u_vector_matrix("r5_cpa_pke_encrypt: A", A, PARAMS_K, PARAMS_K, PARAMS_N);
+        print_hex("r5_cpa_pke_encrypt: sigma", ppk->pk, PARAMS_KAPPA_BYTES, 1);
         uint16_t debug_out[PARAMS_N];
         for (i = 0; i < PARAMS_N; ++i) {
-            debug_out[i] = B[i];
+            debug_out[i] = ppk->B[i];
         }
         print_sage_u_vector_matrix("r5_cpa_pke_encrypt: B", debug_out, PARAMS_K, PARAMS_N_BAR, PARAMS_N);
         for (i = 0; i < PARAMS_N; ++i) {
@@ -164,20 +181,52 @@ int r5_cpa_pke_encrypt(uint8_t *ct, const uint8_t *pk, const uint8_t *m, const u
         print_sage_u_vector("r5_cpa_pke_encrypt: uncompressed X", debug_out, PARAMS_MU);
         print_hex("r5_cpa_pke_encrypt: m1", m1, BITS_TO_BYTES(PARAMS_MU * PARAMS_B_BITS), 1);
     )
+}
+
+int r5_cpa_pke_encrypt_prepared(uint8_t *ct, const r5_prepared_pk *ppk, const uint8_t *m, const uint8_t *rho) {
+    tern_secret R_idx;
+
+    // Create R
+    create_secret_vector_r(R_idx, rho);
+
+    encrypt_r(ct, ppk, m, rho, R_idx);
+
+    return 0;
+}
+
+int r5_cpa_pke_encrypt_prepared_4x(uint8_t *ct[4], const r5_prepared_pk *ppk[4], const uint8_t *m[4], const uint8_t *rho[4]) {
+    size_t i;
+    tern_secret R_idx[4];
+
+    // Create the four R at once
+    create_secret_vector_r_4x(R_idx[0], R_idx[1], R_idx[2], R_idx[3], rho[0], rho[1], rho[2], rho[3]);
+
+    for (i = 0; i < 4; i++) {
+        encrypt_r(ct[i], ppk[i], m[i], rho[i], R_idx[i]);
+    }
+
+    return 0;
+}
+
+int r5_cpa_pke_expand_sk(r5_expanded_sk *esk, const uint8_t *sk) {
+    create_secret_vector_s(esk->S, sk);
 
     return 0;
 }
 
 int r5_cpa_pke_decrypt(uint8_t *m, const uint8_t *sk, const uint8_t *ct) {
-    size_t i, j;
-    tern_secret S_idx;
-    modp_t x_p;
-    modp_t U_T[PARAMS_N];
-    modp_t v[PARAMS_MU];
-    modp_t t, X_prime[PARAMS_MU];
-    uint8_t m1[BITS_TO_BYTES(PARAMS_MU * PARAMS_B_BITS)] = {0};
+    r5_expanded_sk esk;
 
-    create_secret_vector_s(S_idx, sk);
+    r5_cpa_pke_expand_sk(&esk, sk);
+
+    return r5_cpa_pke_decrypt_expanded(m, &esk, ct);
+}
+
+int r5_cpa_pke_decrypt_expanded(uint8_t *m, const r5_expanded_sk *esk, const uint8_t *ct) {
+    size_t i;
+    modp_t U_T[PARAMS_N];
+    modp_t X_prime[PARAMS_MU];
+    uint8_t m1[BITS_TO_BYTES(PARAMS_MU * PARAMS_B_BITS)];
 
     unpack_p(U_T, ct, PARAMS_N);// ct = U^T | v
 
@@ -188,34 +237,11 @@ int r5_cpa_pke_decrypt(uint8_t *m, const uint8_t *sk, const uint8_t *ct) {
         return ret;
     }
 #endif
-    
-    j = 8 * PARAMS_DP_SIZE;
-    for (i = 0; i < PARAMS_MU; i++) {
-        t = (modp_t) (ct[j >> 3] >> (j & 7)); // unpack t bits
-        if ((j & 7) + PARAMS_T_BITS > 8) {
-            t = (modp_t) (t | ct[(j >> 3) + 1] << (8 - (j & 7)));
-        }
-        v[i] = t & ((1 << PARAMS_T_BITS) - 1);
-        j += PARAMS_T_BITS;
-    }
-
-    ringmul_p(X_prime, U_T, S_idx); // X' = S^T * U == U^T * S (mod p)
 
-    // X' = v - X', compressed to 1 bit
-    for (i = 0; i < PARAMS_MU; i++) {
-        // v - X' as mod p value (to be able to perform the rounding!)
-        x_p = (modp_t) ((v[i] << (PARAMS_P_BITS - PARAMS_T_BITS)) - X_prime[i]);
-        x_p = (modp_t) (((x_p + PARAMS_H3) >> (PARAMS_P_BITS - PARAMS_B_BITS)) & ((1 << PARAMS_B_BITS) - 1));
+    ringmul_p(X_prime, U_T, esk->S); // X' = S^T * U == U^T * S (mod p)
 
-        m1[i * PARAMS_B_BITS >> 3] = (uint8_t) (m1[i * PARAMS_B_BITS >> 3] | (x_p << ((i * PARAMS_B_BITS) & 7)));
-        
-#if (8 % PARAMS_B_BITS != 0)
-        if (((i * PARAMS_B_BITS) & 7) + PARAMS_B_BITS > 8) {
-            /* Spill over to next message byte */
-            m1[(i * PARAMS_B_BITS >> 3) + 1] = (uint8_t) (m1[(i * PARAMS_B_BITS >> 3) + 1] | (x_p >> (8 - ((i * PARAMS_B_BITS) & 7))));
-        }
-#endif
-    }
+    // X' = v - X', compressed to b bits
+    unpack_t_message(m1, ct + PARAMS_DP_SIZE, X_prime, PARAMS_MU);
 
 #if (PARAMS_XE != 0)
     // Apply error correction
@@ -227,6 +253,8 @@ int r5_cpa_pke_decrypt(uint8_t *m, const uint8_t *sk, const uint8_t *ct) {
 
     DEBUG_PRINT(
         uint16_t DEBUG_OUT[PARAMS_N];
+        modp_t v[PARAMS_MU];
+        unpack_t(v, ct + PARAMS_DP_SIZE, PARAMS_MU);
         for (i = 0; i < PARAMS_N; ++i) {
             DEBUG_OUT[i] = (uint16_t) U_T[i] & (PARAMS_P - 1);
         }
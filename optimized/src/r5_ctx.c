@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2020, Koninklijke Philips N.V.
+ */
+
+/**
+ * @file
+ * Implementation of the context of the `_ctx` functions of the NIST api.
+ * It does not depend on the parameter set, so a `DISPATCH` or `ALGS` build
+ * compiles it once for all variants.
+ */
+
+#include "r5_ctx.h"
+
+#include <string.h>
+
+int r5_ctx_init(r5_ctx *ctx, unsigned char *entropy_input, unsigned char *personalization_string) {
+    memset(ctx, 0, sizeof (*ctx));
+    randombytes_init_state(&ctx->rng_state, entropy_input, personalization_string, 256);
+
+    return 0;
+}
+
+void r5_ctx_set_rng(r5_ctx *ctx, r5_randombytes_fn randombytes, void *rng) {
+    ctx->randombytes = randombytes;
+    ctx->rng = rng;
+}
+
+void r5_ctx_set_A_fixed(r5_ctx *ctx, const uint16_t *A_fixed) {
+    ctx->A_fixed = A_fixed;
+}
+
+#ifndef R5_DISPATCH
+
+// the one set of the build (see r5_dispatch.c for a DISPATCH build)
+#if defined(AVX2) && defined(__AVX2__)
+#define KERNEL_SET_NAME "avx2"
+#else
+#define KERNEL_SET_NAME "generic"
+#endif
+
+int r5_ctx_set_kernels(r5_ctx *ctx, const char *name) {
+    (void) ctx;
+    return strcmp(name, KERNEL_SET_NAME) == 0 ? 0 : -1;
+}
+
+#endif
+
+void r5_ctx_clear(r5_ctx *ctx) {
+    randombytes_clear_state(&ctx->rng_state);
+    ctx->randombytes = NULL;
+    ctx->rng = NULL;
+    ctx->A_fixed = NULL;
+    ctx->kernels = NULL;
+}
+
+int r5_ctx_randombytes(r5_ctx *ctx, unsigned char *x, unsigned long long xlen) {
+    if (ctx == NULL) {
+        return randombytes(x, xlen);
+    }
+    if (ctx->randombytes != NULL) {
+        return ctx->randombytes(ctx->rng, x, xlen);
+    }
+    return randombytes_with_state(&ctx->rng_state, x, xlen);
+}
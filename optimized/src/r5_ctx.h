@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2020, Koninklijke Philips N.V.
+ */
+
+/**
+ * @file
+ * Declaration of the context of the `_ctx` functions of the NIST api.
+ *
+ * The functions of the NIST api draw their random bytes from randombytes()
+ * and (τ=1) take the global A_fixed, so the threads that call them share
+ * that state. A context holds this state for the calls made with it: a
+ * random bytes generator of its own (or one set by the application), the
+ * A_fixed matrix to use (τ=1) and, in a `DISPATCH` build, the kernel set
+ * to run. The working memory of a call is on its stack or allocated by it.
+ *
+ * A context can be used by one thread at a time. Threads that each have
+ * their own context do not share any mutable state. Passing a `NULL`
+ * context to a `_ctx` function is the same as calling the function without
+ * a context.
+ */
+
+#ifndef R5_CTX_H
+#define R5_CTX_H
+
+#include <stdint.h>
+
+#include "rng.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /**
+     * A random bytes function set with r5_ctx_set_rng().
+     *
+     * @param[in,out] rng  the state of the generator, as set
+     * @param[out]    x    destination of the random bytes
+     * @param[in]     xlen the number of random bytes
+     * @return __0__ in case of success
+     */
+    typedef int (*r5_randombytes_fn)(void *rng, unsigned char *x, unsigned long long xlen);
+
+    /**
+     * The context of the `_ctx` functions. Its fields are set through the
+     * functions below.
+     */
+    typedef struct {
+        r5_randombytes_fn randombytes; /**< The random bytes function set with r5_ctx_set_rng(), `NULL` for rng_state */
+        void *rng; /**< The state passed to randombytes */
+        randombytes_state rng_state; /**< The random bytes generator of the context */
+        const uint16_t *A_fixed; /**< The A_fixed matrix (τ=1), `NULL` if not set */
+        const void *kernels; /**< The kernel set (`DISPATCH`), `NULL` for the one chosen at start-up */
+    } r5_ctx;
+
+    /**
+     * Initializes a context, with a random bytes generator of its own. With
+     * `NIST_KAT_GENERATION` this is the AES-256 CTR DRBG of the NIST api,
+     * seeded with the given entropy; otherwise it reads /dev/urandom and the
+     * entropy is ignored.
+     *
+     * @param[out] ctx                    the context
+     * @param[in]  entropy_input          the entropy of the DRBG (48 bytes), `NULL` for all zero
+     * @param[in]  personalization_string an optional personalization string (48 bytes)
+     * @return __0__ in case of success
+     */
+    int r5_ctx_init(r5_ctx *ctx, unsigned char *entropy_input, unsigned char *personalization_string);
+
+    /**
+     * Makes the context draw its random bytes from the given function
+     * instead of its own generator.
+     *
+     * @param[in,out] ctx         the context
+     * @param[in]     randombytes the random bytes function, `NULL` for the generator of the context
+     * @param[in]     rng         the state passed to `randombytes`
+     */
+    void r5_ctx_set_rng(r5_ctx *ctx, r5_randombytes_fn randombytes, void *rng);
+
+    /**
+     * Sets the A_fixed matrix of the context (τ=1), e.g. the global A_fixed
+     * after map_A_fixed(), or one created with create_A_fixed_matrix(). The
+     * matrix is only read, so contexts can share it. A τ=1 key generation or
+     * encapsulation with a context without A_fixed fails.
+     *
+     * @param[in,out] ctx     the context
+     * @param[in]     A_fixed the matrix (`A_FIXED_LEN` elements)
+     */
+    void r5_ctx_set_A_fixed(r5_ctx *ctx, const uint16_t *A_fixed);
+
+    /**
+     * Selects the kernel set the context runs by name (see r5_kernels()).
+     * A `DISPATCH` build holds a `generic` and an `avx2` set, of which
+     * `avx2` can only be selected when the CPU supports it; other builds
+     * only hold the set they are compiled with.
+     *
+     * @param[in,out] ctx  the context
+     * @param[in]     name the name of the kernel set
+     * @return __0__ in case of success, __-1__ if the set is not available
+     *         (the selection is then unchanged)
+     */
+    int r5_ctx_set_kernels(r5_ctx *ctx, const char *name);
+
+    /**
+     * Releases the resources of a context and clears it.
+     *
+     * @param[in,out] ctx the context
+     */
+    void r5_ctx_clear(r5_ctx *ctx);
+
+    /**
+     * Generates random bytes with the generator of a context, or with
+     * randombytes() without one.
+     *
+     * @param[in,out] ctx  the context, `NULL` for randombytes()
+     * @param[out]    x    destination of the random bytes
+     * @param[in]     xlen the number of random bytes
+     * @return __0__ in case of success
+     */
+    int r5_ctx_randombytes(r5_ctx *ctx, unsigned char *x, unsigned long long xlen);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* R5_CTX_H */
@@ -0,0 +1,290 @@
+/*
+ * Copyright (c) 2020, Koninklijke Philips N.V.
+ */
+
+/**
+ * @file
+ * Implementation of the function that reports the kernels a build runs,
+ * and of the run-time choice of the kernel set (`DISPATCH` builds).
+ *
+ * A `DISPATCH` build compiles the library sources once per kernel set and
+ * links each set into a single object, in which the functions of the NIST
+ * api and r5_kernels() are renamed to r5_<set>_<name> and all other
+ * symbols are made local (see the Makefile). The functions below pass the
+ * calls on to the set chosen at start-up, or for the functions with a
+ * context to the set of the context (see r5_ctx_set_kernels()).
+ */
+
+#include "r5_dispatch.h"
+#include "r5_parameter_sets.h"
+
+#if defined(R5_DISPATCH)
+
+#include <stdlib.h>
+#include <string.h>
+#include "kem.h"
+
+/* kem.h and pke.h define the CRYPTO_ sizes each for their own api, only the
+   prototypes are needed here */
+#undef CRYPTO_PUBLICKEYBYTES
+#undef CRYPTO_SECRETKEYBYTES
+#undef CRYPTO_CIPHERTEXTBYTES
+#undef CRYPTO_BYTES
+
+#include "pke.h"
+#include "r5_ctx.h"
+
+// the renamed functions of a kernel set
+#ifdef ROUND5_CCA_PKE
+#define DECLARE_PKE_FUNCTIONS(set) \
+    int r5_##set##_crypto_encrypt_keypair(unsigned char *pk, unsigned char *sk); \
+    int r5_##set##_crypto_encrypt(unsigned char *ct, unsigned long long *ct_len, const unsigned char *m, const unsigned long long m_len, const unsigned char *pk); \
+    int r5_##set##_crypto_encrypt_open(unsigned char *m, unsigned long long *m_len, const unsigned char *ct, const unsigned long long ct_len, const unsigned char *sk); \
+    int r5_##set##_crypto_encrypt_keypair_ctx(r5_ctx *ctx, unsigned char *pk, unsigned char *sk); \
+    int r5_##set##_crypto_encrypt_ctx(r5_ctx *ctx, unsigned char *ct, unsigned long long *ct_len, const unsigned char *m, const unsigned long long m_len, const unsigned char *pk); \
+    int r5_##set##_crypto_encrypt_open_ctx(r5_ctx *ctx, unsigned char *m, unsigned long long *m_len, const unsigned char *ct, const unsigned long long ct_len, const unsigned char *sk);
+#define PKE_FUNCTIONS(set) , r5_##set##_crypto_encrypt_keypair, r5_##set##_crypto_encrypt, r5_##set##_crypto_encrypt_open, \
+    r5_##set##_crypto_encrypt_keypair_ctx, r5_##set##_crypto_encrypt_ctx, r5_##set##_crypto_encrypt_open_ctx
+#else
+#define DECLARE_PKE_FUNCTIONS(set)
+#define PKE_FUNCTIONS(set)
+#endif
+
+#define DECLARE_KERNEL_SET(set) \
+    const char *r5_##set##_r5_kernels(void); \
+    int r5_##set##_crypto_kem_keypair(unsigned char *pk, unsigned char *sk); \
+    int r5_##set##_crypto_kem_enc(unsigned char *ct, unsigned char *k, const unsigned char *pk); \
+    int r5_##set##_crypto_kem_enc_batch(unsigned char *ct[], unsigned char *k[], const unsigned char *pk[], size_t count); \
+    int r5_##set##_crypto_kem_dec(unsigned char *k, const unsigned char *ct, const unsigned char *sk); \
+    int r5_##set##_crypto_kem_dec_batch(unsigned char *k[], const unsigned char *ct[], size_t count, const unsigned char *sk); \
+    int r5_##set##_crypto_kem_keypair_ctx(r5_ctx *ctx, unsigned char *pk, unsigned char *sk); \
+    int r5_##set##_crypto_kem_enc_ctx(r5_ctx *ctx, unsigned char *ct, unsigned char *k, const unsigned char *pk); \
+    int r5_##set##_crypto_kem_enc_batch_ctx(r5_ctx *ctx, unsigned char *ct[], unsigned char *k[], const unsigned char *pk[], size_t count); \
+    int r5_##set##_crypto_kem_dec_ctx(r5_ctx *ctx, unsigned char *k, const unsigned char *ct, const unsigned char *sk); \
+    int r5_##set##_crypto_kem_dec_batch_ctx(r5_ctx *ctx, unsigned char *k[], const unsigned char *ct[], size_t count, const unsigned char *sk); \
+    DECLARE_PKE_FUNCTIONS(set)
+
+#define KERNEL_SET(set, supported) { \
+    #set, supported, r5_##set##_r5_kernels, \
+    r5_##set##_crypto_kem_keypair, r5_##set##_crypto_kem_enc, r5_##set##_crypto_kem_enc_batch, \
+    r5_##set##_crypto_kem_dec, r5_##set##_crypto_kem_dec_batch, \
+    r5_##set##_crypto_kem_keypair_ctx, r5_##set##_crypto_kem_enc_ctx, r5_##set##_crypto_kem_enc_batch_ctx, \
+    r5_##set##_crypto_kem_dec_ctx, r5_##set##_crypto_kem_dec_batch_ctx \
+    PKE_FUNCTIONS(set) }
+
+DECLARE_KERNEL_SET(generic)
+DECLARE_KERNEL_SET(avx2)
+
+typedef struct {
+    const char *name;
+    int (*supported)(void);
+    const char *(*kernels)(void);
+    int (*kem_keypair)(unsigned char *pk, unsigned char *sk);
+    int (*kem_enc)(unsigned char *ct, unsigned char *k, const unsigned char *pk);
+    int (*kem_enc_batch)(unsigned char *ct[], unsigned char *k[], const unsigned char *pk[], size_t count);
+    int (*kem_dec)(unsigned char *k, const unsigned char *ct, const unsigned char *sk);
+    int (*kem_dec_batch)(unsigned char *k[], const unsigned char *ct[], size_t count, const unsigned char *sk);
+    int (*kem_keypair_ctx)(r5_ctx *ctx, unsigned char *pk, unsigned char *sk);
+    int (*kem_enc_ctx)(r5_ctx *ctx, unsigned char *ct, unsigned char *k, const unsigned char *pk);
+    int (*kem_enc_batch_ctx)(r5_ctx *ctx, unsigned char *ct[], unsigned char *k[], const unsigned char *pk[], size_t count);
+    int (*kem_dec_ctx)(r5_ctx *ctx, unsigned char *k, const unsigned char *ct, const unsigned char *sk);
+    int (*kem_dec_batch_ctx)(r5_ctx *ctx, unsigned char *k[], const unsigned char *ct[], size_t count, const unsigned char *sk);
+#ifdef ROUND5_CCA_PKE
+    int (*encrypt_keypair)(unsigned char *pk, unsigned char *sk);
+    int (*encrypt)(unsigned char *ct, unsigned long long *ct_len, const unsigned char *m, const unsigned long long m_len, const unsigned char *pk);
+    int (*encrypt_open)(unsigned char *m, unsigned long long *m_len, const unsigned char *ct, const unsigned long long ct_len, const unsigned char *sk);
+    int (*encrypt_keypair_ctx)(r5_ctx *ctx, unsigned char *pk, unsigned char *sk);
+    int (*encrypt_ctx)(r5_ctx *ctx, unsigned char *ct, unsigned long long *ct_len, const unsigned char *m, const unsigned long long m_len, const unsigned char *pk);
+    int (*encrypt_open_ctx)(r5_ctx *ctx, unsigned char *m, unsigned long long *m_len, const unsigned char *ct, const unsigned long long ct_len, const unsigned char *sk);
+#endif
+} kernel_set;
+
+static int always_supported(void) {
+    return 1;
+}
+
+// AVX2 in the CPU, with the YMM state saved by the operating system
+static int avx2_supported(void) {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+// the kernel sets, slowest first
+static const kernel_set kernel_sets[] = {
+    KERNEL_SET(generic, always_supported),
+    KERNEL_SET(avx2, avx2_supported)
+};
+
+#define NUM_KERNEL_SETS (sizeof (kernel_sets) / sizeof (kernel_sets[0]))
+
+static const kernel_set *active_set = NULL;
+
+// the fastest supported set, or the one named by ROUND5_KERNELS when supported
+__attribute__ ((constructor)) static void choose_kernel_set(void) {
+    const char *name = getenv("ROUND5_KERNELS");
+    const kernel_set *set = &kernel_sets[0];
+    size_t i;
+
+    for (i = 0; i < NUM_KERNEL_SETS; i++) {
+        if (kernel_sets[i].supported()) {
+            set = &kernel_sets[i];
+        }
+    }
+    if (name != NULL) {
+        for (i = 0; i < NUM_KERNEL_SETS; i++) {
+            if (strcmp(name, kernel_sets[i].name) == 0 && kernel_sets[i].supported()) {
+                set = &kernel_sets[i];
+            }
+        }
+    }
+
+    active_set = set;
+}
+
+// the chosen set, also when called before the constructors have run
+static const kernel_set *kernels(void) {
+    if (active_set == NULL) {
+        choose_kernel_set();
+    }
+    return active_set;
+}
+
+// the set of a context, the chosen one without a context or a set of its own
+static const kernel_set *ctx_kernels(const r5_ctx *ctx) {
+    return ctx != NULL && ctx->kernels != NULL ? (const kernel_set *) ctx->kernels : kernels();
+}
+
+const char *r5_kernels(void) {
+    return kernels()->kernels();
+}
+
+int r5_ctx_set_kernels(r5_ctx *ctx, const char *name) {
+    size_t i;
+
+    for (i = 0; i < NUM_KERNEL_SETS; i++) {
+        if (strcmp(name, kernel_sets[i].name) == 0 && kernel_sets[i].supported()) {
+            ctx->kernels = &kernel_sets[i];
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+int crypto_kem_keypair(unsigned char *pk, unsigned char *sk) {
+    return kernels()->kem_keypair(pk, sk);
+}
+
+int crypto_kem_enc(unsigned char *ct, unsigned char *k, const unsigned char *pk) {
+    return kernels()->kem_enc(ct, k, pk);
+}
+
+int crypto_kem_enc_batch(unsigned char *ct[], unsigned char *k[], const unsigned char *pk[], size_t count) {
+    return kernels()->kem_enc_batch(ct, k, pk, count);
+}
+
+int crypto_kem_dec(unsigned char *k, const unsigned char *ct, const unsigned char *sk) {
+    return kernels()->kem_dec(k, ct, sk);
+}
+
+int crypto_kem_dec_batch(unsigned char *k[], const unsigned char *ct[], size_t count, const unsigned char *sk) {
+    return kernels()->kem_dec_batch(k, ct, count, sk);
+}
+
+int crypto_kem_keypair_ctx(r5_ctx *ctx, unsigned char *pk, unsigned char *sk) {
+    return ctx_kernels(ctx)->kem_keypair_ctx(ctx, pk, sk);
+}
+
+int crypto_kem_enc_ctx(r5_ctx *ctx, unsigned char *ct, unsigned char *k, const unsigned char *pk) {
+    return ctx_kernels(ctx)->kem_enc_ctx(ctx, ct, k, pk);
+}
+
+int crypto_kem_enc_batch_ctx(r5_ctx *ctx, unsigned char *ct[], unsigned char *k[], const unsigned char *pk[], size_t count) {
+    return ctx_kernels(ctx)->kem_enc_batch_ctx(ctx, ct, k, pk, count);
+}
+
+int crypto_kem_dec_ctx(r5_ctx *ctx, unsigned char *k, const unsigned char *ct, const unsigned char *sk) {
+    return ctx_kernels(ctx)->kem_dec_ctx(ctx, k, ct, sk);
+}
+
+int crypto_kem_dec_batch_ctx(r5_ctx *ctx, unsigned char *k[], const unsigned char *ct[], size_t count, const unsigned char *sk) {
+    return ctx_kernels(ctx)->kem_dec_batch_ctx(ctx, k, ct, count, sk);
+}
+
+#ifdef ROUND5_CCA_PKE
+
+int crypto_encrypt_keypair(unsigned char *pk, unsigned char *sk) {
+    return kernels()->encrypt_keypair(pk, sk);
+}
+
+int crypto_encrypt(unsigned char *ct, unsigned long long *ct_len, const unsigned char *m, const unsigned long long m_len, const unsigned char *pk) {
+    return kernels()->encrypt(ct, ct_len, m, m_len, pk);
+}
+
+int crypto_encrypt_open(unsigned char *m, unsigned long long *m_len, const unsigned char *ct, const unsigned long long ct_len, const unsigned char *sk) {
+    return kernels()->encrypt_open(m, m_len, ct, ct_len, sk);
+}
+
+int crypto_encrypt_keypair_ctx(r5_ctx *ctx, unsigned char *pk, unsigned char *sk) {
+    return ctx_kernels(ctx)->encrypt_keypair_ctx(ctx, pk, sk);
+}
+
+int crypto_encrypt_ctx(r5_ctx *ctx, unsigned char *ct, unsigned long long *ct_len, const unsigned char *m, const unsigned long long m_len, const unsigned char *pk) {
+    return ctx_kernels(ctx)->encrypt_ctx(ctx, ct, ct_len, m, m_len, pk);
+}
+
+int crypto_encrypt_open_ctx(r5_ctx *ctx, unsigned char *m, unsigned long long *m_len, const unsigned char *ct, const unsigned long long ct_len, const unsigned char *sk) {
+    return ctx_kernels(ctx)->encrypt_open_ctx(ctx, m, m_len, ct, ct_len, sk);
+}
+
+#endif
+
+#else
+
+// the name of the set and its kernels, after the adjustments of CM_CT and
+// CM_CACHE in r5_parameter_sets.h
+#ifdef AVX2
+#define SET_NAME "avx2"
+#define PACK_KERNEL "pack_avx2"
+#define SECRET_KERNEL "secretkeygen_avx2"
+#else
+#define SET_NAME "generic"
+#define PACK_KERNEL "pack"
+#define SECRET_KERNEL "secretkeygen"
+#endif
+
+#if PARAMS_K == 1
+#if defined(CM_CT) && defined(AVX2)
+#define MUL_KERNEL "ringmul_avx2"
+#elif defined(CM_CACHE) && defined(AVX2)
+#define MUL_KERNEL "ringmul_cm_avx2"
+#elif defined(CM_CT)
+#define MUL_KERNEL "ringmul_ct"
+#elif defined(CM_CACHE)
+#define MUL_KERNEL "ringmul_cm"
+#else
+#define MUL_KERNEL "ringmul_cacheless"
+#endif
+#else
+#if defined(AVX2)
+#define MUL_KERNEL "matmul_avx2"
+#elif defined(CM_CT) || defined(CM_CACHE)
+#define MUL_KERNEL "matmul_ct"
+#else
+#define MUL_KERNEL "matmul_cacheless"
+#endif
+#endif
+
+#if defined(STANDALONE) && defined(AVX2)
+#define KECCAK_KERNEL "keccak_4x"
+#elif defined(STANDALONE)
+#define KECCAK_KERNEL "keccak_1x"
+#else
+#define KECCAK_KERNEL "keccak_xkcp"
+#endif
+
+const char *r5_kernels(void) {
+    return SET_NAME ": " MUL_KERNEL " " PACK_KERNEL " " SECRET_KERNEL " " KECCAK_KERNEL;
+}
+
+#endif /* R5_DISPATCH */
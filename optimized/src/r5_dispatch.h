@@ -0,0 +1,39 @@
+/*
+ * Copyright (c) 2020, Koninklijke Philips N.V.
+ */
+
+/**
+ * @file
+ * Declaration of the function that reports the kernels a build runs, and
+ * of the run-time choice of the kernel set (`DISPATCH` builds).
+ */
+
+#ifndef R5_DISPATCH_H
+#define R5_DISPATCH_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /**
+     * Describes the kernels that are run, as the name of the kernel set
+     * followed by the kernels of the multiplication, the packing, the
+     * secret generation and Keccak, e.g.
+     * `avx2: ringmul_avx2 pack_avx2 secretkeygen_avx2 keccak_4x`.
+     *
+     * A `DISPATCH` build holds a `generic` and an `avx2` set, and runs the
+     * `avx2` one when the CPU (and operating system) supports AVX2. The
+     * `ROUND5_KERNELS` environment variable, read once at start-up, can
+     * select either set by name; `avx2` is only taken when supported.
+     * Other builds run the one set they are compiled with. The functions
+     * with a context run the set of the context (see r5_ctx_set_kernels()).
+     *
+     * @return the kernel set and its kernels
+     */
+    const char *r5_kernels(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* R5_DISPATCH_H */
@@ -0,0 +1,137 @@
+/*
+ * Copyright (c) 2020, Koninklijke Philips N.V.
+ */
+
+/**
+ * @file
+ * Implementation of the function that spreads independent tasks over threads.
+ */
+
+#include "r5_parallel.h"
+
+#if defined(THREADS) && THREADS > 1
+
+#include <pthread.h>
+
+// The pool: THREADS - 1 threads, started at the first call and kept for the
+// life of the process, that wait for a job. Thread t runs the tasks t,
+// t + THREADS, ... of a job, the calling thread those of share 0 and of the
+// threads that could not be started.
+static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t pool_busy = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t pool_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_start = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t pool_done = PTHREAD_COND_INITIALIZER;
+static size_t pool_first[THREADS];
+static int pool_started[THREADS];
+static size_t pool_threads;
+
+// the current job, under pool_lock
+static void (*job_task)(void *arg, size_t i);
+static void *job_arg;
+static size_t job_n;
+static unsigned long job_generation;
+static size_t job_remaining;
+
+// runs the tasks first, first + THREADS, ...
+static void run_share(void (*task)(void *arg, size_t i), void *arg, size_t n, size_t first) {
+    size_t i;
+
+    for (i = first; i < n; i += THREADS) {
+        task(arg, i);
+    }
+}
+
+static void *pool_thread(void *p) {
+    const size_t first = *(const size_t *) p;
+    unsigned long generation = 0;
+    void (*task)(void *arg, size_t i);
+    void *arg;
+    size_t n;
+
+    for (;;) {
+        pthread_mutex_lock(&pool_lock);
+        while (job_generation == generation) {
+            pthread_cond_wait(&pool_start, &pool_lock);
+        }
+        generation = job_generation;
+        task = job_task;
+        arg = job_arg;
+        n = job_n;
+        pthread_mutex_unlock(&pool_lock);
+
+        run_share(task, arg, n, first);
+
+        pthread_mutex_lock(&pool_lock);
+        if (--job_remaining == 0) {
+            pthread_cond_signal(&pool_done);
+        }
+        pthread_mutex_unlock(&pool_lock);
+    }
+
+    return NULL;
+}
+
+static void pool_init(void) {
+    pthread_t thread;
+    size_t t;
+
+    for (t = 1; t < THREADS; t++) {
+        pool_first[t] = t;
+        pool_started[t] = pthread_create(&thread, NULL, pool_thread, &pool_first[t]) == 0;
+        if (pool_started[t]) {
+            pthread_detach(thread);
+            pool_threads++;
+        }
+    }
+}
+
+void r5_parallel_for(size_t n, void (*task)(void *arg, size_t i), void *arg) {
+    size_t t;
+
+    // one job at a time: with the pool busy (another thread, or a task that
+    // calls this function) the tasks run on the calling thread
+    if (n <= 1 || pthread_mutex_trylock(&pool_busy) != 0) {
+        for (t = 0; t < n; t++) {
+            task(arg, t);
+        }
+        return;
+    }
+    pthread_once(&pool_once, pool_init);
+
+    pthread_mutex_lock(&pool_lock);
+    job_task = task;
+    job_arg = arg;
+    job_n = n;
+    job_remaining = pool_threads;
+    job_generation++;
+    pthread_cond_broadcast(&pool_start);
+    pthread_mutex_unlock(&pool_lock);
+
+    run_share(task, arg, n, 0);
+    for (t = 1; t < THREADS; t++) {
+        if (!pool_started[t]) {
+            run_share(task, arg, n, t);
+        }
+    }
+
+    pthread_mutex_lock(&pool_lock);
+    while (job_remaining != 0) {
+        pthread_cond_wait(&pool_done, &pool_lock);
+    }
+    pthread_mutex_unlock(&pool_lock);
+
+    pthread_mutex_unlock(&pool_busy);
+}
+
+#else
+
+void r5_parallel_for(size_t n, void (*task)(void *arg, size_t i), void *arg) {
+    size_t i;
+
+    for (i = 0; i < n; i++) {
+        task(arg, i);
+    }
+}
+
+#endif
@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2020, Koninklijke Philips N.V.
+ */
+
+/**
+ * @file
+ * Declaration of the function that spreads independent tasks over threads.
+ */
+
+#ifndef R5_PARALLEL_H
+#define R5_PARALLEL_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+    /**
+     * Runs `task(arg, i)` for `i` = 0 .. `n` - 1. The tasks must be
+     * independent of each other. With `THREADS` > 1 they are spread over
+     * `THREADS` threads: the calling one and the `THREADS` - 1 threads of a
+     * pool, started at the first call and kept for the life of the process.
+     * The pool runs one call at a time; a call made while it is busy, and
+     * any call without `THREADS` > 1, runs the tasks one after the other on
+     * the calling thread. The function returns when all tasks are done.
+     *
+     * @param[in] n     the number of tasks
+     * @param[in] task  the task function
+     * @param[in] arg   the argument passed to every task
+     */
+    void r5_parallel_for(size_t n, void (*task)(void *arg, size_t i), void *arg);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* R5_PARALLEL_H */
@@ -5,6 +5,7 @@
 
 #include "r5_secretkeygen.h"
 #include "drbg.h"
+#include <string.h>
 #ifdef AVX2
 #include <immintrin.h>
 #endif
@@ -17,6 +18,10 @@
 
 #define CTSECRETVECTOR64_4 4*((CTSECRETVECTOR64+3)/4)
 
+#if (defined(AVX2) & defined(STANDALONE))
+#define AVX2SHAKE_KEYGEN
+#endif
+
 #ifndef SHIFT_LEFT64_CONSTANT_TIME
 
 /**
@@ -99,58 +104,106 @@ int check_and_set(uint64_t secret_vector_64[2][CTSECRETVECTOR64_4], uint16_t x,
 
 #else
 
-static const uint64_t VECM[4] =
-{ 1L, 2L, 4L, 8L };
+#define CT_VECS ((CTSECRETVECTOR64 + 3) / 4)
 
+/*
+ * check_and_set() for n candidates, with the bitmaps in registers for all of
+ * them instead of loaded and stored for each one. The candidates are divided
+ * by PARAMS_RS_DIV here. Sets the same bits, in the same order.
+ *
+ * Whether a candidate is new does not depend on h: the occupancy bitmap is
+ * updated for every candidate, and only setting the +1 and -1 bits waits for
+ * h. This takes h off the critical path from one candidate to the next: once
+ * h reaches 0 no bit is set anymore, so the extra occupied bits are unused.
+ */
+inline int check_and_set_n(uint64_t secret_vector_64[2][CTSECRETVECTOR64_4], const uint16_t *x, size_t n, int h) ALWAYS_INLINE;
+int check_and_set_n(uint64_t secret_vector_64[2][CTSECRETVECTOR64_4], const uint16_t *x, size_t n, int h) {
 
-inline check_and_set( uint64_t secret_vector_64[2][CTSECRETVECTOR64_4], uint16_t x, int h)  ALWAYS_INLINE;
-int check_and_set( uint64_t secret_vector_64[2][CTSECRETVECTOR64_4], uint16_t x, int h) {
-    
-    size_t j;
-    register __m256i vec0 = _mm256_setzero_si256();
-    register __m256i vec1 = _mm256_set1_epi64x(1L);
-    register __m256i veca = _mm256_slli_epi64(vec1, x & 0x3F); // low address part
-    register __m256i vecb = _mm256_slli_epi64(vec1, x >> 6 ); // high address part
-    register __m256i vecm = _mm256_loadu_si256((const __m256i*) VECM);
-    register __m256i vecn = _mm256_set1_epi32(-1);
-    register __m256i vect, vecaux;
-    register __m256i vectt = vec0;
-    
-    veca = _mm256_and_si256(veca, _mm256_cmpgt_epi64(vec0, _mm256_set1_epi64x((int64_t)(h))));  //    set a to zero if h >= 0
-    
-    for (j = 0; j < (( CTSECRETVECTOR64+3)/4)*4; j+=4) {
-        
-        vect = _mm256_andnot_si256(_mm256_cmpeq_epi64(vecb & vecm, vec0), veca); //    bit selector
-        // secret_vector[0] encodes the +1, secret_vector[1] encodes the -1
-        vect &= vecn ^ (_mm256_loadu_si256((__m256i*) &secret_vector_64[0][j]) | _mm256_loadu_si256((__m256i*) &secret_vector_64[1][j])); // empty?
-        
-        vecaux = _mm256_set1_epi64x(-((int64_t) (h & 1)));
-        
-        _mm256_storeu_si256((__m256i*) &secret_vector_64[1][j], _mm256_loadu_si256((__m256i*) &secret_vector_64[1][j]) | (vecaux & vect)); // set if -1
-        _mm256_storeu_si256((__m256i*) &secret_vector_64[0][j], _mm256_loadu_si256((__m256i*) &secret_vector_64[0][j]) | ((vecaux ^ vecn) & vect)); // set if 1
-        
-        vectt |= vect;  // store change
-        
-        vecb = _mm256_srli_epi64( vecb, 4 ); // Next 4 bits.
+    size_t i, j;
+    uint16_t y;
+    const __m256i vec0 = _mm256_setzero_si256();
+    const __m256i vec1 = _mm256_set1_epi64x(1L);
+    const __m256i vec256 = _mm256_set1_epi64x(256L);
+    const __m256i lanes = _mm256_setr_epi64x(0L, 64L, 128L, 192L);
+    __m256i occupied[CT_VECS], plus[CT_VECS], minus[CT_VECS];
+    __m256i veca, vecb, vecp, vecm, vect, vectt;
+    int64_t set;
+
+    // secret_vector[0] encodes the +1, secret_vector[1] encodes the -1
+    for (j = 0; j < CT_VECS; j++) {
+        plus[j] = _mm256_loadu_si256((__m256i*) &secret_vector_64[0][4 * j]);
+        minus[j] = _mm256_loadu_si256((__m256i*) &secret_vector_64[1][4 * j]);
+        occupied[j] = _mm256_or_si256(plus[j], minus[j]);
+    }
+
+    for (i = 0; i < n; i++) {
+        y = x[i] / PARAMS_RS_DIV;                    //    no uniform rejection here
+        vecb = _mm256_sub_epi64(_mm256_set1_epi64x(y), lanes); // bit in the word of each lane
+        set = ((int64_t) h) >> 63;               // set if h < 0
+        vecm = _mm256_set1_epi64x(set & -((int64_t) (h & 1))); // set if -1
+        vecp = _mm256_set1_epi64x(set & ~(-((int64_t) (h & 1)))); // set if 1
+        vectt = vec0;
+        for (j = 0; j < CT_VECS; j++) {
+            veca = _mm256_sllv_epi64(vec1, vecb); // bit selector, zero out of the word
+            vect = _mm256_andnot_si256(occupied[j], veca); // empty?
+            occupied[j] = _mm256_or_si256(occupied[j], veca);
+            plus[j] = _mm256_or_si256(plus[j], _mm256_and_si256(vecp, vect));
+            minus[j] = _mm256_or_si256(minus[j], _mm256_and_si256(vecm, vect));
+            vectt = _mm256_or_si256(vectt, vect); // store change
+            vecb = _mm256_sub_epi64(vecb, vec256); // next 4 words
+        }
+        h += 1 - _mm256_testz_si256(vectt, vectt); // tt == 0 ? 0 : 1
     }
-    return (int)(~_mm256_testz_si256(vectt, vectt)) & 0x1; // tt == 0 ? 0 : 1
+
+    for (j = 0; j < CT_VECS; j++) {
+        _mm256_storeu_si256((__m256i*) &secret_vector_64[0][4 * j], plus[j]);
+        _mm256_storeu_si256((__m256i*) &secret_vector_64[1][4 * j], minus[j]);
+    }
+
+    return h;
 }
 
+#endif
+
+// the dense secret vector of the bitmaps
+static void expand_secret_vector(tern_coef_type *secret_vector, uint64_t secret_vector_64[2][CTSECRETVECTOR64_4]) {
+    size_t i = 0;
 
+#ifdef AVX2
+    // 16 coefficients at a time, each lane testing its own bit of the words
+    const __m256i bits = _mm256_setr_epi16(1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192, 16384, (int16_t) 0x8000);
+    __m256i plus, minus;
+
+    for (; i + 16 <= PARAMS_D; i += 16) {
+        plus = _mm256_and_si256(_mm256_set1_epi16((int16_t) (secret_vector_64[0][i >> 6] >> (i & 0x3F))), bits);
+        minus = _mm256_and_si256(_mm256_set1_epi16((int16_t) (secret_vector_64[1][i >> 6] >> (i & 0x3F))), bits);
+        _mm256_storeu_si256((__m256i *) &secret_vector[i], _mm256_sub_epi16(_mm256_cmpeq_epi16(minus, bits), _mm256_cmpeq_epi16(plus, bits)));
+    }
 #endif
+    for (; i < PARAMS_D; i++) {
+        secret_vector[i] = (int16_t) (((secret_vector_64[0][i >> 6] >> (i & 0x3F)) & 1)
+                                   -  ((secret_vector_64[1][i >> 6] >> (i & 0x3F)) & 1));
+    }
+}
 
 
-void create_secret_vector_internal(tern_secret secret_vector, const uint8_t *seed, uint8_t l, const uint8_t *domain){
+void create_secret_vector_internal(tern_secret secret_vector, const tupleHash_Snapshot *prefix, uint8_t l){
     
     int h;
-    size_t i;
 
     uint64_t secret_vector_64[2][CTSECRETVECTOR64_4] = {{0}};
     
+#if defined(AVX2) && defined(CM_CT)
+    uint16_t x[PARAMS_HMAX];
+#elif defined(AVX2)
+    uint16_t x[PARAMS_XSIZE];
+#else
+    size_t i;
     uint16_t x[PARAMS_XSIZE];
     uint16_t x_count = PARAMS_XSIZE - 1;
+#endif
     
-    SKGenerationInit(domain, seed, &l);
+    SKGenerationInitPrefixed(prefix, &l);
     
     //    mark >=d slots as occupied (uniform sampling)
 #if (PARAMS_D & 0x3F) != 0
@@ -159,6 +212,15 @@ void create_secret_vector_internal(tern_secret secret_vector, const uint8_t *see
     
     h = -PARAMS_H;                            //    dummy rounds once h reaches 0
     
+#if defined(AVX2) && defined(CM_CT)
+    SKGenerationGen(x, PARAMS_HMAX);
+    h = check_and_set_n(secret_vector_64, x, PARAMS_HMAX, h);
+#elif defined(AVX2)
+    while (h < 0) {
+        SKGenerationGen(x, PARAMS_XSIZE);
+        h = check_and_set_n(secret_vector_64, x, PARAMS_XSIZE, h);
+    }
+#else
     for (i = 0; forCONDITION; i++) {
     
         x_count++;
@@ -170,71 +232,81 @@ void create_secret_vector_internal(tern_secret secret_vector, const uint8_t *see
         
         h += check_and_set(secret_vector_64, x[i & PARAMS_XMASK], h);
     }
+#endif
     
-    for (i = 0; i < PARAMS_D; i++) {
-        secret_vector[i] = (int16_t) (((secret_vector_64[0][i >> 6] >> (i & 0x3F)) & 1)
-                                   -  ((secret_vector_64[1][i >> 6] >> (i & 0x3F)) & 1));
-    }
+    expand_secret_vector(secret_vector, secret_vector_64);
     
     DEBUG_PRINT(
         print_sage_u_vector("Secret key vector (full representation)", (uint16_t *) secret_vector, PARAMS_D);
     )
 }
 
-#if (defined(AVX2) & defined(STANDALONE))
+#ifdef AVX2SHAKE_KEYGEN
 
-void create_secret_vector_internal_4x(tern_secret secret_vector[4], const uint8_t *seed, uint8_t l, const uint8_t *domain){
-    
-    int h0, h1, h2, h3;
-    size_t i, j;
-    
-    uint64_t secret_vector_64[4][2][CTSECRETVECTOR64_4] = {{{0}}};
-    
-    uint16_t x0[PARAMS_HMAX], x1[PARAMS_HMAX], x2[PARAMS_HMAX], x3[PARAMS_HMAX];
-    
-    uint8_t l0 = l, l1 = l+1, l2 = l+2, l3 = l+3;
-    SKGenerationInit_4x(domain, seed, &l0, &l1, &l2, &l3);
-    
-    //    mark >=d slots as occupied (uniform sampling)
+#define SK_VECTOR_JOBS
+
+// the number of vectors whose candidates are squeezed at once
+#define SK_JOBS 8
+
+// the candidates squeezed for each vector: all that are used in constant
+// time, or with CM_CACHE a little more than are needed on average (about
+// 0.6 PARAMS_HMAX in all parameter sets)
+#if defined(CM_CACHE)
+#define SK_CANDIDATES ((PARAMS_HMAX * 5) / 8)
+#else
+#define SK_CANDIDATES PARAMS_HMAX
+#endif
+
+// the secret vectors of the seeds and indices l, with the candidates of
+// their streams squeezed together, four at a time; the vectors of a prefix
+// (of the domain and the seed, or NULL) follow each other. With CM_CACHE a
+// vector that needs more than the candidates of its job draws the rest
+// from where its stream was left, so it is the one
+// create_secret_vector_internal() gives.
+static void create_secret_vectors(tern_coef_type *secret_vector[], const uint8_t *seed[], const tupleHash_Snapshot *prefix[], const uint8_t l[], size_t n, const uint8_t *domain) {
+    uint64_t secret_vector_64[2][CTSECRETVECTOR64_4];
+    uint16_t x[SK_JOBS][SK_CANDIDATES];
+    tupleHash16_Job jobs[SK_JOBS];
+#if defined(CM_CACHE)
+    ttupleHash_Instance rest[SK_JOBS];
+#endif
+    size_t i, j, m;
+    int h;
+
+    for (i = 0; i < n; i += m) {
+        for (m = 1; m < SK_JOBS && i + m < n && prefix[i + m] == prefix[i]; m++) {
+        }
+        for (j = 0; j < m; j++) {
+#if defined(CM_CACHE)
+            jobs[j] = SKGenerationJob(x[j], SK_CANDIDATES, domain, seed[i + j], &l[i + j], &rest[j], prefix[i + j]);
+#else
+            jobs[j] = SKGenerationJob(x[j], SK_CANDIDATES, domain, seed[i + j], &l[i + j], NULL, prefix[i + j]);
+#endif
+        }
+        SKGenerationJobs(jobs, m);
+
+        for (j = 0; j < m; j++) {
+            memset(secret_vector_64, 0, sizeof (secret_vector_64));
+            //    mark >=d slots as occupied (uniform sampling)
 #if (PARAMS_D & 0x3F) != 0
-    secret_vector_64[0][0][CTSECRETVECTOR64 - 1] = (~0llu) << (PARAMS_D & 0x3F);
-    secret_vector_64[1][0][CTSECRETVECTOR64 - 1] = (~0llu) << (PARAMS_D & 0x3F);
-    secret_vector_64[2][0][CTSECRETVECTOR64 - 1] = (~0llu) << (PARAMS_D & 0x3F);
-    secret_vector_64[3][0][CTSECRETVECTOR64 - 1] = (~0llu) << (PARAMS_D & 0x3F);
+            secret_vector_64[0][CTSECRETVECTOR64 - 1] = (~0llu) << (PARAMS_D & 0x3F);
 #endif
-    
-    //    dummy rounds once h reaches 0
-    h0 = -PARAMS_H;
-    h1 = -PARAMS_H;
-    h2 = -PARAMS_H;
-    h3 = -PARAMS_H;
-    
-    // call drbg once
-    SKGenerationGen_4x(x0, x1, x2, x3, PARAMS_HMAX);
-    
-    for (i = 0; i < PARAMS_HMAX; i++) {
-        
-        x0[i] /= PARAMS_RS_DIV;                    //    no uniform rejection here
-        x1[i] /= PARAMS_RS_DIV;                    //    no uniform rejection here
-        x2[i] /= PARAMS_RS_DIV;                    //    no uniform rejection here
-        x3[i] /= PARAMS_RS_DIV;                    //    no uniform rejection here
-        
-        h0 += check_and_set(secret_vector_64[0], x0[i], h0);
-        h1 += check_and_set(secret_vector_64[1], x1[i], h1);
-        h2 += check_and_set(secret_vector_64[2], x2[i], h2);
-        h3 += check_and_set(secret_vector_64[3], x3[i], h3);
-    }
-    
-    for (j = 0 ; j < 4 ; j ++) {
-        for (i = 0; i < PARAMS_D; i++) {
-            secret_vector[j][i] = (int16_t) (((secret_vector_64[j][0][i >> 6] >> (i & 0x3F)) & 1)
-                                          -  ((secret_vector_64[j][1][i >> 6] >> (i & 0x3F)) & 1));
-            
+            //    dummy rounds once h reaches 0
+            h = check_and_set_n(secret_vector_64, x[j], SK_CANDIDATES, -PARAMS_H);
+#if defined(CM_CACHE)
+            while (h < 0) {
+                r5_tuple_hash_xof_squeeze16(x[j], PARAMS_XSIZE, &rest[j] Params);
+                h = check_and_set_n(secret_vector_64, x[j], PARAMS_XSIZE, h);
+            }
+#else
+            (void) h;
+#endif
+            expand_secret_vector(secret_vector[i + j], secret_vector_64);
         }
     }
-    
+
     DEBUG_PRINT(
-                print_sage_u_vector("Secret key vector (full representation)", (uint16_t *) secret_vector, PARAMS_D);
+                print_sage_u_vector("Secret key vector (full representation)", (uint16_t *) secret_vector[0], PARAMS_D);
                 )
 }
 
@@ -295,9 +367,68 @@ int probe_cm(uint64_t *v,  const uint16_t x)
 
 #endif // AVX2
 
-void create_secret_vector_internal(tern_secret secret_vector, const uint8_t *seed, uint8_t l, const uint8_t *domain) {
+// the candidates are squeezed a Keccak rate block (of TupleHash256 or 128) at a time
+#if PARAMS_KAPPA_BYTES > 16
+#define SK_BLOCK_LEN 68
+#else
+#define SK_BLOCK_LEN 84
+#endif
+
+#ifdef AVX2
+
+// byte shuffles that move the kept ones of 4 16-bit candidates to the front
+static const uint64_t KEEP_SHUFFLE[16] = {
+    0x8080808080808080U, 0x8080808080800100U, 0x8080808080800302U, 0x8080808003020100U,
+    0x8080808080800504U, 0x8080808005040100U, 0x8080808005040302U, 0x8080050403020100U,
+    0x8080808080800706U, 0x8080808007060100U, 0x8080808007060302U, 0x8080070603020100U,
+    0x8080808007060504U, 0x8080070605040100U, 0x8080070605040302U, 0x0706050403020100U
+};
+
+static const uint8_t KEEP_COUNT[16] = {0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4};
+
+#endif
+
+/**
+ * Keeps the candidates below PARAMS_RS_LIM, in order. Can be done in place.
+ *
+ * @param[out] out the candidates that are kept
+ * @param[in] in   the candidates
+ * @param[in] len  the number of candidates
+ * @return the number of candidates kept
+ */
+static size_t keep_candidates(uint16_t *out, const uint16_t *in, size_t len) {
+    size_t i = 0, n = 0;
+
+#ifdef AVX2
+    const __m128i lim = _mm_set1_epi16((int16_t) (PARAMS_RS_LIM - 1));
+    __m128i v, keep;
+    int m;
+
+    // 8 at a time: compare, then compress each half with a byte shuffle
+    for (; i + 8 <= len; i += 8) {
+        v = _mm_loadu_si128((const __m128i *) &in[i]);
+        keep = _mm_cmpeq_epi16(_mm_min_epu16(v, lim), v);
+        m = _mm_movemask_epi8(_mm_packs_epi16(keep, keep)) & 0xFF;
+        _mm_storel_epi64((__m128i *) &out[n], _mm_shuffle_epi8(v, _mm_cvtsi64_si128((long long) KEEP_SHUFFLE[m & 15])));
+        n += KEEP_COUNT[m & 15];
+        _mm_storel_epi64((__m128i *) &out[n], _mm_shuffle_epi8(_mm_srli_si128(v, 8), _mm_cvtsi64_si128((long long) KEEP_SHUFFLE[m >> 4])));
+        n += KEEP_COUNT[m >> 4];
+    }
+#endif
+    for (; i < len; i++) {
+        if (in[i] < PARAMS_RS_LIM) {
+            out[n++] = in[i];
+        }
+    }
+
+    return n;
+}
+
+void create_secret_vector_internal(tern_secret secret_vector, const tupleHash_Snapshot *prefix, uint8_t l) {
     size_t i;
     uint16_t x;
+    uint16_t xs[SK_BLOCK_LEN];
+    size_t x_count = 0, x_len = 0;
     
 #if defined(CM_CACHE)
     uint64_t v[CTSECRETVECTOR64_4] = {0};
@@ -306,14 +437,17 @@ void create_secret_vector_internal(tern_secret secret_vector, const uint8_t *see
 #endif
     
 
-    SKGenerationInit(domain, seed, &l);
+    SKGenerationInitPrefixed(prefix, &l);
     
     for (i = 0; i < PARAMS_H; i++) {
         do {
-            do {
-                SKGenerationGen(&x, 1);
-            } while (x >= PARAMS_RS_LIM);
-            x /= PARAMS_RS_DIV;
+            // the same candidates as when they are squeezed one by one
+            while (x_count == x_len) {
+                SKGenerationGen(xs, SK_BLOCK_LEN);
+                x_len = keep_candidates(xs, xs, SK_BLOCK_LEN);
+                x_count = 0;
+            }
+            x = xs[x_count++] / PARAMS_RS_DIV;
             
 #if defined(CM_CACHE)
         } while (probe_cm(v, x));
@@ -329,35 +463,103 @@ void create_secret_vector_internal(tern_secret secret_vector, const uint8_t *see
     )
 }
 
+#ifdef AVX2SHAKE_KEYGEN
+
+// four secret vectors at once, each with its own seed and index l. The four
+// streams are squeezed PARAMS_XSIZE values at a time; a block is only
+// squeezed when every vector that is not complete has used up the last one,
+// so each vector is built from exactly the values create_secret_vector_internal()
+// would draw for it.
+void create_secret_vector_internal_4x(tern_secret secret_vector0, tern_secret secret_vector1, tern_secret secret_vector2, tern_secret secret_vector3,
+                                      const uint8_t *seed0, const uint8_t *seed1, const uint8_t *seed2, const uint8_t *seed3,
+                                      uint8_t l0, uint8_t l1, uint8_t l2, uint8_t l3, const uint8_t *domain) {
+    size_t i, j, k[4] = {0};
+    uint16_t x, xs[4][PARAMS_XSIZE];
+    tern_coef_type *secret_vector[4] = {&secret_vector0[0][0], &secret_vector1[0][0], &secret_vector2[0][0], &secret_vector3[0][0]};
+
+#if defined(CM_CACHE)
+    uint64_t v[4][CTSECRETVECTOR64_4] = {{0}};
+#else
+    uint8_t v[4][PARAMS_D] = {{0}};
+#endif
+
+    SKGenerationInit_4x(domain, seed0, seed1, seed2, seed3, &l0, &l1, &l2, &l3);
+
+    while (k[0] < PARAMS_H || k[1] < PARAMS_H || k[2] < PARAMS_H || k[3] < PARAMS_H) {
+        SKGenerationGen_4x(xs[0], xs[1], xs[2], xs[3], PARAMS_XSIZE);
+
+        for (j = 0; j < 4; j++) {
+            for (i = 0; i < PARAMS_XSIZE && k[j] < PARAMS_H; i++) {
+                x = xs[j][i];
+                if (x >= PARAMS_RS_LIM) {
+                    continue;
+                }
+                x /= PARAMS_RS_DIV;
+#if defined(CM_CACHE)
+                if (probe_cm(v[j], x)) {
+                    continue;
+                }
+#else
+                if (v[j][x]) {
+                    continue;
+                }
+                v[j][x] = 1;
+#endif
+                secret_vector[j][k[j]++] = x; // addition / subtract index
+            }
+        }
+    }
+
+    DEBUG_PRINT(
+         print_sage_u_vector_matrix("Secret key vector (index representation)", secret_vector0, PARAMS_H/2, 2, 1);
+    )
+}
+
+#endif
+
 #endif
 
 
 void create_secret_vector_s(tern_secret secret_vector, const uint8_t *seed){
     const uint8_t d[4] = "SGEN";
-    create_secret_vector_internal(secret_vector, seed, 0, d);
+    tupleHash_Snapshot prefix;
+
+    SKGenerationPrefix(&prefix, d, seed);
+    create_secret_vector_internal(secret_vector, &prefix, 0);
 }
 
 void create_secret_vector_r(tern_secret secret_vector, const uint8_t *seed){
     const uint8_t d[4] = "RGEN";
-    create_secret_vector_internal(secret_vector, seed, 0, d);
-}
+    tupleHash_Snapshot prefix;
 
-#if (defined(AVX2) & defined(STANDALONE))
-#define AVX2SHAKE_KEYGEN
-#endif
+    SKGenerationPrefix(&prefix, d, seed);
+    create_secret_vector_internal(secret_vector, &prefix, 0);
+}
 
+// the rows of a matrix share their domain and seed, which are absorbed once
 void create_secret_matrix_s_t(tern_secret_s secret_vector, const uint8_t *seed) {
     
     uint8_t l;
     const uint8_t domain[4] = "SGEN";
-    
-#if ((PARAMS_N_BAR > 1) && defined(AVX2SHAKE_KEYGEN) && defined(CM_CT) )
-    for (l = 0; l < PARAMS_N_BAR; l+=4) {
-        create_secret_vector_internal_4x((tern_coef_type *)(&secret_vector[l]), seed, l, domain);
+    tupleHash_Snapshot prefix;
+
+    SKGenerationPrefix(&prefix, domain, seed);
+#if ((PARAMS_N_BAR > 1) && defined(SK_VECTOR_JOBS))
+    tern_coef_type *rows[PARAMS_N_BAR];
+    const uint8_t *seeds[PARAMS_N_BAR];
+    const tupleHash_Snapshot *prefixes[PARAMS_N_BAR];
+    uint8_t ls[PARAMS_N_BAR];
+
+    for (l = 0; l < PARAMS_N_BAR; l++) {
+        rows[l] = secret_vector[l];
+        seeds[l] = seed;
+        prefixes[l] = &prefix;
+        ls[l] = l;
     }
+    create_secret_vectors(rows, seeds, prefixes, ls, PARAMS_N_BAR, domain);
 #else
     for (l = 0; l < PARAMS_N_BAR; l++) {
-        create_secret_vector_internal((tern_coef_type *)(&secret_vector[l]), seed, l, domain);
+        create_secret_vector_internal((tern_coef_type *)(&secret_vector[l]), &prefix, l);
     }
 #endif
     
@@ -367,15 +569,88 @@ void create_secret_matrix_r_t(tern_secret_r secret_vector, const uint8_t *seed)
     
     uint8_t l;
     const uint8_t domain[4] = "RGEN";
-    
-#if ((PARAMS_M_BAR > 1) && defined(AVX2SHAKE_KEYGEN) && defined(CM_CT) )
-    for (l = 0; l < PARAMS_M_BAR; l+=4) {
-        create_secret_vector_internal_4x((tern_coef_type *)(&secret_vector[l]), seed, l, domain);
+    tupleHash_Snapshot prefix;
+
+    SKGenerationPrefix(&prefix, domain, seed);
+#if ((PARAMS_M_BAR > 1) && defined(SK_VECTOR_JOBS))
+    tern_coef_type *rows[PARAMS_M_BAR];
+    const uint8_t *seeds[PARAMS_M_BAR];
+    const tupleHash_Snapshot *prefixes[PARAMS_M_BAR];
+    uint8_t ls[PARAMS_M_BAR];
+
+    for (l = 0; l < PARAMS_M_BAR; l++) {
+        rows[l] = secret_vector[l];
+        seeds[l] = seed;
+        prefixes[l] = &prefix;
+        ls[l] = l;
     }
+    create_secret_vectors(rows, seeds, prefixes, ls, PARAMS_M_BAR, domain);
 #else
     for (l = 0; l < PARAMS_M_BAR; l++) {
-        create_secret_vector_internal((tern_coef_type *)(&secret_vector[l]), seed, l, domain);
+        create_secret_vector_internal((tern_coef_type *)(&secret_vector[l]), &prefix, l);
     }
 #endif
     
 }
+
+void create_secret_vector_r_4x(tern_secret secret_vector0, tern_secret secret_vector1, tern_secret secret_vector2, tern_secret secret_vector3,
+                               const uint8_t *seed0, const uint8_t *seed1, const uint8_t *seed2, const uint8_t *seed3) {
+#if defined(SK_VECTOR_JOBS)
+    // one vector per seed: nothing to share
+    const uint8_t d[4] = "RGEN";
+    tern_coef_type *rows[4] = {secret_vector0, secret_vector1, secret_vector2, secret_vector3};
+    const uint8_t *seeds[4] = {seed0, seed1, seed2, seed3};
+    const tupleHash_Snapshot *prefixes[4] = {NULL, NULL, NULL, NULL};
+    const uint8_t ls[4] = {0, 0, 0, 0};
+    create_secret_vectors(rows, seeds, prefixes, ls, 4, d);
+#elif defined(AVX2SHAKE_KEYGEN)
+    const uint8_t d[4] = "RGEN";
+    create_secret_vector_internal_4x(secret_vector0, secret_vector1, secret_vector2, secret_vector3,
+                                     seed0, seed1, seed2, seed3, 0, 0, 0, 0, d);
+#else
+    create_secret_vector_r(secret_vector0, seed0);
+    create_secret_vector_r(secret_vector1, seed1);
+    create_secret_vector_r(secret_vector2, seed2);
+    create_secret_vector_r(secret_vector3, seed3);
+#endif
+}
+
+void create_secret_matrix_r_t_4x(tern_secret_r secret_vector0, tern_secret_r secret_vector1, tern_secret_r secret_vector2, tern_secret_r secret_vector3,
+                                 const uint8_t *seed0, const uint8_t *seed1, const uint8_t *seed2, const uint8_t *seed3) {
+#if defined(SK_VECTOR_JOBS)
+    // the rows of each seed together, to share its prefix
+    uint8_t l, k;
+    const uint8_t domain[4] = "RGEN";
+    tern_coef_type (*matrix[4])[PARAMS_D] = {secret_vector0, secret_vector1, secret_vector2, secret_vector3};
+    const uint8_t *seed[4] = {seed0, seed1, seed2, seed3};
+    tupleHash_Snapshot prefix[4];
+    tern_coef_type *rows[4 * PARAMS_M_BAR];
+    const uint8_t *seeds[4 * PARAMS_M_BAR];
+    const tupleHash_Snapshot *prefixes[4 * PARAMS_M_BAR];
+    uint8_t ls[4 * PARAMS_M_BAR];
+
+    for (k = 0; k < 4; k++) {
+        SKGenerationPrefix(&prefix[k], domain, seed[k]);
+        for (l = 0; l < PARAMS_M_BAR; l++) {
+            rows[k * PARAMS_M_BAR + l] = matrix[k][l];
+            seeds[k * PARAMS_M_BAR + l] = seed[k];
+            prefixes[k * PARAMS_M_BAR + l] = &prefix[k];
+            ls[k * PARAMS_M_BAR + l] = l;
+        }
+    }
+    create_secret_vectors(rows, seeds, prefixes, ls, 4 * PARAMS_M_BAR, domain);
+#elif defined(AVX2SHAKE_KEYGEN)
+    uint8_t l;
+    const uint8_t domain[4] = "RGEN";
+
+    for (l = 0; l < PARAMS_M_BAR; l++) {
+        create_secret_vector_internal_4x(secret_vector0[l], secret_vector1[l], secret_vector2[l], secret_vector3[l],
+                                         seed0, seed1, seed2, seed3, l, l, l, l, domain);
+    }
+#else
+    create_secret_matrix_r_t(secret_vector0, seed0);
+    create_secret_matrix_r_t(secret_vector1, seed1);
+    create_secret_matrix_r_t(secret_vector2, seed2);
+    create_secret_matrix_r_t(secret_vector3, seed3);
+#endif
+}
@@ -13,5 +13,11 @@ void create_secret_vector_r(tern_secret secret_vector, const uint8_t *seed);
 void create_secret_matrix_s_t(tern_secret_s secret_vector, const uint8_t *seed);
 void create_secret_matrix_r_t(tern_secret_r secret_vector, const uint8_t *seed);
 
+// as create_secret_vector_r() and create_secret_matrix_r_t(), for four seeds
+void create_secret_vector_r_4x(tern_secret secret_vector0, tern_secret secret_vector1, tern_secret secret_vector2, tern_secret secret_vector3,
+                               const uint8_t *seed0, const uint8_t *seed1, const uint8_t *seed2, const uint8_t *seed3);
+void create_secret_matrix_r_t_4x(tern_secret_r secret_vector0, tern_secret_r secret_vector1, tern_secret_r secret_vector2, tern_secret_r secret_vector3,
+                                 const uint8_t *seed0, const uint8_t *seed1, const uint8_t *seed2, const uint8_t *seed3);
+
 #endif /* secretkeygen_h */
 
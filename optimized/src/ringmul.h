@@ -10,11 +10,31 @@
 
 #if PARAMS_K == 1
 
+// length of the "lifted" form of a that ringmul_q_lifted works on; every
+// backend keeps its own layout (duplicated, reversed, padded for AVX2)
+#if defined(CM_CACHE) && !defined(AVX2)
+#define RINGMUL_LIFT_LEN (PARAMS_N + 1)
+#elif defined(AVX2)
+#define RINGMUL_LIFT_LEN (2 * (PARAMS_N + 1) + 16)
+#else
+#define RINGMUL_LIFT_LEN (2 * (PARAMS_N + 1))
+#endif
+
+// "lift" a -- multiply by (x - 1) -- into the layout of the backend
+void ringmul_q_lift(modq_t p[RINGMUL_LIFT_LEN], modq_t a[PARAMS_N]);
+
+// multiplication mod q of an already lifted a, result length n
+void ringmul_q_lifted(modq_t d[PARAMS_N], const modq_t p[RINGMUL_LIFT_LEN], tern_secret idx);
+
 // multiplication mod q, result length n
 void ringmul_q(modq_t d[PARAMS_N], modq_t a[PARAMS_N], tern_secret idx);
 
 // multiplication mod p, result length mu
-void ringmul_p(modp_t d[PARAMS_MU], modp_t a[PARAMS_N], tern_secret idx);
+void ringmul_p(modp_t d[PARAMS_MU], const modp_t a[PARAMS_N], const tern_secret idx);
+
+// ringmul_q_lifted(d, p, idx) and ringmul_p(x, b, idx) together, which lets
+// a backend share the work on the secret between both (encryption)
+void ringmul_qp(modq_t d[PARAMS_N], const modq_t p[RINGMUL_LIFT_LEN], modp_t x[PARAMS_MU], const modp_t b[PARAMS_N], tern_secret idx);
 
 #endif
 
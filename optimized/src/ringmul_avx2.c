@@ -20,18 +20,13 @@
 #define LOAD(a)         _mm256_lddqu_si256(a)
 #define STORE(a,b)      _mm256_storeu_si256(a,b)
 
-// multiplication mod q, result length n
-void ringmul_q(modq_t d[PARAMS_N],
-               modq_t a[PARAMS_N],
-               tern_secret secret_vector) {
-    
-    uint16_t j, k;
-    modq_t *b;
+// "lift" -- multiply by (x - 1) -- and duplicate, so rotations need no modulo
+void ringmul_q_lift(modq_t p[RINGMUL_LIFT_LEN],
+                    modq_t a[PARAMS_N]) {
     
-    modq_t p[2 * (PARAMS_N + 1) + NUMCOEFS] __attribute__ ((aligned(32))) = {0};
+    uint16_t k;
     
     // Note: order of coefficients a[1..n] is *NOT* reversed!
-    // "lift" -- multiply by (x - 1)
     p[0] = (modq_t) (-a[0]);
     for (k = 1; k < PARAMS_N; k++) {
         p[k] = (modq_t) (a[k - 1] - a[k]);
@@ -40,6 +35,16 @@ void ringmul_q(modq_t d[PARAMS_N],
     
     // Duplicate at the end
     memcpy(p + (PARAMS_N + 1), p, (PARAMS_N + 1) * sizeof (modq_t));
+    memset(p + 2 * (PARAMS_N + 1), 0, NUMCOEFS * sizeof (modq_t));
+}
+
+// multiplication mod q of a lifted a, result length n
+void ringmul_q_lifted(modq_t d[PARAMS_N],
+                      const modq_t p[RINGMUL_LIFT_LEN],
+                      tern_secret secret_vector) {
+    
+    uint16_t j, k;
+    const modq_t *b;
     
     // Initialize result
     memset(d, 0, PARAMS_N * sizeof (modq_t));
@@ -59,13 +64,13 @@ void ringmul_q(modq_t d[PARAMS_N],
 
         for (j = 0; j < (PARAMS_N+NUMCOEFS-1)/NUMCOEFS; j+=1) {
             
-            b16_0 = LOAD((__m256i*)(&b[NUMCOEFS*j]));
+            b16_0 = LOAD((const __m256i*)(&b[NUMCOEFS*j]));
             b16_0 = MULT(b16_0, secret_vector16);
-            b16_1 = LOAD((__m256i*)(&b[NUMCOEFS*j-1]));
+            b16_1 = LOAD((const __m256i*)(&b[NUMCOEFS*j-1]));
             b16_1 = MULT(b16_1, secret_vector16_1);
-            b16_2 = LOAD((__m256i*)(&b[NUMCOEFS*j-2]));
+            b16_2 = LOAD((const __m256i*)(&b[NUMCOEFS*j-2]));
             b16_2 = MULT(b16_2, secret_vector16_2);
-            b16_3 = LOAD((__m256i*)(&b[NUMCOEFS*j-3]));
+            b16_3 = LOAD((const __m256i*)(&b[NUMCOEFS*j-3]));
             b16_3 = MULT(b16_3, secret_vector16_3);
             
             b16_0 = ADD(b16_0, b16_1);
@@ -84,7 +89,7 @@ void ringmul_q(modq_t d[PARAMS_N],
 
         for (j = 0; j < (PARAMS_N+NUMCOEFS-1)/NUMCOEFS; j+=1) {
 
-            b16_0 = LOAD((__m256i*)(&b[NUMCOEFS*j]));
+            b16_0 = LOAD((const __m256i*)(&b[NUMCOEFS*j]));
             b16_0 = MULT(b16_0, secret_vector16);
 
             d16[j] = ADD(d16[j], b16_0);
@@ -110,19 +115,32 @@ void ringmul_q(modq_t d[PARAMS_N],
     }
 }
 
-// multiplication mod p, result length mu
-void ringmul_p(modp_t d[PARAMS_MU],
-               modp_t input[PARAMS_N],
+// multiplication mod q, result length n
+void ringmul_q(modq_t d[PARAMS_N],
+               modq_t a[PARAMS_N],
                tern_secret secret_vector) {
     
-    size_t j, k;
-    modq_t p[(PARAMS_MU + 2) + (PARAMS_N + 1)];
-    modq_t  *b, *b0, *a;
+    modq_t p[RINGMUL_LIFT_LEN] __attribute__ ((aligned(32)));
     
-    a = &p[0];
-    b = &p[PARAMS_N + 1];
+    ringmul_q_lift(p, a);
+    ringmul_q_lifted(d, p, secret_vector);
+}
+
+// lift (XE == 0) or copy a mod p input into p, duplicated so that rotations
+// need no modulo; the multiplication walks p down from &p[RINGMUL_P_TOP]
+#if (PARAMS_XE == 0) && (PARAMS_F == 0)
+#define RINGMUL_P_TOP (PARAMS_N + 1)
+#else
+#define RINGMUL_P_TOP (PARAMS_N + 2)
+#endif
+#define RINGMUL_P_LEN ((PARAMS_MU + 2) + (PARAMS_N + 1))
+
+static void ringmul_p_lift(modq_t p[RINGMUL_P_LEN], const modp_t input[PARAMS_N]) {
+
     // Note: order of coefficients p[1..N] is *NOT* reversed!
 #if (PARAMS_XE == 0) && (PARAMS_F == 0)
+    size_t k;
+
     // Without error correction we "lift" -- i.e. multiply by (x - 1)
     p[0] = (modq_t) (-input[0]);
     for (k = 1; k < PARAMS_N; k++) {
@@ -131,21 +149,148 @@ void ringmul_p(modp_t d[PARAMS_MU],
     p[PARAMS_N] = (modq_t) input[PARAMS_N - 1];
 
 #else
+    size_t j;
+
     // With error correction we do not "lift"
     for (j=0; j<PARAMS_N;j++){p[j] = input[j];}
     p[PARAMS_N] = 0;
     p[PARAMS_N+1] = input[0];
-    a++;
-    b++;
 #endif
-    b0 = b;
     
     // Duplicate elements so we don't need to perform index modulo
     memcpy(p + (PARAMS_N + 1), p, (PARAMS_MU + 2) * sizeof (modq_t));
+}
+
+#if (PARAMS_P_BITS <= 8)
+
+// With p <= 2^8 the mod p products wrap in 8-bit lanes, and with a ternary
+// secret each product is the coefficient, its negation or 0: ringmul_p
+// takes 32 coefficients per register and _mm256_sign_epi8() in place of
+// the multiplication.
+#define NUMCOEFS8 32
+#define P_BLOCKS8 ((PARAMS_MU + NUMCOEFS8 - 1) / NUMCOEFS8)
+#define SET1_8(a)       _mm256_set1_epi8(a)
+#define SIGN8(a,b)      _mm256_sign_epi8(a, b)
+#define ADD8(a,b)       _mm256_add_epi8(a, b)
+
+// room for the whole blocks of the last slice
+#define RINGMUL_P8_LEN (RINGMUL_P_LEN + NUMCOEFS8)
+
+// ringmul_p_lift() in bytes, zero padded
+static void ringmul_p_lift8(uint8_t p[RINGMUL_P8_LEN], const modp_t input[PARAMS_N]) {
+
+    // Note: order of coefficients p[1..N] is *NOT* reversed!
+#if (PARAMS_XE == 0) && (PARAMS_F == 0)
+    size_t k;
+
+    // Without error correction we "lift" -- i.e. multiply by (x - 1)
+    p[0] = (uint8_t) (-input[0]);
+    for (k = 1; k + NUMCOEFS8 <= PARAMS_N; k += NUMCOEFS8) {
+        STORE((__m256i*) &p[k], _mm256_sub_epi8(LOAD((const __m256i*) &input[k - 1]),
+                                                LOAD((const __m256i*) &input[k])));
+    }
+    for (; k < PARAMS_N; k++) {
+        p[k] = (uint8_t) (input[k - 1] - input[k]);
+    }
+    p[PARAMS_N] = input[PARAMS_N - 1];
+#else
+    // With error correction we do not "lift"
+    memcpy(p, input, PARAMS_N);
+    p[PARAMS_N] = 0;
+#endif
+
+    // Duplicate elements so we don't need to perform index modulo
+    memcpy(p + (PARAMS_N + 1), p, PARAMS_MU + 2);
+    memset(p + (PARAMS_N + 1) + (PARAMS_MU + 2), 0, RINGMUL_P8_LEN - (PARAMS_N + 1) - (PARAMS_MU + 2));
+}
+
+// multiplication mod p, result length mu
+void ringmul_p(modp_t d[PARAMS_MU],
+               const modp_t input[PARAMS_N],
+               const tern_secret secret_vector) {
+
+    size_t j, k;
+    uint8_t p[RINGMUL_P8_LEN];
+    uint8_t d8_out[NUMCOEFS8 * P_BLOCKS8];
+    const uint8_t *b;
+    __m256i d8[P_BLOCKS8];
+    __m256i s8_0, s8_1, s8_2, s8_3;
+
+    ringmul_p_lift8(p, input);
+    b = &p[RINGMUL_P_TOP];
+
+    for (j = 0; j < P_BLOCKS8; j++) {
+        d8[j] = _mm256_setzero_si256();
+    }
+
+    for (k = 0; k < 4*((PARAMS_N - 3)/4); k += 4) {
+        s8_0 = SET1_8((char) secret_vector[k]);
+        s8_1 = SET1_8((char) secret_vector[k+1]);
+        s8_2 = SET1_8((char) secret_vector[k+2]);
+        s8_3 = SET1_8((char) secret_vector[k+3]);
+        for (j = 0; j < P_BLOCKS8; j++) {
+            d8[j] = ADD8(d8[j], ADD8(ADD8(SIGN8(LOAD((const __m256i*) &b[NUMCOEFS8*j]), s8_0),
+                                          SIGN8(LOAD((const __m256i*) &b[NUMCOEFS8*j-1]), s8_1)),
+                                     ADD8(SIGN8(LOAD((const __m256i*) &b[NUMCOEFS8*j-2]), s8_2),
+                                          SIGN8(LOAD((const __m256i*) &b[NUMCOEFS8*j-3]), s8_3))));
+        }
+        b -= 4;
+    }
+
+    for (; k < PARAMS_N; k++) {
+        s8_0 = SET1_8((char) secret_vector[k]);
+        for (j = 0; j < P_BLOCKS8; j++) {
+            d8[j] = ADD8(d8[j], SIGN8(LOAD((const __m256i*) &b[NUMCOEFS8*j]), s8_0));
+        }
+        b--;
+    }
+
+#if (PARAMS_XE == 0) && (PARAMS_F == 0)
+    // Without error correction we "lifted" so we now need to "unlift":
+    // d[k] = d[k - 1] - d[k] are the negated prefix sums, taken within each
+    // 128-bit lane, then across the lanes and from the blocks before
+    {
+        const __m256i last = SET1_8(15);
+        __m256i x, carry = _mm256_setzero_si256();
+
+        for (j = 0; j < P_BLOCKS8; j++) {
+            x = d8[j];
+            x = ADD8(x, _mm256_slli_si256(x, 1));
+            x = ADD8(x, _mm256_slli_si256(x, 2));
+            x = ADD8(x, _mm256_slli_si256(x, 4));
+            x = ADD8(x, _mm256_slli_si256(x, 8));
+            x = ADD8(x, _mm256_permute2x128_si256(_mm256_shuffle_epi8(x, last), x, 0x08));
+            x = ADD8(x, carry);
+            carry = _mm256_permute4x64_epi64(_mm256_shuffle_epi8(x, last), 0xff);
+            d8[j] = _mm256_sub_epi8(_mm256_setzero_si256(), x);
+        }
+    }
+#endif
+
+    for (j = 0; j < P_BLOCKS8; j++) {
+        STORE((__m256i*) &d8_out[NUMCOEFS8*j], d8[j]);
+    }
+    memcpy(d, d8_out, PARAMS_MU);
+}
+
+#else
+
+// multiplication mod p, result length mu
+void ringmul_p(modp_t d[PARAMS_MU],
+               const modp_t input[PARAMS_N],
+               const tern_secret secret_vector) {
+    
+    size_t j, k;
+    modq_t p[RINGMUL_P_LEN];
+    modq_t  *b, *b0, *a;
+    
+    ringmul_p_lift(p, input);
+    b = &p[RINGMUL_P_TOP];
+    a = b - PARAMS_N;
+    b0 = b;
     
     // Initialize result
     memset(d, 0, PARAMS_MU * sizeof (modp_t));
-    a++;
     
     __m256i d16[PARAMS_MU/NUMCOEFS] __attribute__ ((aligned(32))) = {0};
     
@@ -221,4 +366,128 @@ void ringmul_p(modp_t d[PARAMS_MU],
 #endif
 }
 
+#endif
+
+// multiplication of a lifted a mod q (result length n) and of b mod p
+// (result length mu) by the same secret, in a single sweep over the secret
+void ringmul_qp(modq_t d[PARAMS_N],
+                const modq_t p[RINGMUL_LIFT_LEN],
+                modp_t x[PARAMS_MU],
+                const modp_t input[PARAMS_N],
+                tern_secret secret_vector) {
+    
+    size_t j, k;
+    modq_t pp[RINGMUL_P_LEN];
+    const modq_t *bq, *bp;
+    
+    ringmul_p_lift(pp, input);
+    bq = &p[PARAMS_N + 1];
+    bp = &pp[RINGMUL_P_TOP];
+    
+    // Initialize result
+    memset(x, 0, PARAMS_MU * sizeof (modp_t));
+    
+    __m256i dq16[(PARAMS_N+NUMCOEFS-1)/NUMCOEFS] __attribute__ ((aligned(32))) = {0};
+    __m256i dp16[PARAMS_MU/NUMCOEFS] __attribute__ ((aligned(32))) = {0};
+    register __m256i b16_0, b16_1, b16_2, b16_3;
+    register __m256i secret_vector16, secret_vector16_1, secret_vector16_2, secret_vector16_3;
+    
+    for (k = 0; k < 4*((PARAMS_N - 3)/4); k += 4) {
+        
+        secret_vector16     = SET1(secret_vector[k]);
+        secret_vector16_1   = SET1(secret_vector[k+1]);
+        secret_vector16_2   = SET1(secret_vector[k+2]);
+        secret_vector16_3   = SET1(secret_vector[k+3]);
+        
+        for (j = 0; j < (PARAMS_N+NUMCOEFS-1)/NUMCOEFS; j++) {
+            b16_0 = LOAD((const __m256i*)(&bq[NUMCOEFS*j]));
+            b16_0 = MULT(b16_0, secret_vector16);
+            b16_1 = LOAD((const __m256i*)(&bq[NUMCOEFS*j-1]));
+            b16_1 = MULT(b16_1, secret_vector16_1);
+            b16_2 = LOAD((const __m256i*)(&bq[NUMCOEFS*j-2]));
+            b16_2 = MULT(b16_2, secret_vector16_2);
+            b16_3 = LOAD((const __m256i*)(&bq[NUMCOEFS*j-3]));
+            b16_3 = MULT(b16_3, secret_vector16_3);
+            
+            b16_0 = ADD(b16_0, b16_1);
+            b16_2 = ADD(b16_2, b16_3);
+            b16_0 = ADD(b16_0, b16_2);
+            dq16[j] = ADD(dq16[j], b16_0);
+        }
+        
+        for (j = 0; j < PARAMS_MU/NUMCOEFS; j++) {
+            b16_0 = LOAD((const __m256i*)(&bp[NUMCOEFS*j]));
+            b16_0 = MULT(b16_0, secret_vector16);
+            b16_1 = LOAD((const __m256i*)(&bp[NUMCOEFS*j-1]));
+            b16_1 = MULT(b16_1, secret_vector16_1);
+            b16_2 = LOAD((const __m256i*)(&bp[NUMCOEFS*j-2]));
+            b16_2 = MULT(b16_2, secret_vector16_2);
+            b16_3 = LOAD((const __m256i*)(&bp[NUMCOEFS*j-3]));
+            b16_3 = MULT(b16_3, secret_vector16_3);
+            
+            b16_0 = ADD(b16_0, b16_1);
+            b16_2 = ADD(b16_2, b16_3);
+            b16_0 = ADD(b16_0, b16_2);
+            dp16[j] = ADD(dp16[j], b16_0);
+        }
+        for (j = NUMCOEFS*(PARAMS_MU/NUMCOEFS); j < PARAMS_MU; j++) {
+            x[j] += bp[j]*secret_vector[k] +
+            bp[j-1]*secret_vector[k+1] +
+            bp[j-2]*secret_vector[k+2] +
+            bp[j-3]*secret_vector[k+3];
+        }
+        bq -= 4;
+        bp -= 4;
+    }
+    
+    for (; k < PARAMS_N; k++) {
+        secret_vector16 = SET1(secret_vector[k]);
+        for (j = 0; j < (PARAMS_N+NUMCOEFS-1)/NUMCOEFS; j++) {
+            b16_0 = LOAD((const __m256i*)(&bq[NUMCOEFS*j]));
+            b16_0 = MULT(b16_0, secret_vector16);
+            dq16[j] = ADD(dq16[j], b16_0);
+        }
+        for (j = 0; j < PARAMS_MU/NUMCOEFS; j++) {
+            b16_0 = LOAD((const __m256i*)(&bp[NUMCOEFS*j]));
+            b16_0 = MULT(b16_0, secret_vector16);
+            dp16[j] = ADD(dp16[j], b16_0);
+        }
+        for (j = NUMCOEFS*(PARAMS_MU/NUMCOEFS); j < PARAMS_MU; j++) {
+            x[j] += (bp[j]*secret_vector[k]);
+        }
+        bq--;
+        bp--;
+    }
+    
+    for (j = 0; j < PARAMS_N/NUMCOEFS; j++){
+        STORE((__m256i*) &d[NUMCOEFS*j], dq16[j]);
+    }
+    uint16_t *pd16 = (uint16_t*) &dq16[((PARAMS_N+NUMCOEFS-1)/NUMCOEFS)-1];
+    for (j = NUMCOEFS*(PARAMS_N/NUMCOEFS); j < PARAMS_N; j++){
+        d[j] = (modq_t) pd16[j - NUMCOEFS*(PARAMS_N/NUMCOEFS)];
+    }
+    
+    for (j = 0; j < PARAMS_MU/NUMCOEFS; j++){
+#if (PARAMS_P_BITS > 8)
+        STORE((__m256i*) &x[NUMCOEFS*j], dp16[j]);
+#else
+        for (k=0; k < 16 ; k++){
+            x[j*NUMCOEFS+k] = ((uint16_t*) &dp16[j])[k];
+        }
+#endif
+    }
+    
+    // "unlift"
+    d[0] = (uint16_t) (-d[0]);
+    for (k = 1; k < PARAMS_N; ++k) {
+        d[k] = (uint16_t) (d[k - 1] - d[k]);
+    }
+#if (PARAMS_XE == 0) && (PARAMS_F == 0)
+    x[0] = (modp_t) (-x[0]);
+    for (k = 1; k < PARAMS_MU; ++k) {
+        x[k] = (modp_t) (x[k - 1] - x[k]);
+    }
+#endif
+}
+
 #endif /* PARAMS_K == 1 && defined(CM_CT) && defined(AVX2)   */
@@ -7,7 +7,7 @@
 
 #include "ringmul.h"
 
-#if PARAMS_K == 1 && defined(CM_CACHE)
+#if PARAMS_K == 1 && defined(CM_CACHE) && !defined(AVX2)
 
 #include "drbg.h"
 #include "little_endian.h"
@@ -15,19 +15,23 @@
 #include <string.h>
 
 
-// multiplication mod q, result length n
+// "lift" -- multiply by (x - 1) -- in reversed order
 
-void ringmul_q(modq_t d[PARAMS_N], modq_t a[PARAMS_N], tern_secret idx) {
-    size_t i, j, k;
-    modq_t p[PARAMS_N + 1];
+void ringmul_q_lift(modq_t p[RINGMUL_LIFT_LEN], modq_t a[PARAMS_N]) {
+    size_t i;
 
     // Note: order of coefficients a[1..n] is reversed!
-    // "lift" -- multiply by (x - 1)
     p[0] = (modq_t) (-a[0]);
     for (i = 1; i < PARAMS_N; i++) {
         p[PARAMS_N + 1 - i] = (modq_t) (a[i - 1] - a[i]);
     }
     p[1] = a[PARAMS_N - 1];
+}
+
+// multiplication mod q of a lifted a, result length n
+
+void ringmul_q_lifted(modq_t d[PARAMS_N], const modq_t p[RINGMUL_LIFT_LEN], tern_secret idx) {
+    size_t i, j, k;
 
     // Initialize result
     memset(d, 0, PARAMS_N * sizeof (modq_t));
@@ -65,9 +69,19 @@ void ringmul_q(modq_t d[PARAMS_N], modq_t a[PARAMS_N], tern_secret idx) {
     }
 }
 
+// multiplication mod q, result length n
+
+void ringmul_q(modq_t d[PARAMS_N], modq_t a[PARAMS_N], tern_secret idx) {
+    modq_t p[RINGMUL_LIFT_LEN];
+
+    ringmul_q_lift(p, a);
+    ringmul_q_lifted(d, p, idx);
+}
+
+
 // multiplication mod p, result length mu
 
-void ringmul_p(modp_t d[PARAMS_MU], modp_t a[PARAMS_N], tern_secret idx) {
+void ringmul_p(modp_t d[PARAMS_MU], const modp_t a[PARAMS_N], const tern_secret idx) {
     size_t i, j, k;
     modp_t p[PARAMS_N + 1];
 
@@ -136,4 +150,11 @@ void ringmul_p(modp_t d[PARAMS_MU], modp_t a[PARAMS_N], tern_secret idx) {
 #endif
 }
 
-#endif /* PARAMS_K == 1 && defined(CM_CACHE) */
+// both multiplications of encryption, one after the other
+
+void ringmul_qp(modq_t d[PARAMS_N], const modq_t p[RINGMUL_LIFT_LEN], modp_t x[PARAMS_MU], const modp_t b[PARAMS_N], tern_secret idx) {
+    ringmul_q_lifted(d, p, idx);
+    ringmul_p(x, b, (const tern_coef_type (*)[2]) idx);
+}
+
+#endif /* PARAMS_K == 1 && defined(CM_CACHE) && !defined(AVX2) */
@@ -0,0 +1,211 @@
+/*
+ * Copyright (c) 2020, PQShield and Koninklijke Philips N.V.
+ * Markku-Juhani O. Saarinen, Koninklijke Philips N.V.
+ */
+
+// Sparse ring arithmetic with AVX2 (with cache attack countermeasures)
+//
+// Works from the h/2 (+1, -1) index pairs of the secret, as ringmul_cm.c
+// does, but adds and subtracts whole rotated slices of the duplicated
+// lifted polynomial 16 coefficients at a time. As in ringmul_cm.c, every
+// index touches the whole buffer: the cache lines outside of the slice
+// are read as well, so the set of lines accessed does not depend on it.
+
+#include "ringmul.h"
+
+#if PARAMS_K == 1 && defined(CM_CACHE) && defined(AVX2)
+
+#include <immintrin.h>
+#include <string.h>
+
+#define NUMCOEFS 16
+#define ADD(a,b)        _mm256_add_epi16(a, b)
+#define SUB(a,b)        _mm256_sub_epi16(a, b)
+#define LOAD(a)         _mm256_lddqu_si256(a)
+#define STORE(a,b)      _mm256_storeu_si256(a,b)
+
+// coefficients per 64-byte cache line
+#define LINE_COEFS 32
+
+#define Q_BLOCKS ((PARAMS_N + NUMCOEFS - 1) / NUMCOEFS)
+#define P_BLOCKS ((PARAMS_MU + NUMCOEFS - 1) / NUMCOEFS)
+
+// mod p input, lifted (XE == 0) or copied, duplicated and padded; the slice
+// for index k starts at &p[RINGMUL_P_TOP - k]
+#if (PARAMS_XE == 0) && (PARAMS_F == 0)
+#define RINGMUL_P_TOP (PARAMS_N + 1)
+#else
+#define RINGMUL_P_TOP (PARAMS_N + 2)
+#endif
+#define RINGMUL_P_LEN ((PARAMS_MU + 2) + (PARAMS_N + 1) + NUMCOEFS)
+
+// reads one coefficient of every cache line of p[0..len) outside of
+// p[lo..hi), the slice that is read in full
+static inline modq_t touch_outside(const modq_t *p, size_t len, size_t lo, size_t hi) {
+    size_t i;
+    modq_t t = 0;
+
+    for (i = 0; i < lo; i += LINE_COEFS) {
+        t ^= p[i];
+    }
+    t ^= p[lo - 1];
+    for (i = hi; i < len; i += LINE_COEFS) {
+        t ^= p[i];
+    }
+    t ^= p[len - 1];
+
+    return t;
+}
+
+// keeps the compiler from dropping the reads of touch_outside()
+#define KEEP(t) __asm__ __volatile__ ("" : : "r" (t))
+
+// d16 += p[top - k0 ..] - p[top - k1 ..], blocks slices of NUMCOEFS
+#define SLICE_ADD_SUB(d16, p, len, top, blocks, k0, k1, touch) { \
+    const modq_t *p_add = &(p)[(top) - (k0)]; \
+    const modq_t *p_sub = &(p)[(top) - (k1)]; \
+    for (j = 0; j < (blocks); j++) { \
+        (d16)[j] = ADD((d16)[j], SUB(LOAD((const __m256i*) &p_add[NUMCOEFS*j]), \
+                                     LOAD((const __m256i*) &p_sub[NUMCOEFS*j]))); \
+    } \
+    touch ^= touch_outside((p), (len), (top) - (k0), (top) - (k0) + NUMCOEFS*(blocks)); \
+    touch ^= touch_outside((p), (len), (top) - (k1), (top) - (k1) + NUMCOEFS*(blocks)); \
+}
+
+// "lift" -- multiply by (x - 1) -- and duplicate, so rotations need no modulo
+void ringmul_q_lift(modq_t p[RINGMUL_LIFT_LEN], modq_t a[PARAMS_N]) {
+    size_t i;
+
+    // Note: order of coefficients a[1..n] is *NOT* reversed!
+    p[0] = (modq_t) (-a[0]);
+    for (i = 1; i < PARAMS_N; i++) {
+        p[i] = (modq_t) (a[i - 1] - a[i]);
+    }
+    p[PARAMS_N] = a[PARAMS_N - 1];
+
+    // Duplicate at the end
+    memcpy(p + (PARAMS_N + 1), p, (PARAMS_N + 1) * sizeof (modq_t));
+    memset(p + 2 * (PARAMS_N + 1), 0, NUMCOEFS * sizeof (modq_t));
+}
+
+static void ringmul_p_lift(modq_t p[RINGMUL_P_LEN], const modp_t a[PARAMS_N]) {
+    size_t i;
+
+    // Note: order of coefficients p[1..N] is *NOT* reversed!
+#if (PARAMS_XE == 0) && (PARAMS_F == 0)
+    // Without error correction we "lift" -- i.e. multiply by (x - 1)
+    p[0] = (modq_t) (-a[0]);
+    for (i = 1; i < PARAMS_N; i++) {
+        p[i] = (modq_t) (a[i - 1] - a[i]);
+    }
+    p[PARAMS_N] = a[PARAMS_N - 1];
+#else
+    // With error correction we do not "lift"
+    for (i = 0; i < PARAMS_N; i++) {
+        p[i] = a[i];
+    }
+    p[PARAMS_N] = 0;
+#endif
+
+    // Duplicate elements so we don't need to perform index modulo
+    memcpy(p + (PARAMS_N + 1), p, (PARAMS_MU + 2) * sizeof (modq_t));
+    memset(p + (PARAMS_MU + 2) + (PARAMS_N + 1), 0, NUMCOEFS * sizeof (modq_t));
+}
+
+static void store_q(modq_t d[PARAMS_N], __m256i d16[Q_BLOCKS]) {
+    size_t i;
+
+    for (i = 0; i < PARAMS_N / NUMCOEFS; i++) {
+        STORE((__m256i*) &d[NUMCOEFS*i], d16[i]);
+    }
+    for (i = NUMCOEFS*(PARAMS_N/NUMCOEFS); i < PARAMS_N; i++) {
+        d[i] = ((uint16_t*) d16)[i];
+    }
+
+    // "unlift"
+    d[0] = (uint16_t) (-d[0]);
+    for (i = 1; i < PARAMS_N; ++i) {
+        d[i] = (uint16_t) (d[i - 1] - d[i]);
+    }
+}
+
+static void store_p(modp_t d[PARAMS_MU], __m256i d16[P_BLOCKS]) {
+    size_t i;
+
+    for (i = 0; i < PARAMS_MU; i++) {
+        d[i] = (modp_t) ((uint16_t*) d16)[i];
+    }
+
+#if (PARAMS_XE == 0) && (PARAMS_F == 0)
+    // Without error correction we "lifted" so we now need to "unlift"
+    d[0] = (modp_t) (-d[0]);
+    for (i = 1; i < PARAMS_MU; ++i) {
+        d[i] = (modp_t) (d[i - 1] - d[i]);
+    }
+#endif
+}
+
+// multiplication mod q of a lifted a, result length n
+
+void ringmul_q_lifted(modq_t d[PARAMS_N], const modq_t p[RINGMUL_LIFT_LEN], tern_secret idx) {
+    size_t i, j;
+    modq_t touch = 0;
+    __m256i d16[Q_BLOCKS] __attribute__ ((aligned(32))) = {0};
+
+    for (i = 0; i < PARAMS_H / 2; i++) {
+        SLICE_ADD_SUB(d16, p, RINGMUL_LIFT_LEN, PARAMS_N + 1, Q_BLOCKS, idx[i][0], idx[i][1], touch);
+    }
+    KEEP(touch);
+
+    store_q(d, d16);
+}
+
+// multiplication mod q, result length n
+
+void ringmul_q(modq_t d[PARAMS_N], modq_t a[PARAMS_N], tern_secret idx) {
+    modq_t p[RINGMUL_LIFT_LEN] __attribute__ ((aligned(32)));
+
+    ringmul_q_lift(p, a);
+    ringmul_q_lifted(d, p, idx);
+}
+
+// multiplication mod p, result length mu
+
+void ringmul_p(modp_t d[PARAMS_MU], const modp_t a[PARAMS_N], const tern_secret idx) {
+    size_t i, j;
+    modq_t touch = 0;
+    modq_t p[RINGMUL_P_LEN] __attribute__ ((aligned(32)));
+    __m256i d16[P_BLOCKS] __attribute__ ((aligned(32))) = {0};
+
+    ringmul_p_lift(p, a);
+
+    for (i = 0; i < PARAMS_H / 2; i++) {
+        SLICE_ADD_SUB(d16, p, RINGMUL_P_LEN, RINGMUL_P_TOP, P_BLOCKS, idx[i][0], idx[i][1], touch);
+    }
+    KEEP(touch);
+
+    store_p(d, d16);
+}
+
+// both multiplications of encryption, in one sweep over the indices
+
+void ringmul_qp(modq_t d[PARAMS_N], const modq_t p[RINGMUL_LIFT_LEN], modp_t x[PARAMS_MU], const modp_t b[PARAMS_N], tern_secret idx) {
+    size_t i, j;
+    modq_t touch = 0;
+    modq_t pb[RINGMUL_P_LEN] __attribute__ ((aligned(32)));
+    __m256i d16[Q_BLOCKS] __attribute__ ((aligned(32))) = {0};
+    __m256i x16[P_BLOCKS] __attribute__ ((aligned(32))) = {0};
+
+    ringmul_p_lift(pb, b);
+
+    for (i = 0; i < PARAMS_H / 2; i++) {
+        SLICE_ADD_SUB(d16, p, RINGMUL_LIFT_LEN, PARAMS_N + 1, Q_BLOCKS, idx[i][0], idx[i][1], touch);
+        SLICE_ADD_SUB(x16, pb, RINGMUL_P_LEN, RINGMUL_P_TOP, P_BLOCKS, idx[i][0], idx[i][1], touch);
+    }
+    KEEP(touch);
+
+    store_q(d, d16);
+    store_p(x, x16);
+}
+
+#endif /* PARAMS_K == 1 && defined(CM_CACHE) && defined(AVX2) */
@@ -12,18 +12,13 @@
 #include <string.h>
 #include "drbg.h"
 
-// multiplication mod q, result length n
-void ringmul_q(modq_t d[PARAMS_N],
-               modq_t a[PARAMS_N],
-               tern_secret secret_vector) {
-    
-    size_t j, k;
-    modq_t *b;
+// "lift" -- multiply by (x - 1) -- and duplicate, so rotations need no modulo
+void ringmul_q_lift(modq_t p[RINGMUL_LIFT_LEN],
+                    modq_t a[PARAMS_N]) {
     
-    modq_t p[2 * (PARAMS_N + 1)];
+    size_t k;
     
     // Note: order of coefficients a[1..n] is *NOT* reversed!
-    // "lift" -- multiply by (x - 1)
     p[0] = (modq_t) (-a[0]);
     for (k = 1; k < PARAMS_N; k++) {
         p[k] = (modq_t) (a[k - 1] - a[k]);
@@ -31,8 +26,16 @@ void ringmul_q(modq_t d[PARAMS_N],
     p[PARAMS_N] = a[PARAMS_N - 1];
     
     // Duplicate at the end
-    
     memcpy(p + (PARAMS_N + 1), p, (PARAMS_N + 1) * sizeof (modq_t));
+}
+
+// multiplication mod q of a lifted a, result length n
+void ringmul_q_lifted(modq_t d[PARAMS_N],
+                      const modq_t p[RINGMUL_LIFT_LEN],
+                      tern_secret secret_vector) {
+    
+    size_t j, k;
+    const modq_t *b;
     
     // Initialize result
     memset(d, 0, PARAMS_N * sizeof (modq_t));
@@ -57,10 +60,22 @@ void ringmul_q(modq_t d[PARAMS_N],
 }
 
 
+// multiplication mod q, result length n
+void ringmul_q(modq_t d[PARAMS_N],
+               modq_t a[PARAMS_N],
+               tern_secret secret_vector) {
+    
+    modq_t p[RINGMUL_LIFT_LEN];
+    
+    ringmul_q_lift(p, a);
+    ringmul_q_lifted(d, p, secret_vector);
+}
+
+
 // multiplication mod p, result length mu
 void ringmul_p(modp_t d[PARAMS_MU],
-               modp_t input[PARAMS_N],
-               tern_secret secret_vector) {
+               const modp_t input[PARAMS_N],
+               const tern_secret secret_vector) {
     
     size_t j, k;
     modp_t p[(PARAMS_MU + 2) + (PARAMS_N + 1)];
@@ -110,6 +125,11 @@ void ringmul_p(modp_t d[PARAMS_MU],
 #endif
 }
 
+// both multiplications of encryption, one after the other
 
+void ringmul_qp(modq_t d[PARAMS_N], const modq_t p[RINGMUL_LIFT_LEN], modp_t x[PARAMS_MU], const modp_t b[PARAMS_N], tern_secret idx) {
+    ringmul_q_lifted(d, p, idx);
+    ringmul_p(x, b, idx);
+}
 
 #endif /* PARAMS_K == 1 && defined(CM_CACHE) */
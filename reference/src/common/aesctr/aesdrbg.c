@@ -4,6 +4,8 @@
 
 #include "aesdrbg.h"
 
+#include <string.h>
+
 static void AESinCtrModeConfig
 	( AESContext context, const uint8_t *key Parameters)
 { 
@@ -34,6 +36,9 @@ static void AESinCtrModeConfig
 #define address 0
 #endif
 
+/* The size of the batches of whole blocks that are generated in place */
+#define AES_CTR_BATCH 16384
+
 void AESCTRGen16
 	( AESContext context
 	, uint16_t *out, size_t outputLength )
@@ -41,26 +46,46 @@ void AESCTRGen16
 	uint8_t *buffer = context->index;
 	size_t no = (size_t) ((&context->remaining[16]) - buffer);
 	uint8_t *output = ((uint8_t *) (out));
+	size_t batch;
+	int len;
 	outputLength *= 2;
 
 #if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
 	int d = -1;
 #endif
 
-	while( outputLength >= no ) {
+	if( outputLength >= no ) {
 		while( buffer < &context->remaining[16] ) {
 			output[address] = *buffer++; 
 			output++; 
 		}
 		outputLength -= no;
 
-		int len;
+		/* Whole blocks: the key stream is the encryption of zeros, which
+		 * counter mode does in place, many blocks per call */
+		while( outputLength >= 16 ) {
+			batch = outputLength < AES_CTR_BATCH ? outputLength & ~((size_t) 15) : AES_CTR_BATCH;
+			memset(output, 0, batch);
+			if ( EVP_EncryptUpdate(context->aes_ctx, output, &len, output, (int) batch) != 1) {
+				DEBUG_ERROR("Error: failed to generate deterministic random data.\n");
+				abort();
+			}
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+			for ( size_t i = 0; i < batch; i += 2 ) {
+				uint8_t t = output[i];
+				output[i] = output[i + 1];
+				output[i + 1] = t;
+			}
+#endif
+			output += batch;
+			outputLength -= batch;
+		}
+
 		if ( EVP_EncryptUpdate(context->aes_ctx, context->remaining, &len, context->state, 16) != 1) {
 			DEBUG_ERROR("Error: failed to generate deterministic random data.\n");
 			abort();
 		}
-		no = 16;
-                buffer = context->remaining;
+		buffer = context->remaining;
 	}
 	for ( size_t i = 0; i < outputLength; i++ ) {
 		output[address] = *buffer++; 
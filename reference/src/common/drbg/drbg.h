@@ -32,14 +32,30 @@ r5_tuple_hash_input(&thcontext, d, 4, i1, PARAMS_KAPPA_BYTES, i2, i2len, 3, 0 Pa
 #define SKGenerationGen(o, olen) \
 r5_tuple_hash_xof_squeeze16(o, olen, &thcontext Params)
 
-#define SKGenerationInit_4x(d, i1, i20, i21, i22, i23) \
+#define SKGenerationInit_4x(d, i10, i11, i12, i13, i20, i21, i22, i23) \
 ttupleHash_Instance thcontext = {0}; \
 uint32_t i2len = 1; \
-r5_tuple_hash_input_4x(&thcontext, d, d, d, d, 4, i1, i1, i1, i1, PARAMS_KAPPA_BYTES, i20, i21, i22, i23, i2len, 3, 0 Params)
+r5_tuple_hash_input_4x(&thcontext, d, d, d, d, 4, i10, i11, i12, i13, PARAMS_KAPPA_BYTES, i20, i21, i22, i23, i2len, 3, 0 Params)
 
 #define SKGenerationGen_4x(o0, o1, o2, o3, olen) \
 r5_tuple_hash_xof_squeeze16_4x(o0, o1, o2, o3, olen, &thcontext Params)
 
+// the domain and the seed absorbed once, for the streams of all indices
+#define SKGenerationPrefix(p, d, i1) \
+r5_tuple_hash_prefix(p, d, 4, i1, PARAMS_KAPPA_BYTES Params)
+
+#define SKGenerationInitPrefixed(p, i2) \
+ttupleHash_Instance thcontext; \
+r5_tuple_hash_xof_input_prefixed(&thcontext, p, i2, 1 Params)
+
+// a job squeezing olen values of the stream of SKGenerationInit, from the
+// prefix p of d and i1; rest may keep the stream to squeeze more from it
+#define SKGenerationJob(o, olen, d, i1, i2, rest, p) \
+((tupleHash16_Job) {o, olen, d, 4, i1, PARAMS_KAPPA_BYTES, i2, 1, 3, 1, rest, p})
+
+#define SKGenerationJobs(jobs, n) \
+r5_tuple_hash16_jobs(jobs, n Params)
+
 
 /************ Permutation Generation ***********************/
 
@@ -53,6 +69,21 @@ r5_tuple_hash_xof_squeeze16_4x(o0, o1, o2, o3, olen, &thcontext Params)
 
 /************ A Generation ***********************/
 
+#if (!defined(USE_AES_DRBG)) || ((defined(AVX2)) && (defined(STANDALONE)))
+
+// a job for the block of AGeneration, from the prefix p of d and i1;
+// independent blocks are run together
+#define AGenerationPrefix(p, d, i1) \
+    r5_tuple_hash_prefix(p, d, 4, i1, PARAMS_KAPPA_BYTES Params)
+
+#define AGenerationJob(o, olen, d, i1, i2, p) \
+    ((tupleHash16_Job) {o, olen, d, 4, i1, PARAMS_KAPPA_BYTES, i2, 1, 3, 0, NULL, p})
+
+#define AGenerationJobs(jobs, n) \
+    r5_tuple_hash16_jobs(jobs, n Params)
+
+#endif
+
 #if (defined(AVX2))  && (defined(STANDALONE))
 
 #define AGeneration4x(o0, o1, o2, o3, olen, d, i1, i20, i21, i22, i23) \
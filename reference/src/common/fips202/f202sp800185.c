@@ -175,6 +175,67 @@ static void r5_xof_squeeze16_4x
     context->index3 = buffer3;
 }
 
+static void r5_xof_squeeze_4x
+(Context context,
+ uint8_t *output0,
+ uint8_t *output1,
+ uint8_t *output2,
+ uint8_t *output3,
+ size_t outputLength
+ Parameters)
+{
+    uint8_t *buffer0 = context->index0;
+    uint8_t *buffer1 = context->index1;
+    uint8_t *buffer2 = context->index2;
+    uint8_t *buffer3 = context->index3;
+
+    size_t no0 = (size_t) ((&context->remaining0[RATE]) - buffer0);
+
+    while( outputLength >= no0 ) {
+        while( buffer0 < &context->remaining0[RATE] ) {
+            *output0++ = *buffer0++;
+            *output1++ = *buffer1++;
+            *output2++ = *buffer2++;
+            *output3++ = *buffer3++;
+        }
+
+        outputLength -= no0;
+
+        while( outputLength >= RATE ) {
+            KeccakF1600_StatePermute_4x(context->state_4x);
+            KeccakF1600_StateExtractBytes_4x(context->state_4x, output0, output1, output2, output3 Params);
+            outputLength -= RATE;
+
+            output0 += RATE;
+            output1 += RATE;
+            output2 += RATE;
+            output3 += RATE;
+        }
+
+        KeccakF1600_StatePermute_4x(context->state_4x);
+        KeccakF1600_StateExtractBytes_4x(context->state_4x, context->remaining0, context->remaining1, context->remaining2, context->remaining3 Params);
+
+        no0 = RATE;
+
+        buffer0 = context->remaining0;
+        buffer1 = context->remaining1;
+        buffer2 = context->remaining2;
+        buffer3 = context->remaining3;
+    }
+
+    for ( size_t i = 0; i < outputLength; i++ ) {
+        *output0++ = *buffer0++;
+        *output1++ = *buffer1++;
+        *output2++ = *buffer2++;
+        *output3++ = *buffer3++;
+    }
+
+    context->index0 = buffer0;
+    context->index1 = buffer1;
+    context->index2 = buffer2;
+    context->index3 = buffer3;
+}
+
 void r5_xof_s_input_4x // custom init absorb finalize
 ( CContext context,
  const uint8_t *input0,
@@ -262,6 +323,197 @@ void r5_xof_s_squeeze16_4x //cqueeze16_4x
 
 
 
+// absorbs the same number of bytes in each lane; all four lanes are filled
+// up to the same position, index0 marks the first free byte
+static void tuple_hash_absorb_bytes_4x
+( TupleHash_Instance THContext,
+ const uint8_t *input0,
+ const uint8_t *input1,
+ const uint8_t *input2,
+ const uint8_t *input3,
+ size_t inputLength
+ Parameters )
+{
+    Context context = &THContext->ccontext;
+    size_t n = (size_t) (context->index0 - context->remaining0);
+    size_t t;
+
+    while ( n + inputLength >= RATE ) {
+        if ( n == 0 ) {
+            KeccakF1600_StateXORBytes_4x(context->state_4x, input0, input1, input2, input3 Params);
+            t = RATE;
+        } else {
+            t = RATE - n;
+            memcpy(&context->remaining0[n], input0, t);
+            memcpy(&context->remaining1[n], input1, t);
+            memcpy(&context->remaining2[n], input2, t);
+            memcpy(&context->remaining3[n], input3, t);
+            KeccakF1600_StateXORBytes_4x(context->state_4x, context->remaining0, context->remaining1, context->remaining2, context->remaining3 Params);
+            n = 0;
+        }
+        KeccakF1600_StatePermute_4x(context->state_4x);
+
+        inputLength -= t;
+
+        input0 += t;
+        input1 += t;
+        input2 += t;
+        input3 += t;
+    }
+
+    memcpy(&context->remaining0[n], input0, inputLength);
+    memcpy(&context->remaining1[n], input1, inputLength);
+    memcpy(&context->remaining2[n], input2, inputLength);
+    memcpy(&context->remaining3[n], input3, inputLength);
+
+    context->index0 = &context->remaining0[n + inputLength];
+}
+
+// the number of bytes of x in its left_encode or right_encode
+static uint8_t tuple_hash_encode_length(uint64_t x)
+{
+    uint8_t n = 0;
+
+    do {
+        n++;
+    } while ( n < 8 && (x >> (8 * n)) != 0 );
+
+    return n;
+}
+
+// left_encode (right == 0) or right_encode (right == 1) of x[i] in lane i;
+// the encodings must all have the same length
+static void tuple_hash_absorb_encode_lanes_4x
+( TupleHash_Instance THContext, const uint64_t x[4], int right Parameters )
+{
+    uint8_t buf[4][10];
+    uint8_t n = tuple_hash_encode_length(x[0]);
+
+    for ( int l = 0; l < 4; l++ ) {
+        for ( uint8_t i = 0; i < n; i++ ) {
+            buf[l][1 + i] = (uint8_t) (x[l] >> (8 * (n - 1 - i)));
+        }
+        buf[l][0] = n;
+        buf[l][1 + n] = n;
+    }
+
+    tuple_hash_absorb_bytes_4x(THContext, &buf[0][right], &buf[1][right], &buf[2][right], &buf[3][right], (size_t) n + 1 Params);
+}
+
+// left_encode (right == 0) or right_encode (right == 1) of x, in all lanes
+static void tuple_hash_absorb_encode_4x
+( TupleHash_Instance THContext, uint64_t x, int right Parameters )
+{
+    const uint64_t xs[4] = {x, x, x, x};
+
+    tuple_hash_absorb_encode_lanes_4x(THContext, xs, right Params);
+}
+
+// right_encode(L) with the output length of lane i in outputLenBytes[i],
+// then the cSHAKE padding; the right_encode must all have the same length
+static void tuple_hash_pad_lanes_4x
+(TupleHash_Instance THContext,
+ const uint64_t outputLenBytes[4]
+ Parameters )
+{
+    const uint64_t outputBitLen[4] = {8 * outputLenBytes[0], 8 * outputLenBytes[1], 8 * outputLenBytes[2], 8 * outputLenBytes[3]};
+    Context context = &THContext->ccontext;
+    size_t n;
+
+    tuple_hash_absorb_encode_lanes_4x(THContext, outputBitLen, 1 Params);
+
+    n = (size_t) (context->index0 - context->remaining0);
+    memset(&context->remaining0[n], 0x00, RATE - n);
+    memset(&context->remaining1[n], 0x00, RATE - n);
+    memset(&context->remaining2[n], 0x00, RATE - n);
+    memset(&context->remaining3[n], 0x00, RATE - n);
+
+    context->remaining0[n] = 0x04;
+    context->remaining1[n] = 0x04;
+    context->remaining2[n] = 0x04;
+    context->remaining3[n] = 0x04;
+
+    context->remaining0[RATE - 1] |= 0x80;
+    context->remaining1[RATE - 1] |= 0x80;
+    context->remaining2[RATE - 1] |= 0x80;
+    context->remaining3[RATE - 1] |= 0x80;
+
+    KeccakF1600_StateXORBytes_4x(context->state_4x, context->remaining0, context->remaining1, context->remaining2, context->remaining3 Params );
+
+    context->index0 = &(context->remaining0[RATE]);
+    context->index1 = &(context->remaining1[RATE]);
+    context->index2 = &(context->remaining2[RATE]);
+    context->index3 = &(context->remaining3[RATE]);
+}
+
+// the state of a prefix (r5_tuple_hash_prefix) in all four lanes
+static void tuple_hash_prefix_4x
+(TupleHash_Instance THContext,
+ const tupleHash_Snapshot *prefix )
+{
+    Context context = &THContext->ccontext;
+
+    for ( int k = 0; k < 25; k++ ) {
+        context->state_4x[k] = _mm256_set1_epi64x((long long) prefix->state[k]);
+    }
+    memcpy(context->remaining0, prefix->remaining, prefix->remainingLen);
+    memcpy(context->remaining1, prefix->remaining, prefix->remainingLen);
+    memcpy(context->remaining2, prefix->remaining, prefix->remainingLen);
+    memcpy(context->remaining3, prefix->remaining, prefix->remainingLen);
+    context->index0 = &context->remaining0[prefix->remainingLen];
+}
+
+// r5_tuple_hash_input_4x, with the output length of lane i in
+// outputLenBytes[i]; their right_encode must all have the same length
+static void tuple_hash_input_lanes_4x
+(TupleHash_Instance THContext,
+ const uint8_t *domain0,
+ const uint8_t *domain1,
+ const uint8_t *domain2,
+ const uint8_t *domain3,
+ uint8_t domainLen,
+ const uint8_t *first0,
+ const uint8_t *first1,
+ const uint8_t *first2,
+ const uint8_t *first3,
+ uint16_t firstLen,
+ const uint8_t *second0,
+ const uint8_t *second1,
+ const uint8_t *second2,
+ const uint8_t *second3,
+ uint32_t secondLen,
+ uint8_t numberOfElements,
+ const uint64_t outputLenBytes[4]
+ Parameters )
+{
+    Context context = &THContext->ccontext;
+    uint8_t *in = context->remaining0;
+
+    // cSHAKE header: bytepad(encode_string("TupleHash") || encode_string(""), rate)
+    memset(context->state_4x, 0, sizeof (context->state_4x));
+    memset(in, 0, RATE);
+    *in++ = 0x01; *in++ = RATE;
+    *in++ = 0x01; *in++ = 9 << 3;
+    memcpy(in, "TupleHash", 9);
+    in += 9;
+    *in++ = 0x01; *in++ = 0x00;
+    KeccakF1600_StateXORBytes_4x(context->state_4x, context->remaining0, context->remaining0, context->remaining0, context->remaining0 Params);
+    KeccakF1600_StatePermute_4x(context->state_4x);
+    context->index0 = context->remaining0;
+
+    // the elements, absorbed as they are: encode_string(X) = left_encode(|X|) || X
+    tuple_hash_absorb_encode_4x(THContext, 8 * (uint64_t) domainLen, 0 Params);
+    tuple_hash_absorb_bytes_4x(THContext, domain0, domain1, domain2, domain3, domainLen Params);
+    tuple_hash_absorb_encode_4x(THContext, 8 * (uint64_t) firstLen, 0 Params);
+    tuple_hash_absorb_bytes_4x(THContext, first0, first1, first2, first3, firstLen Params);
+    if (numberOfElements == 3){
+        tuple_hash_absorb_encode_4x(THContext, 8 * (uint64_t) secondLen, 0 Params);
+        tuple_hash_absorb_bytes_4x(THContext, second0, second1, second2, second3, secondLen Params);
+    }
+
+    tuple_hash_pad_lanes_4x(THContext, outputLenBytes Params);
+}
+
 void r5_tuple_hash_input_4x // tuple_hash_xof_input
 (TupleHash_Instance THContext,
  const uint8_t *domain0,
@@ -283,197 +535,79 @@ void r5_tuple_hash_input_4x // tuple_hash_xof_input
  uint32_t outputLenBytes
  Parameters )
 {
-    // ToDo: this memory overhead goes away by rewriting this function in such a way that
-    // the inputs are absorbed into the state
-    uint8_t *input0, *input1, *input2, *input3;
-    input0 = checked_malloc(14 + domainLen + firstLen + secondLen);
-    input1 = checked_malloc(14 + domainLen + firstLen + secondLen);
-    input2 = checked_malloc(14 + domainLen + firstLen + secondLen);
-    input3 = checked_malloc(14 + domainLen + firstLen + secondLen);
-    
-    uint8_t *in0 = input0, *in1 = input1,  *in2 = input2, *in3 = input3;
-    uint32_t inputLen = 0;
-    
-    *in0++ = 0x01;
-    *in1++ = 0x01;
-    *in2++ = 0x01;
-    *in3++ = 0x01;
-    assert( domainLen < 32 );
-    *in0++ = (uint8_t) (domainLen << 3);
-    *in1++ = (uint8_t) (domainLen << 3);
-    *in2++ = (uint8_t) (domainLen << 3);
-    *in3++ = (uint8_t) (domainLen << 3);
-    memcpy(in0, domain0, domainLen);
-    memcpy(in1, domain1, domainLen);
-    memcpy(in2, domain2, domainLen);
-    memcpy(in3, domain3, domainLen);
-    in0 += domainLen;
-    in1 += domainLen;
-    in2 += domainLen;
-    in3 += domainLen;
-    
-    inputLen = 2 + domainLen;
-    
-    assert( firstLen <= 8192 );
-    if (firstLen < 32){
-        *in0++ = 0x01;
-        *in1++ = 0x01;
-        *in2++ = 0x01;
-        *in3++ = 0x01;
-        *in0++ = (uint8_t) (firstLen << 3);
-        *in1++ = (uint8_t) (firstLen << 3);
-        *in2++ = (uint8_t) (firstLen << 3);
-        *in3++ = (uint8_t) (firstLen << 3);
-        inputLen += 2;
-    } else {
-        *in0++ = 0x02;
-        *in1++ = 0x02;
-        *in2++ = 0x02;
-        *in3++ = 0x02;
-        *in0++ = (uint8_t) ((firstLen << 3) >> 8);
-        *in1++ = (uint8_t) ((firstLen << 3) >> 8);
-        *in2++ = (uint8_t) ((firstLen << 3) >> 8);
-        *in3++ = (uint8_t) ((firstLen << 3) >> 8);
-        *in0++ = (uint8_t) (firstLen << 3);
-        *in1++ = (uint8_t) (firstLen << 3);
-        *in2++ = (uint8_t) (firstLen << 3);
-        *in3++ = (uint8_t) (firstLen << 3);
-        inputLen += 3;
+    const uint64_t outputLens[4] = {outputLenBytes, outputLenBytes, outputLenBytes, outputLenBytes};
+
+    tuple_hash_input_lanes_4x(THContext, domain0, domain1, domain2, domain3, domainLen, first0, first1, first2, first3, firstLen,
+                              second0, second1, second2, second3, secondLen, numberOfElements, outputLens Params);
+}
+
+// squeezes len[i] bytes into lane i, for lengths that differ; lanes that are
+// done still run along
+static void tuple_hash_squeeze_lanes_4x
+(Context context,
+ uint8_t *output[4],
+ const size_t len[4]
+ Parameters)
+{
+    uint8_t *remaining[4] = {context->remaining0, context->remaining1, context->remaining2, context->remaining3};
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    uint8_t *block[4];
+#endif
+    size_t p = (size_t) (context->index0 - context->remaining0);
+    size_t max = 0, done, c, i;
+
+    for ( i = 0; i < 4; i++ ) {
+        max = len[i] > max ? len[i] : max;
     }
-    memcpy(in0, first0, firstLen);
-    memcpy(in1, first1, firstLen);
-    memcpy(in2, first2, firstLen);
-    memcpy(in3, first3, firstLen);
-    in0 += firstLen;
-    in1 += firstLen;
-    in2 += firstLen;
-    in3 += firstLen;
-    
-    inputLen += firstLen;
-    
-    if (numberOfElements == 3){
-        
-        assert( secondLen <= 2097152 );
-        if (secondLen < 32){
-            *in0++ = 0x01;
-            *in1++ = 0x01;
-            *in2++ = 0x01;
-            *in3++ = 0x01;
-            *in0++ = (uint8_t) (secondLen << 3);
-            *in1++ = (uint8_t) (secondLen << 3);
-            *in2++ = (uint8_t) (secondLen << 3);
-            *in3++ = (uint8_t) (secondLen << 3);
-            inputLen += 2;
-        } else if (secondLen < 8192) {
-            *in0++ = 0x02;
-            *in1++ = 0x02;
-            *in2++ = 0x02;
-            *in3++ = 0x02;
-            *in0++ = (uint8_t) ((secondLen << 3) >> 8);
-            *in1++ = (uint8_t) ((secondLen << 3) >> 8);
-            *in2++ = (uint8_t) ((secondLen << 3) >> 8);
-            *in3++ = (uint8_t) ((secondLen << 3) >> 8);
-            *in0++ = (uint8_t) (secondLen << 3);
-            *in1++ = (uint8_t) (secondLen << 3);
-            *in2++ = (uint8_t) (secondLen << 3);
-            *in3++ = (uint8_t) (secondLen << 3);
-            inputLen += 3;
-        } else {
-            *in0++ = 0x03;
-            *in1++ = 0x03;
-            *in2++ = 0x03;
-            *in3++ = 0x03;
-            *in0++ = (uint8_t) ((secondLen << 3) >> 16);
-            *in1++ = (uint8_t) ((secondLen << 3) >> 16);
-            *in2++ = (uint8_t) ((secondLen << 3) >> 16);
-            *in3++ = (uint8_t) ((secondLen << 3) >> 16);
-            *in0++ = (uint8_t) ((secondLen << 3) >> 8);
-            *in1++ = (uint8_t) ((secondLen << 3) >> 8);
-            *in2++ = (uint8_t) ((secondLen << 3) >> 8);
-            *in3++ = (uint8_t) ((secondLen << 3) >> 8);
-            *in0++ = (uint8_t) (secondLen << 3);
-            *in1++ = (uint8_t) (secondLen << 3);
-            *in2++ = (uint8_t) (secondLen << 3);
-            *in3++ = (uint8_t) (secondLen << 3);
-            inputLen += 4;
+
+    for ( done = 0; done < max; done += c ) {
+        if ( p == RATE ) {
+            KeccakF1600_StatePermute_4x(context->state_4x);
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+            // whole blocks go straight to the lanes that take them
+            for ( i = 0; i < 4 && (len[i] <= done || len[i] - done >= RATE); i++ ) {
+                block[i] = len[i] <= done ? remaining[i] : output[i] + done;
+            }
+            if ( i == 4 ) {
+                KeccakF1600_StateExtractBytes_4x(context->state_4x, block[0], block[1], block[2], block[3] Params);
+                c = RATE;
+                continue;
+            }
+#endif
+            KeccakF1600_StateExtractBytes_4x(context->state_4x, context->remaining0, context->remaining1, context->remaining2, context->remaining3 Params);
+            p = 0;
         }
-        memcpy(in0, second0, secondLen);
-        memcpy(in1, second1, secondLen);
-        memcpy(in2, second2, secondLen);
-        memcpy(in3, second3, secondLen);
-        in0 += secondLen;
-        in1 += secondLen;
-        in2 += secondLen;
-        in3 += secondLen;
-        
-        inputLen += secondLen;
-        
+        c = RATE - p < max - done ? RATE - p : max - done;
+        for ( i = 0; i < 4; i++ ) {
+            if ( done < len[i] ) {
+                memcpy(output[i] + done, remaining[i] + p, len[i] - done < c ? len[i] - done : c);
+            }
+        }
+        p += c;
     }
-    
-    
-    if (outputLenBytes < 32){
-        *in0++ = (uint8_t) (outputLenBytes << 3);
-        *in1++ = (uint8_t) (outputLenBytes << 3);
-        *in2++ = (uint8_t) (outputLenBytes << 3);
-        *in3++ = (uint8_t) (outputLenBytes << 3);
-        *in0++ = 0x01;
-        *in1++ = 0x01;
-        *in2++ = 0x01;
-        *in3++ = 0x01;
-        inputLen += 2;
-        
-    } else  if (outputLenBytes < 8192) {
-        *in0++ = (uint8_t) ((outputLenBytes << 3) >> 8);
-        *in1++ = (uint8_t) ((outputLenBytes << 3) >> 8);
-        *in2++ = (uint8_t) ((outputLenBytes << 3) >> 8);
-        *in3++ = (uint8_t) ((outputLenBytes << 3) >> 8);
-        
-        *in0++ = (uint8_t) (outputLenBytes << 3);
-        *in1++ = (uint8_t) (outputLenBytes << 3);
-        *in2++ = (uint8_t) (outputLenBytes << 3);
-        *in3++ = (uint8_t) (outputLenBytes << 3);
-        
-        *in0++ = 0x02;
-        *in1++ = 0x02;
-        *in2++ = 0x02;
-        *in3++ = 0x02;
-        inputLen += 3;
-        
-    } else {
 
-        *in0++ = (uint8_t) ((outputLenBytes << 3) >> 16);
-        *in1++ = (uint8_t) ((outputLenBytes << 3) >> 16);
-        *in2++ = (uint8_t) ((outputLenBytes << 3) >> 16);
-        *in3++ = (uint8_t) ((outputLenBytes << 3) >> 16);
-        
-        *in0++ = (uint8_t) ((outputLenBytes << 3) >> 8);
-        *in1++ = (uint8_t) ((outputLenBytes << 3) >> 8);
-        *in2++ = (uint8_t) ((outputLenBytes << 3) >> 8);
-        *in3++ = (uint8_t) ((outputLenBytes << 3) >> 8);
-        
-        *in0++ = (uint8_t) (outputLenBytes << 3);
-        *in1++ = (uint8_t) (outputLenBytes << 3);
-        *in2++ = (uint8_t) (outputLenBytes << 3);
-        *in3++ = (uint8_t) (outputLenBytes << 3);
-        
-        *in0++ = 0x03;
-        *in1++ = 0x03;
-        *in2++ = 0x03;
-        *in3++ = 0x03;
-        inputLen += 4;
+    context->index0 = &context->remaining0[p];
+    context->index1 = &context->remaining1[p];
+    context->index2 = &context->remaining2[p];
+    context->index3 = &context->remaining3[p];
+}
+
+// the state of lane i, as a single lane tuplehash ready to be squeezed
+static void tuple_hash_lane_4x
+( THContextInstance dst,
+  const ttupleHash_Instance *src,
+  int i )
+{
+    const uint8_t *remaining[4] = {src->ccontext.remaining0, src->ccontext.remaining1, src->ccontext.remaining2, src->ccontext.remaining3};
+    uint64_t lanes[4];
+
+    for ( int k = 0; k < 25; k++ ) {
+        _mm256_storeu_si256((__m256i *) lanes, src->ccontext.state_4x[k]);
+        dst->ccontext.state[k] = lanes[i];
     }
-    
-    r5_xof_s_input_4x( &THContext->ccontext,
-                    input0, input1, input2, input3, inputLen,
-                    (const uint8_t *)("TupleHash"), 9,
-                    NULL, NULL, NULL, NULL, 0
-                    Params);
-    
-    free(input0);
-    free(input1);
-    free(input2);
-    free(input3);
-    
+    memcpy(dst->ccontext.remaining, remaining[i], RATE);
+    dst->ccontext.index = &dst->ccontext.remaining[src->ccontext.index0 - src->ccontext.remaining0];
+    dst->outputBitLen = 0;
 }
 
 void r5_tuple_hash_xof_squeeze16_4x // tuple_hash_xof_squeeze
@@ -548,6 +682,35 @@ void r5_tuple_hash16_4x
     r5_tuple_hash_xof_squeeze16_4x(output0, output1, output2, output3, outputLen, &thcontext Params);
 }
 
+void r5_tuple_hash_4x
+(uint8_t *output0,
+ uint8_t *output1,
+ uint8_t *output2,
+ uint8_t *output3,
+ uint32_t outputLen,
+ const uint8_t *domain0,
+ const uint8_t *domain1,
+ const uint8_t *domain2,
+ const uint8_t *domain3,
+ uint8_t domainLen,
+ const uint8_t *first0,
+ const uint8_t *first1,
+ const uint8_t *first2,
+ const uint8_t *first3,
+ uint16_t firstLen,
+ const uint8_t *second0,
+ const uint8_t *second1,
+ const uint8_t *second2,
+ const uint8_t *second3,
+ uint32_t secondLen,
+ uint8_t numberOfElements
+ Parameters )
+{
+    ttupleHash_Instance thcontext = {0};
+    r5_tuple_hash_input_4x(&thcontext, domain0, domain1, domain2, domain3, domainLen, first0, first1, first2, first3, firstLen,  second0, second1, second2, second3, secondLen, numberOfElements, outputLen Params);
+    r5_xof_squeeze_4x(&thcontext.ccontext, output0, output1, output2, output3, outputLen Params);
+}
+
 #endif // AVX implementation
 
 
@@ -755,6 +918,156 @@ void r5_xof_s16 // cshake16 with N = NULL
 
 /********** tuplehash ****************/
 
+// absorbs bytes into the state; index marks the first free byte of the
+// partial block in remaining
+static void tuple_hash_absorb_bytes
+( THContextInstance tinstance,
+ const uint8_t *input, size_t inputLength
+ Parameters )
+{
+    Context context = &tinstance->ccontext;
+    size_t n = (size_t) (context->index - context->remaining);
+    size_t t;
+
+    while ( n + inputLength >= RATE ) {
+        if ( n == 0 ) {
+            KeccakF1600_StateXORBytes(context->state, input Params);
+            t = RATE;
+        } else {
+            t = RATE - n;
+            memcpy(&context->remaining[n], input, t);
+            KeccakF1600_StateXORBytes(context->state, context->remaining Params);
+            n = 0;
+        }
+        KeccakF1600_StatePermute(context->state);
+        input += t;
+        inputLength -= t;
+    }
+    memcpy(&context->remaining[n], input, inputLength);
+    context->index = &context->remaining[n + inputLength];
+}
+
+// left_encode (right == 0) or right_encode (right == 1) of x
+static void tuple_hash_absorb_encode
+( THContextInstance tinstance, uint64_t x, int right Parameters )
+{
+    uint8_t buf[10];
+    uint8_t n = 0;
+
+    do {
+        n++;
+    } while ( n < 8 && (x >> (8 * n)) != 0 );
+    for ( uint8_t i = 0; i < n; i++ ) {
+        buf[1 + i] = (uint8_t) (x >> (8 * (n - 1 - i)));
+    }
+    buf[0] = n;
+    buf[1 + n] = n;
+
+    tuple_hash_absorb_bytes(tinstance, &buf[right], (size_t) n + 1 Params);
+}
+
+// cSHAKE header: bytepad(encode_string("TupleHash") || encode_string(""), rate)
+static void tuple_hash_header
+( THContextInstance tinstance
+  Parameters )
+{
+    Context context = &tinstance->ccontext;
+    uint8_t *in = context->remaining;
+
+    memset(context->state, 0, sizeof (context->state));
+    memset(in, 0, RATE);
+    *in++ = 0x01; *in++ = RATE;
+    *in++ = 0x01; *in++ = 9 << 3;
+    memcpy(in, "TupleHash", 9);
+    in += 9;
+    *in++ = 0x01; *in++ = 0x00;
+    KeccakF1600_StateXORBytes(context->state, context->remaining Params);
+    KeccakF1600_StatePermute(context->state);
+
+    context->index = context->remaining;
+}
+
+// right_encode(L), then the cSHAKE padding; the state is ready to be squeezed
+static void tuple_hash_pad
+( THContextInstance tinstance,
+  uint32_t outputLenBytes
+  Parameters )
+{
+    Context context = &tinstance->ccontext;
+    size_t n;
+
+    tuple_hash_absorb_encode(tinstance, 8 * (uint64_t) outputLenBytes, 1 Params);
+
+    n = (size_t) (context->index - context->remaining);
+    memset(&context->remaining[n], 0x00, RATE - n);
+    context->remaining[n] = 0x04;
+    context->remaining[RATE - 1] |= 0x80;
+    KeccakF1600_StateXORBytes(context->state, context->remaining Params );
+
+    context->index = &(context->remaining[RATE]);
+}
+
+void r5_tuple_hash_init
+( THContextInstance tinstance,
+  uint32_t outputLenBytes
+  Parameters )
+{
+    tuple_hash_header(tinstance Params);
+    tinstance->outputBitLen = (uint16_t) (8 * outputLenBytes);
+}
+
+void r5_tuple_hash_absorb
+( THContextInstance tinstance,
+  const uint8_t *element, uint32_t elementLen
+  Parameters )
+{
+    // encode_string(X) = left_encode(|X|) || X
+    tuple_hash_absorb_encode(tinstance, 8 * (uint64_t) elementLen, 0 Params);
+    tuple_hash_absorb_bytes(tinstance, element, elementLen Params);
+}
+
+void r5_tuple_hash_final
+( THContextInstance tinstance,
+  uint8_t *output
+  Parameters )
+{
+    tuple_hash_pad(tinstance, tinstance->outputBitLen / 8 Params);
+    r5_xof_squeeze(&tinstance->ccontext, output, tinstance->outputBitLen / 8 Params);
+}
+
+void r5_tuple_hash_snapshot
+( tupleHash_Snapshot *dst,
+  const ttupleHash_Instance *src )
+{
+    size_t n = (size_t) (src->ccontext.index - src->ccontext.remaining);
+
+    memcpy(dst->state, src->ccontext.state, sizeof (dst->state));
+    memcpy(dst->remaining, src->ccontext.remaining, n);
+    dst->remainingLen = (uint16_t) n;
+    dst->outputBitLen = src->outputBitLen;
+}
+
+void r5_tuple_hash_restore
+( THContextInstance dst,
+  const tupleHash_Snapshot *src )
+{
+    memcpy(dst->ccontext.state, src->state, sizeof (src->state));
+    memcpy(dst->ccontext.remaining, src->remaining, src->remainingLen);
+    dst->ccontext.index = &dst->ccontext.remaining[src->remainingLen];
+    dst->outputBitLen = src->outputBitLen;
+}
+
+void r5_tuple_hash_xof_input_prefixed
+( THContextInstance tinstance,
+  const tupleHash_Snapshot *prefix,
+  const uint8_t *second, uint32_t secondLen
+  Parameters )
+{
+    r5_tuple_hash_restore(tinstance, prefix);
+    r5_tuple_hash_absorb(tinstance, second, secondLen Params);
+    tuple_hash_pad(tinstance, 0 Params);
+}
+
 void r5_tuple_hash_input // tuple_hash_input for tuple with up to three strings 
 ( THContextInstance tinstance,
  const uint8_t *domain, uint8_t domainLen,
@@ -764,93 +1077,13 @@ void r5_tuple_hash_input // tuple_hash_input for tuple with up to three strings
  uint32_t outputLenBytes
  Parameters )
 {
-    // ToDo: this memory overhead goes away by absorbing the input into the state
-    uint8_t *inputbuff;
-    inputbuff = checked_malloc(14 + domainLen + firstLen + secondLen);
-    
-    uint8_t *in = inputbuff;
-    uint32_t inputLen = 0;
-    
-    *in++ = 0x01;
-    assert( domainLen < 32 );
-    *in++ = (uint8_t) (domainLen << 3);
-    memcpy(in, domain, domainLen);
-    in += domainLen;
-    
-    inputLen = 2 + domainLen;
-    
-    assert( firstLen <= 8192 );
-    if (firstLen < 32){
-        *in++ = 0x01;
-        *in++ = (uint8_t) (firstLen << 3);
-        inputLen += 2;
-    } else {
-        *in++ = 0x02;
-        *in++ = (uint8_t) ((firstLen << 3) >> 8);
-        *in++ = (uint8_t) (firstLen << 3);
-        inputLen += 3;
-    }
-    memcpy(in, first, firstLen);
-    in += firstLen;
-    inputLen += firstLen;
-    
+    tuple_hash_header(tinstance Params);
+    r5_tuple_hash_absorb(tinstance, domain, domainLen Params);
+    r5_tuple_hash_absorb(tinstance, first, firstLen Params);
     if (numberOfElements == 3){
-    
-    assert( secondLen <= 2097152 );
-    if (secondLen < 32){
-        *in++ = 0x01;
-        *in++ = (uint8_t) (secondLen << 3);
-        inputLen += 2;
-    } else if (secondLen < 8192) {
-        *in++ = 0x02;
-        *in++ = (uint8_t) ((secondLen << 3) >> 8);
-        *in++ = (uint8_t) (secondLen << 3);
-        inputLen += 3;
-    } else {
-        *in++ = 0x03;
-        *in++ = (uint8_t) ((secondLen << 3) >> 16);
-        *in++ = (uint8_t) ((secondLen << 3) >> 8);
-        *in++ = (uint8_t) (secondLen << 3);
-        inputLen += 4;
-    }
-    memcpy(in, second, secondLen);
-    in += secondLen;
-    inputLen += secondLen;
-
-    }
-    
-    // right encoding of output bytes. If xof, it is always zero.
-    //*in++ = 0x00;
-    //*in++ = 0x01;
-    //inputLen += 2;
-
-    if (outputLenBytes < 32){
-        *in++ = (uint8_t) (outputLenBytes << 3);
-        
-        *in++ = 0x01;
-        inputLen += 2;
-    } else if (outputLenBytes < 8192) {
-        *in++ = (uint8_t) ((outputLenBytes << 3) >> 8);
-        *in++ = (uint8_t) (outputLenBytes << 3);
-        
-        *in++ = 0x02;
-        inputLen += 3;
-    } else {
-        *in++ = (uint8_t) ((outputLenBytes << 3) >> 16);
-        *in++ = (uint8_t) ((outputLenBytes << 3) >> 8);
-        *in++ = (uint8_t) (outputLenBytes << 3);
-        
-        inputLen += 4;
-        *in++ = 0x03;
+        r5_tuple_hash_absorb(tinstance, second, secondLen Params);
     }
-    
-    r5_xof_s_input( &tinstance->ccontext,
-                    inputbuff, inputLen,
-                    (const uint8_t *)("TupleHash"), 9,
-                    NULL, 0
-                    Params);
-    free(inputbuff);
-    
+    tuple_hash_pad(tinstance, outputLenBytes Params);
 }
 
 void r5_tuple_hash_xof_squeeze // tuple_hash_xof_squeeze
@@ -1228,9 +1461,243 @@ void r5_tuple_hash_xof_squeeze16 // tuple_hash_xof_squeeze
     
 }
 
+void r5_tuple_hash_init
+( THContextInstance tinstance,
+  uint32_t outputLenBytes
+  Parameters )
+{
+    if (PARAMS_KAPPA_BYTES > 16) {
+        failsafe( TupleHash256_Initialize(tinstance, 8*outputLenBytes, NULL, 0) );
+    }
+    else {
+        failsafe( TupleHash128_Initialize(tinstance, 8*outputLenBytes, NULL, 0) );
+    }
+}
+
+void r5_tuple_hash_absorb
+( THContextInstance tinstance,
+  const uint8_t *element, uint32_t elementLen
+  Parameters )
+{
+    const TupleElement tupleinput[1] = {{element, 8*elementLen}};
+
+    if (PARAMS_KAPPA_BYTES > 16) {
+        failsafe( TupleHash256_Update(tinstance, tupleinput, 1) );
+    }
+    else {
+        failsafe( TupleHash128_Update(tinstance, tupleinput, 1) );
+    }
+}
+
+void r5_tuple_hash_final
+( THContextInstance tinstance,
+  uint8_t *output
+  Parameters )
+{
+    if (PARAMS_KAPPA_BYTES > 16) {
+        failsafe( TupleHash256_Final(tinstance, output) );
+    }
+    else {
+        failsafe( TupleHash128_Final(tinstance, output) );
+    }
+}
+
+void r5_tuple_hash_snapshot
+( tupleHash_Snapshot *dst,
+  const ttupleHash_Instance *src )
+{
+    *dst = *src;
+}
+
+void r5_tuple_hash_restore
+( THContextInstance dst,
+  const tupleHash_Snapshot *src )
+{
+    *dst = *src;
+}
+
+void r5_tuple_hash_xof_input_prefixed
+( THContextInstance tinstance,
+  const tupleHash_Snapshot *prefix,
+  const uint8_t *second, uint32_t secondLen
+  Parameters )
+{
+    const TupleElement tupleinput[1] = {{second, 8*secondLen}};
+
+    *tinstance = *prefix;
+    if (PARAMS_KAPPA_BYTES > 16) {
+        failsafe( TupleHash256_Update(tinstance, tupleinput, 1) );
+        failsafe( TupleHash256_Final(tinstance, NULL) );
+    }
+    else {
+        failsafe( TupleHash128_Update(tinstance, tupleinput, 1) );
+        failsafe( TupleHash128_Final(tinstance, NULL) );
+    }
+}
+
 #define freeContext(context)
 
 #endif
 
 
 
+
+/**************** tuplehash jobs ********************************/
+
+void r5_tuple_hash_prefix
+( tupleHash_Snapshot *prefix,
+  const uint8_t *domain, uint8_t domainLen,
+  const uint8_t *first, uint16_t firstLen
+  Parameters )
+{
+    ttupleHash_Instance thcontext;
+
+    r5_tuple_hash_init(&thcontext, 0 Params);
+    r5_tuple_hash_absorb(&thcontext, domain, domainLen Params);
+    r5_tuple_hash_absorb(&thcontext, first, firstLen Params);
+    r5_tuple_hash_snapshot(prefix, &thcontext);
+}
+
+#ifdef STANDALONE
+
+// the output length in bytes that is absorbed, 0 for an xof
+static uint64_t tuple_hash16_job_length(const tupleHash16_Job *job)
+{
+    return job->xof ? 0 : 2 * (uint64_t) job->outputLen;
+}
+
+#endif
+
+// runs a job on its own
+static void tuple_hash16_job
+( tupleHash16_Job *job
+  Parameters )
+{
+    ttupleHash_Instance thcontext = {0};
+    THContextInstance tinstance = job->rest != NULL ? job->rest : &thcontext;
+
+#ifdef STANDALONE
+    if ( job->prefix != NULL ) {
+        r5_tuple_hash_restore(tinstance, job->prefix);
+        if ( job->numberOfElements == 3 ) {
+            r5_tuple_hash_absorb(tinstance, job->second, job->secondLen Params);
+        }
+        tuple_hash_pad(tinstance, (uint32_t) tuple_hash16_job_length(job) Params);
+        r5_tuple_hash_xof_squeeze16(job->output, job->outputLen, tinstance Params);
+        return;
+    }
+#endif
+
+    if ( job->xof ) {
+        r5_tuple_hash_input(tinstance, job->domain, job->domainLen, job->first, job->firstLen,
+                            job->second, job->secondLen, job->numberOfElements, 0 Params);
+        r5_tuple_hash_xof_squeeze16(job->output, job->outputLen, tinstance Params);
+    } else {
+        r5_tuple_hash16(job->output, job->outputLen, job->domain, job->domainLen, job->first, job->firstLen,
+                        job->second, job->secondLen, job->numberOfElements Params);
+    }
+}
+
+#ifdef AVX2SHAKE
+
+// whether two jobs can share a 4x state: they have the same prefix, their
+// tuples have the same lengths, and so have the right_encode of their
+// output lengths
+static int tuple_hash16_jobs_match(const tupleHash16_Job *a, const tupleHash16_Job *b)
+{
+    return a->prefix == b->prefix &&
+           a->numberOfElements == b->numberOfElements &&
+           a->domainLen == b->domainLen &&
+           a->firstLen == b->firstLen &&
+           (a->numberOfElements != 3 || a->secondLen == b->secondLen) &&
+           tuple_hash_encode_length(8 * tuple_hash16_job_length(a)) == tuple_hash_encode_length(8 * tuple_hash16_job_length(b));
+}
+
+// runs two to four matching jobs, one per lane; the lanes left over hash the
+// tuple of the first job and squeeze nothing
+static void tuple_hash16_jobs_4x
+( tupleHash16_Job *job[4], int n
+  Parameters )
+{
+    ttupleHash_Instance thcontext;
+    const tupleHash16_Job *lane[4];
+    uint64_t outputLenBytes[4];
+    uint8_t *output[4];
+    size_t len[4];
+    int i;
+
+    for ( i = 0; i < 4; i++ ) {
+        lane[i] = job[i < n ? i : 0];
+        outputLenBytes[i] = tuple_hash16_job_length(lane[i]);
+        output[i] = (uint8_t *) lane[i]->output;
+        len[i] = i < n ? 2 * (size_t) lane[i]->outputLen : 0;
+    }
+
+    if ( lane[0]->prefix != NULL ) {
+        // only the last element is left
+        tuple_hash_prefix_4x(&thcontext, lane[0]->prefix);
+        if ( lane[0]->numberOfElements == 3 ) {
+            tuple_hash_absorb_encode_4x(&thcontext, 8 * (uint64_t) lane[0]->secondLen, 0 Params);
+            tuple_hash_absorb_bytes_4x(&thcontext, lane[0]->second, lane[1]->second, lane[2]->second, lane[3]->second, lane[0]->secondLen Params);
+        }
+        tuple_hash_pad_lanes_4x(&thcontext, outputLenBytes Params);
+    } else {
+        tuple_hash_input_lanes_4x(&thcontext,
+                                  lane[0]->domain, lane[1]->domain, lane[2]->domain, lane[3]->domain, lane[0]->domainLen,
+                                  lane[0]->first, lane[1]->first, lane[2]->first, lane[3]->first, lane[0]->firstLen,
+                                  lane[0]->second, lane[1]->second, lane[2]->second, lane[3]->second, lane[0]->secondLen,
+                                  lane[0]->numberOfElements, outputLenBytes Params);
+    }
+    tuple_hash_squeeze_lanes_4x(&thcontext.ccontext, output, len Params);
+
+    for ( i = 0; i < n; i++ ) {
+#if __BYTE_ORDER__ != __ORDER_LITTLE_ENDIAN__
+        for ( size_t k = 0; k < len[i]; k += 2 ) {
+            uint8_t h = output[i][k]; output[i][k] = output[i][k + 1]; output[i][k + 1] = h;
+        }
+#endif
+        if ( job[i]->xof && job[i]->rest != NULL ) {
+            tuple_hash_lane_4x(job[i]->rest, &thcontext, i);
+        }
+    }
+}
+
+#endif
+
+void r5_tuple_hash16_jobs
+( tupleHash16_Job *jobs, size_t n
+  Parameters )
+{
+#ifdef AVX2SHAKE
+    tupleHash16_Job *group[4];
+    uint64_t todo;
+    size_t w, m, i, j;
+    int k;
+
+    // matching jobs are looked for among 64 at a time
+    for ( w = 0; w < n; w += m ) {
+        m = n - w < 64 ? n - w : 64;
+        todo = m == 64 ? ~(uint64_t) 0 : ((uint64_t) 1 << m) - 1;
+        for ( i = 0; i < m; i++ ) {
+            if ( ((todo >> i) & 1) == 0 ) {
+                continue;
+            }
+            for ( j = i, k = 0; j < m && k < 4; j++ ) {
+                if ( ((todo >> j) & 1) && tuple_hash16_jobs_match(&jobs[w + i], &jobs[w + j]) ) {
+                    group[k++] = &jobs[w + j];
+                    todo &= ~((uint64_t) 1 << j);
+                }
+            }
+            if ( k == 1 ) {
+                tuple_hash16_job(group[0] Params);
+            } else {
+                tuple_hash16_jobs_4x(group, k Params);
+            }
+        }
+    }
+#else
+    for ( size_t i = 0; i < n; i++ ) {
+        tuple_hash16_job(&jobs[i] Params);
+    }
+#endif
+}
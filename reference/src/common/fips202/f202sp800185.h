@@ -70,6 +70,14 @@ typedef struct tupleHash_Instance *TupleHash_Instance;
 
 typedef struct tupleHash_Instance *THContextInstance;
 
+// a tuplehash state part way through absorbing, without the 4x buffers
+typedef struct {
+    uint64_t state[25];
+    uint8_t  remaining[168];  // absorbed bytes of the partial block
+    uint16_t remainingLen;
+    uint16_t outputBitLen;
+} tupleHash_Snapshot;
+
 #else // !STANDALONE
 
 #include <libkeccak.a.headers/KeccakHash.h>
@@ -83,6 +91,8 @@ typedef cSHAKE_Instance *CContext;
 typedef TupleHash_Instance ttupleHash_Instance;
 typedef TupleHash_Instance *THContextInstance;
 
+typedef TupleHash_Instance tupleHash_Snapshot;
+
 
 
 #endif
@@ -204,8 +214,105 @@ extern void r5_tuple_hash_xof_squeeze16
  THContextInstance tinstance
  Parameters );
 
+// incremental tuplehash, with fixed output length (up to 8191 bytes):
+// init, absorb each element of the tuple, final. A state can be saved part
+// way and restored, to hash several tuples that share their first elements.
+
+extern void r5_tuple_hash_init
+( THContextInstance tinstance,
+  uint32_t outputLenBytes
+  Parameters );
+
+extern void r5_tuple_hash_absorb
+( THContextInstance tinstance,
+  const uint8_t *element, uint32_t elementLen
+  Parameters );
+
+extern void r5_tuple_hash_final
+( THContextInstance tinstance,
+  uint8_t *output
+  Parameters );
+
+extern void r5_tuple_hash_snapshot
+( tupleHash_Snapshot *dst,
+  const ttupleHash_Instance *src );
+
+extern void r5_tuple_hash_restore
+( THContextInstance dst,
+  const tupleHash_Snapshot *src );
+
+// the state after the first two elements (domain, first) of tuples that
+// only differ in the last one, to absorb them once for all those tuples
+
+extern void r5_tuple_hash_prefix
+( tupleHash_Snapshot *prefix,
+  const uint8_t *domain, uint8_t domainLen,
+  const uint8_t *first, uint16_t firstLen
+  Parameters );
+
+// r5_tuple_hash_input with outputLenBytes 0 (xof) of the tuple
+// (domain, first, second), from the prefix of (domain, first)
+
+extern void r5_tuple_hash_xof_input_prefixed
+( THContextInstance tinstance,
+  const tupleHash_Snapshot *prefix,
+  const uint8_t *second, uint32_t secondLen
+  Parameters );
+
+// a tuplehash of 16-bit output elements, to be run with other independent
+// ones by r5_tuple_hash16_jobs: tuplehash16 of (domain, first [, second]),
+// or tuplehash_xof16 if xof is set. The state of an xof job after its
+// output can be kept in rest, to squeeze more from it with
+// r5_tuple_hash_xof_squeeze16. With a prefix of (domain, first), only
+// second is absorbed.
+
+typedef struct {
+    uint16_t *output;
+    uint32_t outputLen;
+    const uint8_t *domain;
+    uint8_t domainLen;
+    const uint8_t *first;
+    uint16_t firstLen;
+    const uint8_t *second;
+    uint32_t secondLen;
+    uint8_t numberOfElements;
+    uint8_t xof;
+    ttupleHash_Instance *rest;  // NULL, or receives the state of an xof job
+    const tupleHash_Snapshot *prefix;  // NULL, or from r5_tuple_hash_prefix
+} tupleHash16_Job;
+
+// runs the jobs, in any order; with AVX2, four at a time where the lengths
+// of their tuples, and their prefixes, are the same
+extern void r5_tuple_hash16_jobs
+( tupleHash16_Job *jobs, size_t n
+  Parameters );
+
 #ifdef AVX2SHAKE
 
+void r5_tuple_hash_4x
+(uint8_t *output0,
+ uint8_t *output1,
+ uint8_t *output2,
+ uint8_t *output3,
+ uint32_t outputLen,
+ const uint8_t *domain0,
+ const uint8_t *domain1,
+ const uint8_t *domain2,
+ const uint8_t *domain3,
+ uint8_t domainLen,
+ const uint8_t *first0,
+ const uint8_t *first1,
+ const uint8_t *first2,
+ const uint8_t *first3,
+ uint16_t firstLen,
+ const uint8_t *second0,
+ const uint8_t *second1,
+ const uint8_t *second2,
+ const uint8_t *second3,
+ uint32_t secondLen,
+ uint8_t numberOfElements
+ Parameters );
+
 void r5_tuple_hash16_4x
 (uint16_t *output0,
  uint16_t *output1,
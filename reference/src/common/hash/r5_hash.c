@@ -47,3 +47,101 @@ inline void HashR5DEM
     const uint8_t d[6] = "HR5DEM";
     r5_tuple_hash(output, outputLength, d, 6, firstInput, firstInputLength, NULL, 0, 2 Params);
 }
+
+static void hash_prefix
+(r5_hash_prefix *prefix, uint32_t outputLength,
+ const uint8_t d[7]
+ Parameters )
+{
+    ttupleHash_Instance t;
+
+    r5_tuple_hash_init(&t, outputLength Params);
+    r5_tuple_hash_absorb(&t, d, 7 Params);
+    r5_tuple_hash_snapshot(prefix, &t);
+}
+
+void HCCAKEM_prefix
+(r5_hash_prefix *prefix, uint32_t outputLength
+ Parameters )
+    {
+        const uint8_t d[7] = "HCCAKEM";
+        hash_prefix(prefix, outputLength, d Params);
+    }
+
+void GCCAKEM_prefix
+(r5_hash_prefix *prefix, uint32_t outputLength
+ Parameters )
+    {
+        const uint8_t d[7] = "GCCAKEM";
+        hash_prefix(prefix, outputLength, d Params);
+    }
+
+void r5_hash_prefixed
+(uint8_t *output, const r5_hash_prefix *prefix,
+ const uint8_t *firstInput, uint16_t firstInputLength,
+ const uint8_t *secondInput, uint32_t secondInputLength
+ Parameters )
+{
+    ttupleHash_Instance t;
+
+    r5_tuple_hash_restore(&t, prefix);
+    r5_tuple_hash_absorb(&t, firstInput, firstInputLength Params);
+    r5_tuple_hash_absorb(&t, secondInput, secondInputLength Params);
+    r5_tuple_hash_final(&t, output Params);
+}
+
+static void tuple_hash_4x
+(const uint8_t d[7],
+ uint8_t *output0, uint8_t *output1, uint8_t *output2, uint8_t *output3, uint32_t outputLength,
+ const uint8_t *firstInput0, const uint8_t *firstInput1, const uint8_t *firstInput2, const uint8_t *firstInput3, uint16_t firstInputLength,
+ const uint8_t *secondInput0, const uint8_t *secondInput1, const uint8_t *secondInput2, const uint8_t *secondInput3, uint32_t secondInputLength
+ Parameters )
+{
+#ifdef AVX2SHAKE
+    r5_tuple_hash_4x(output0, output1, output2, output3, outputLength,
+                     d, d, d, d, 7,
+                     firstInput0, firstInput1, firstInput2, firstInput3, firstInputLength,
+                     secondInput0, secondInput1, secondInput2, secondInput3, secondInputLength, 3 Params);
+#else
+    r5_tuple_hash(output0, outputLength, d, 7, firstInput0, firstInputLength, secondInput0, secondInputLength, 3 Params);
+    r5_tuple_hash(output1, outputLength, d, 7, firstInput1, firstInputLength, secondInput1, secondInputLength, 3 Params);
+    r5_tuple_hash(output2, outputLength, d, 7, firstInput2, firstInputLength, secondInput2, secondInputLength, 3 Params);
+    r5_tuple_hash(output3, outputLength, d, 7, firstInput3, firstInputLength, secondInput3, secondInputLength, 3 Params);
+#endif
+}
+
+void HCPAKEM_4x
+(uint8_t *output0, uint8_t *output1, uint8_t *output2, uint8_t *output3, uint32_t outputLength,
+ const uint8_t *firstInput0, const uint8_t *firstInput1, const uint8_t *firstInput2, const uint8_t *firstInput3, uint16_t firstInputLength,
+ const uint8_t *secondInput0, const uint8_t *secondInput1, const uint8_t *secondInput2, const uint8_t *secondInput3, uint32_t secondInputLength
+ Parameters )
+    {
+        const uint8_t d[7] = "HCPAKEM";
+        tuple_hash_4x(d, output0, output1, output2, output3, outputLength,
+                      firstInput0, firstInput1, firstInput2, firstInput3, firstInputLength,
+                      secondInput0, secondInput1, secondInput2, secondInput3, secondInputLength Params);
+    }
+
+void HCCAKEM_4x
+(uint8_t *output0, uint8_t *output1, uint8_t *output2, uint8_t *output3, uint32_t outputLength,
+ const uint8_t *firstInput0, const uint8_t *firstInput1, const uint8_t *firstInput2, const uint8_t *firstInput3, uint16_t firstInputLength,
+ const uint8_t *secondInput0, const uint8_t *secondInput1, const uint8_t *secondInput2, const uint8_t *secondInput3, uint32_t secondInputLength
+ Parameters )
+    {
+        const uint8_t d[7] = "HCCAKEM";
+        tuple_hash_4x(d, output0, output1, output2, output3, outputLength,
+                      firstInput0, firstInput1, firstInput2, firstInput3, firstInputLength,
+                      secondInput0, secondInput1, secondInput2, secondInput3, secondInputLength Params);
+    }
+
+void GCCAKEM_4x
+(uint8_t *output0, uint8_t *output1, uint8_t *output2, uint8_t *output3, uint32_t outputLength,
+ const uint8_t *firstInput0, const uint8_t *firstInput1, const uint8_t *firstInput2, const uint8_t *firstInput3, uint16_t firstInputLength,
+ const uint8_t *secondInput0, const uint8_t *secondInput1, const uint8_t *secondInput2, const uint8_t *secondInput3, uint32_t secondInputLength
+ Parameters )
+    {
+        const uint8_t d[7] = "GCCAKEM";
+        tuple_hash_4x(d, output0, output1, output2, output3, outputLength,
+                      firstInput0, firstInput1, firstInput2, firstInput3, firstInputLength,
+                      secondInput0, secondInput1, secondInput2, secondInput3, secondInputLength Params);
+    }
@@ -34,6 +34,52 @@ extern void GCCAKEM
      const uint8_t *secondInput, uint32_t secondInputLength
      Parameters );
 
+/*
+ * The same hash functions, on four independent inputs at once. With AVX2
+ * (STANDALONE) they run in the four lanes of the 4x Keccak permutation,
+ * otherwise they are computed one after the other.
+ */
+
+extern void HCPAKEM_4x
+    ( uint8_t *output0, uint8_t *output1, uint8_t *output2, uint8_t *output3, uint32_t outputLength,
+     const uint8_t *firstInput0, const uint8_t *firstInput1, const uint8_t *firstInput2, const uint8_t *firstInput3, uint16_t firstInputLength,
+     const uint8_t *secondInput0, const uint8_t *secondInput1, const uint8_t *secondInput2, const uint8_t *secondInput3, uint32_t secondInputLength
+     Parameters );
+
+extern void HCCAKEM_4x
+    ( uint8_t *output0, uint8_t *output1, uint8_t *output2, uint8_t *output3, uint32_t outputLength,
+     const uint8_t *firstInput0, const uint8_t *firstInput1, const uint8_t *firstInput2, const uint8_t *firstInput3, uint16_t firstInputLength,
+     const uint8_t *secondInput0, const uint8_t *secondInput1, const uint8_t *secondInput2, const uint8_t *secondInput3, uint32_t secondInputLength
+     Parameters );
+
+extern void GCCAKEM_4x
+    ( uint8_t *output0, uint8_t *output1, uint8_t *output2, uint8_t *output3, uint32_t outputLength,
+     const uint8_t *firstInput0, const uint8_t *firstInput1, const uint8_t *firstInput2, const uint8_t *firstInput3, uint16_t firstInputLength,
+     const uint8_t *secondInput0, const uint8_t *secondInput1, const uint8_t *secondInput2, const uint8_t *secondInput3, uint32_t secondInputLength
+     Parameters );
+
+/*
+ * Hash state with the domain of GCCAKEM or HCCAKEM already absorbed, for a
+ * given output length. It does not depend on the inputs, so it can be set
+ * up once and used for any number of hashes: r5_hash_prefixed() works on a
+ * copy and leaves it as it is.
+ */
+typedef tupleHash_Snapshot r5_hash_prefix;
+
+extern void HCCAKEM_prefix
+    ( r5_hash_prefix *prefix, uint32_t outputLength
+     Parameters );
+
+extern void GCCAKEM_prefix
+    ( r5_hash_prefix *prefix, uint32_t outputLength
+     Parameters );
+
+extern void r5_hash_prefixed
+    ( uint8_t *output, const r5_hash_prefix *prefix,
+     const uint8_t *firstInput, uint16_t firstInputLength,
+     const uint8_t *secondInput, uint32_t secondInputLength
+     Parameters );
+
 extern void HashR5DEM
     ( uint8_t *output, uint32_t outputLength,
      const uint8_t *firstInput, uint16_t firstInputLength
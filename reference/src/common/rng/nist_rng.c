@@ -43,7 +43,8 @@ AES256_CTR_DRBG_Update(unsigned char *provided_data, unsigned char *Key, unsigne
 #include <openssl/evp.h>
 #include <openssl/err.h>
 
-AES256_CTR_DRBG_struct DRBG_ctx;
+/* the state of randombytes() */
+static randombytes_state DRBG_ctx;
 
 void AES256_ECB(unsigned char *key, unsigned char *ctr, unsigned char *buffer);
 
@@ -164,37 +165,42 @@ AES256_ECB(unsigned char *key, unsigned char *ctr, unsigned char *buffer) {
 }
 
 void
-randombytes_init(unsigned char *entropy_input,
+randombytes_init_state(randombytes_state *state,
+        unsigned char *entropy_input,
         unsigned char *personalization_string,
         int security_strength) {
     unsigned char seed_material[48];
 
-    memcpy(seed_material, entropy_input, 48);
+    if (entropy_input)
+        memcpy(seed_material, entropy_input, 48);
+    else
+        memset(seed_material, 0x00, 48);
     if (personalization_string)
         for (int i = 0; i < 48; i++)
             seed_material[i] ^= personalization_string[i];
-    memset(DRBG_ctx.Key, 0x00, 32);
-    memset(DRBG_ctx.V, 0x00, 16);
-    AES256_CTR_DRBG_Update(seed_material, DRBG_ctx.Key, DRBG_ctx.V);
-    DRBG_ctx.reseed_counter = 1;
+    memset(state->key, 0x00, 32);
+    memset(state->v, 0x00, 16);
+    AES256_CTR_DRBG_Update(seed_material, state->key, state->v);
+    state->reseed_counter = 1;
+    state->fd = -1;
 }
 
 int
-randombytes(unsigned char *x, unsigned long long xlen) {
+randombytes_with_state(randombytes_state *state, unsigned char *x, unsigned long long xlen) {
     unsigned char block[16];
     int i = 0;
 
     while (xlen > 0) {
         //increment V
         for (int j = 15; j >= 0; j--) {
-            if (DRBG_ctx.V[j] == 0xff)
-                DRBG_ctx.V[j] = 0x00;
+            if (state->v[j] == 0xff)
+                state->v[j] = 0x00;
             else {
-                DRBG_ctx.V[j]++;
+                state->v[j]++;
                 break;
             }
         }
-        AES256_ECB(DRBG_ctx.Key, DRBG_ctx.V, block);
+        AES256_ECB(state->key, state->v, block);
         if (xlen > 15) {
             memcpy(x + i, block, 16);
             i += 16;
@@ -204,12 +210,30 @@ randombytes(unsigned char *x, unsigned long long xlen) {
             xlen = 0;
         }
     }
-    AES256_CTR_DRBG_Update(NULL, DRBG_ctx.Key, DRBG_ctx.V);
-    DRBG_ctx.reseed_counter++;
+    AES256_CTR_DRBG_Update(NULL, state->key, state->v);
+    state->reseed_counter++;
 
     return RNG_SUCCESS;
 }
 
+void
+randombytes_clear_state(randombytes_state *state) {
+    memset(state, 0x00, sizeof (*state));
+    state->fd = -1;
+}
+
+void
+randombytes_init(unsigned char *entropy_input,
+        unsigned char *personalization_string,
+        int security_strength) {
+    randombytes_init_state(&DRBG_ctx, entropy_input, personalization_string, security_strength);
+}
+
+int
+randombytes(unsigned char *x, unsigned long long xlen) {
+    return randombytes_with_state(&DRBG_ctx, x, xlen);
+}
+
 void
 AES256_CTR_DRBG_Update(unsigned char *provided_data,
         unsigned char *Key,
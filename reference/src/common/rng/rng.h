@@ -33,6 +33,47 @@ extern "C" {
      */
     int randombytes(unsigned char *x, unsigned long long xlen);
 
+    /**
+     * The state of a random bytes generator of its own, for generating
+     * random bytes without the global state of randombytes() (e.g. one per
+     * thread). Only the fields of the generator that is linked in are used.
+     */
+    typedef struct {
+        int fd; /**< The file descriptor of /dev/urandom (true_rng.c) */
+        unsigned char key[32]; /**< The key of the AES-256 CTR DRBG (nist_rng.c) */
+        unsigned char v[16]; /**< The counter of the AES-256 CTR DRBG (nist_rng.c) */
+        int reseed_counter; /**< The number of requests to the DRBG (nist_rng.c) */
+    } randombytes_state;
+
+    /**
+     * Initializes the state of a random bytes generator, as randombytes_init()
+     * does the global one.
+     *
+     * @param[out] state the state to initialize
+     * @param[in] entropy_input the bytes to use as input entropy (48 bytes), `NULL` for all zero
+     * @param[in] personalization_string an optional personalization string (48 bytes)
+     * @param[in] security_strength parameter to specify the security strength of the random bytes
+     */
+    void randombytes_init_state(randombytes_state *state, unsigned char *entropy_input, unsigned char *personalization_string, int security_strength);
+
+    /**
+     * Generates a sequence of random bytes with the given state.
+     *
+     * @param[in,out] state the state initialized by randombytes_init_state()
+     * @param[out] x destination of the random bytes
+     * @param[in] xlen the number of random bytes
+     * @return _0_ in case of success, non-zero otherwise
+     */
+    int randombytes_with_state(randombytes_state *state, unsigned char *x, unsigned long long xlen);
+
+    /**
+     * Releases the resources of the state of a random bytes generator and
+     * clears it.
+     *
+     * @param[in,out] state the state initialized by randombytes_init_state()
+     */
+    void randombytes_clear_state(randombytes_state *state);
+
 #ifdef __cplusplus
 }
 #endif
@@ -19,32 +19,28 @@
 /** Read the random bytes from /dev/urandom in blocks of 1MB (max). */
 #define MAX_URANDOM_BLOCK_SIZE 1048576
 
-/** The file descriptor of /dev/urandom, -1 means uninitialised  */
-/** Can be adapted to avoid usage of global variable */
-static int urandom_r5_file_descriptor = -1;
+/** The state of randombytes(), fd -1 means uninitialised */
+static randombytes_state global_state = { .fd = -1 };
 
-void randombytes_init(unsigned char *entropy_input, unsigned char *personalization_string, int security_strength) {
+void randombytes_init_state(randombytes_state *state, unsigned char *entropy_input, unsigned char *personalization_string, int security_strength) {
     // to fit NIST rng
     (void) entropy_input;
     (void) personalization_string;
     (void) security_strength;
 
-    // Open /dev/urandom (if not already done)
-    while (urandom_r5_file_descriptor == -1) {
-        urandom_r5_file_descriptor = open("/dev/urandom", O_RDONLY);
-        if (urandom_r5_file_descriptor == -1) sleep(1); 
+    // Open /dev/urandom
+    state->fd = -1;
+    while (state->fd == -1) {
+        state->fd = open("/dev/urandom", O_RDONLY);
+        if (state->fd == -1) sleep(1);
     }
 }
 
-int randombytes(unsigned char *r, unsigned long long n) {
-    if (urandom_r5_file_descriptor == -1) {
-        randombytes_init(NULL, NULL, 0);
-    }
-
+int randombytes_with_state(randombytes_state *state, unsigned char *r, unsigned long long n) {
     /* Get the random bytes in chunks */
     ssize_t s;
     while (n > 0) {
-        s = read(urandom_r5_file_descriptor, r, (size_t) (n < MAX_URANDOM_BLOCK_SIZE ? n : MAX_URANDOM_BLOCK_SIZE));
+        s = read(state->fd, r, (size_t) (n < MAX_URANDOM_BLOCK_SIZE ? n : MAX_URANDOM_BLOCK_SIZE));
         if (s < 1) {
             sleep(1); /* Wait a bit before retrying */
         } else {
@@ -56,3 +52,25 @@ int randombytes(unsigned char *r, unsigned long long n) {
 
     return 0;
 }
+
+void randombytes_clear_state(randombytes_state *state) {
+    if (state->fd != -1) {
+        close(state->fd);
+        state->fd = -1;
+    }
+}
+
+void randombytes_init(unsigned char *entropy_input, unsigned char *personalization_string, int security_strength) {
+    // Open /dev/urandom (if not already done)
+    if (global_state.fd == -1) {
+        randombytes_init_state(&global_state, entropy_input, personalization_string, security_strength);
+    }
+}
+
+int randombytes(unsigned char *r, unsigned long long n) {
+    if (global_state.fd == -1) {
+        randombytes_init(NULL, NULL, 0);
+    }
+
+    return randombytes_with_state(&global_state, r, n);
+}
@@ -127,11 +127,11 @@ int r5_cca_kem_decapsulate(unsigned char *k, const unsigned char *ct, const unsi
     /* Append g': ct' = (U'^T,v',g') */
     memcpy(ct_prime + PARAMS_CT_SIZE, L_g_rho_prime + PARAMS_KAPPA_BYTES, PARAMS_KAPPA_BYTES);
 
-    /* k = H(L', ct') or k = H(y, ct') depending on fail status */
+    /* k = H(L', ct) or k = H(y, ct) depending on fail status (ct = ct' unless it fails) */
     uint8_t fail = (uint8_t) verify(ct, ct_prime, (size_t) (PARAMS_CT_SIZE + PARAMS_KAPPA_BYTES));
     conditional_constant_time_memcpy(L_g_rho_prime, y, PARAMS_KAPPA_BYTES, fail); /* Overwrite L' with y in case of failure */
 
-    HCCAKEM(k, PARAMS_KAPPA_BYTES, L_g_rho_prime, PARAMS_KAPPA_BYTES, ct_prime, (PARAMS_CT_SIZE + PARAMS_KAPPA_BYTES) Params);
+    HCCAKEM(k, PARAMS_KAPPA_BYTES, L_g_rho_prime, PARAMS_KAPPA_BYTES, ct, (PARAMS_CT_SIZE + PARAMS_KAPPA_BYTES) Params);
     
     free(m_prime);
     free(L_g_rho_prime);
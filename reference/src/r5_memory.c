@@ -37,7 +37,7 @@ int constant_time_memcmp(const void *s1, const void *s2, size_t n) {
 void conditional_constant_time_memcpy(void * restrict dst, const void * restrict src, size_t n, uint8_t flag) {
     uint8_t * d = dst;
     const uint8_t * s = src;
-    flag = (unsigned char) (-(flag | -flag) >> 7); // Force flag into 0x00 or 0xff
+    flag = (uint8_t) (-((flag | (uint8_t) -flag) >> 7)); // Force flag into 0x00 or 0xff
     size_t i;
 
     for (i = 0; i < n; ++i) {
@@ -0,0 +1,70 @@
+#!/bin/bash
+# Times the generation of the secrets S and R (bench_secretkeygen) of all
+# parameter sets in the constant-time configurations.
+#
+# With a git revision as argument, that revision is timed as well, side by
+# side, and the secrets of both are checked to be the same:
+#
+#   ./secretkeygen.sh HEAD~1
+
+CPASCHEMES="R5ND_1CPA_0d R5ND_3CPA_0d R5ND_5CPA_0d R5ND_1CPA_5d R5ND_3CPA_5d R5ND_5CPA_5d R5N1_1CPA_0d R5N1_3CPA_0d R5N1_5CPA_0d R5ND_0CPA_2iot R5ND_1CPA_4longkey"
+CCASCHEMES="R5ND_1CCA_0d R5ND_3CCA_0d R5ND_5CCA_0d R5ND_1CCA_5d R5ND_3CCA_5d R5ND_5CCA_5d R5N1_1CCA_0d R5N1_3CCA_0d R5N1_5CCA_0d R5N1_3CCA_0smallCT"
+
+SCHEMES="$CPASCHEMES $CCASCHEMES"
+
+CONFIGURATIONS="CM_CT CM_CT,AVX2"
+
+REP="1000"
+
+BASE=$1
+
+# move to parent dir
+currentdir="$(pwd)"
+parentdir="$(dirname "$(pwd)")"
+cd $parentdir
+
+TMPDIR=$(mktemp -d)
+
+if [ -n "$BASE" ]; then
+    git worktree add -q $TMPDIR/base $BASE || exit 1
+    # a revision from before the benchmark, times the same benchmark
+    if [ ! -f $TMPDIR/base/optimized/src/examples/bench_secretkeygen.c ]; then
+        cp optimized/src/examples/bench_secretkeygen.c $TMPDIR/base/optimized/src/examples/
+    fi
+fi
+
+# bench ROOT SCHEME CONF: prints the cycles of S and R, and the secrets hash
+bench() {
+    builddir=$TMPDIR/build
+    rm -rf $builddir
+    make -s -C $1/optimized builddir=$builddir ALG=$2 STANDALONE=1 TIMING=$REP $(echo $3 | sed 's/\([A-Z_0-9]*\)/\1=1/g; s/,/ /g') > /dev/null 2>&1 || { echo "- - -"; return; }
+    $builddir/bench_secretkeygen | awk '/^S:/ { s = $2 } /^R:/ { r = $2 } /^secrets:/ { h = $2 } END { print s, r, h }'
+}
+
+if [ -n "$BASE" ]; then
+    printf "%-20s %-12s %10s %10s %10s %10s %s\n" scheme configuration S R "S ($BASE)" "R ($BASE)" secrets
+else
+    printf "%-20s %-12s %10s %10s\n" scheme configuration S R
+fi
+
+for scheme in $SCHEMES
+do
+    for conf in $CONFIGURATIONS
+    do
+        set -- $(bench . $scheme $conf)
+        if [ -n "$BASE" ]; then
+            cycles_s=$1; cycles_r=$2; secrets=$3
+            set -- $(bench $TMPDIR/base $scheme $conf)
+            if [ "$secrets" = "$3" ]; then same=same; else same=DIFFERENT; fi
+            printf "%-20s %-12s %10s %10s %10s %10s %s\n" $scheme $conf $cycles_s $cycles_r $1 $2 $same
+        else
+            printf "%-20s %-12s %10s %10s\n" $scheme $conf $1 $2
+        fi
+    done
+done
+
+if [ -n "$BASE" ]; then
+    git worktree remove --force $TMPDIR/base
+fi
+rm -rf $TMPDIR
+cd $currentdir